@@ -27,25 +27,32 @@ struct Batch {
    * @param is_period_last_batch True if the input batch is the last one for the
    *        current T time units. False otherwise.
    * @param snapshot The snapshot of the field.
+   * @param is_half_last_batch True if the input batch is the last one of a
+   *        game half. False otherwise.
    */
   Batch(std::vector<PositionEvent> const &data, bool is_period_last_batch,
         std::unordered_map<std::string, Positions> const &snapshot,
-        std::chrono::picoseconds initial_ts, std::chrono::picoseconds final_ts)
+        std::chrono::picoseconds initial_ts, std::chrono::picoseconds final_ts,
+        bool is_half_last_batch = false)
       : data{std::addressof(data)}, is_period_last_batch{is_period_last_batch},
-        snapshot{snapshot}, initial_ts{initial_ts}, final_ts{final_ts} {}
+        is_half_last_batch{is_half_last_batch}, snapshot{snapshot},
+        initial_ts{initial_ts}, final_ts{final_ts} {}
   /**
    * Construct a new Batch.
    * @param data The input batch of PositionEvents
    * @param is_period_last_batch True if the input batch is the last one for the
    *        current T time units. False otherwise.
    * @param snapshot The snapshot of the field.
+   * @param is_half_last_batch True if the input batch is the last one of a
+   *        game half. False otherwise.
    */
   Batch(std::vector<PositionEvent> const &data, bool is_period_last_batch,
         std::unordered_map<std::string, Positions> &&snapshot,
-        std::chrono::picoseconds initial_ts, std::chrono::picoseconds final_ts)
+        std::chrono::picoseconds initial_ts, std::chrono::picoseconds final_ts,
+        bool is_half_last_batch = false)
       : data{std::addressof(data)}, is_period_last_batch{is_period_last_batch},
-        snapshot{std::move(snapshot)}, initial_ts{initial_ts}, final_ts{
-                                                                   final_ts} {}
+        is_half_last_batch{is_half_last_batch}, snapshot{std::move(snapshot)},
+        initial_ts{initial_ts}, final_ts{final_ts} {}
   /**
    * @return the time interval between first and last event in the batch
    */
@@ -61,6 +68,11 @@ struct Batch {
    * otherwise.
    */
   bool is_period_last_batch = false;
+  /**
+   * True if the input batch is the last one of a game half, i.e. the game
+   * break or the game end follows it. False otherwise.
+   */
+  bool is_half_last_batch = false;
   /**
    * The snapshot of the field.
    */
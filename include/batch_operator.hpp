@@ -0,0 +1,75 @@
+#ifndef SOCCER_MONITORING_BATCH_OPERATOR_HPP
+#define SOCCER_MONITORING_BATCH_OPERATOR_HPP
+
+#include "batch.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace game {
+/**
+ * An analytic computed over the batches of the stream, such as the ball
+ * possession of GameStatistics. Operators are fed by an OperatorPipeline, so
+ * that the stream is parsed once whatever the number of operators.
+ */
+class BatchOperator {
+public:
+  virtual ~BatchOperator() = default;
+  /**
+   * Computes a batch. Batches are computed in game order, and the batch is
+   * shared with the other operators: neither its data nor its snapshot may be
+   * modified.
+   *
+   * @param batch The Batch to compute
+   */
+  virtual void on_batch(Batch const &batch) = 0;
+  /**
+   * Called after on_batch() on the last batch of each base period, i.e. every
+   * base_time_units() seconds of the GameStatistics cutting the batches, and
+   * at the end of each game half.
+   *
+   * @param batch The last batch of the period
+   */
+  virtual void on_period_end(Batch const & /*batch*/) {}
+  /**
+   * Called once, after the last batch of the stream.
+   */
+  virtual void on_game_end() {}
+};
+
+/**
+ * Feeds every batch of the stream to several operators in a single pass. Each
+ * batch is computed by the operators in turn, in the order they are added, on
+ * the calling thread: operators share the parsed positions and parallelize
+ * their own computation, as GameStatistics does across players.
+ */
+class OperatorPipeline {
+public:
+  /**
+   * Registers an operator, computed after those already registered.
+   *
+   * @param op The operator, which must outlive the pipeline
+   */
+  void add(BatchOperator &op) { operators.push_back(&op); }
+  /**
+   * Computes a batch with every operator, then ends the period on every
+   * operator if the batch is the last one of its period.
+   *
+   * @param batch The Batch to compute
+   */
+  void on_batch(Batch const &batch);
+  /**
+   * Ends the game on every operator.
+   */
+  void on_game_end();
+  /**
+   * @return the number of registered operators.
+   */
+  std::size_t size() const { return operators.size(); }
+
+private:
+  std::vector<BatchOperator *> operators = {};
+};
+} // namespace game
+
+#endif // SOCCER_MONITORING_BATCH_OPERATOR_HPP
@@ -0,0 +1,91 @@
+#ifndef SOCCER_MONITORING_BATCH_SIZE_CONTROLLER_HPP
+#define SOCCER_MONITORING_BATCH_SIZE_CONTROLLER_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace game {
+/**
+ * A feedback controller choosing the size of the batches while the game is
+ * being monitored.
+ *
+ * After each batch the controller is told how long the batch took to be
+ * fetched and to be computed. Timings are gathered in windows of about
+ * window_batches batches of the current size. At the end of each window:
+ * - if a target latency is set, the batch size is scaled by the ratio between
+ *   the target and the measured mean per-event latency;
+ * - otherwise the batch size is moved by a factor step in the direction that
+ *   last improved the throughput, and the direction is reversed as soon as
+ *   throughput degrades.
+ *
+ * The controller never stops adjusting, so that it follows load changes.
+ */
+class BatchSizeController {
+public:
+  using seconds = std::chrono::duration<double>;
+
+  /// The batch size the controller starts from
+  static constexpr std::size_t initial_batch_size = 1500;
+  /// The smallest batch size the controller chooses
+  static constexpr std::size_t min_batch_size = 64;
+  /// The largest batch size the controller chooses
+  static constexpr std::size_t max_batch_size = 1 << 16;
+  /// The number of batches of the current size measured before adjusting
+  static constexpr std::size_t window_batches = 4;
+  /// The factor by which the batch size moves when climbing the throughput
+  static constexpr double step = 1.25;
+
+  /**
+   * Construct a new BatchSizeController.
+   *
+   * @param target_latency The mean per-event latency to meet. If zero, the
+   *        controller maximizes throughput instead.
+   * @param batch_size The batch size to start from.
+   */
+  explicit BatchSizeController(seconds target_latency = seconds{0},
+                               std::size_t batch_size = initial_batch_size);
+  /**
+   * Records the timings of a batch and adjusts the batch size if a window is
+   * complete.
+   *
+   * Events of a batch are assumed to arrive evenly while the batch is fetched,
+   * so the mean latency of its events is half the fetch time plus the compute
+   * time.
+   *
+   * @param nb_events The number of events in the batch.
+   * @param fetch_time The time spent fetching the batch.
+   * @param compute_time The time spent computing the batch statistics.
+   * @return the batch size to use for the following batches.
+   */
+  std::size_t observe(std::size_t nb_events, seconds fetch_time,
+                      seconds compute_time);
+  /**
+   * @return the batch size to use for the following batches.
+   */
+  std::size_t get_batch_size() const { return batch_size; }
+  /**
+   * @return the mean per-event latency measured over the last window.
+   */
+  seconds get_latency() const { return latency; }
+  /**
+   * @return the number of events processed per second over the last window.
+   */
+  double get_throughput() const { return throughput; }
+
+private:
+  seconds target_latency;
+  std::size_t batch_size;
+
+  std::size_t window_events = 0;
+  seconds window_time = seconds{0};
+  seconds window_latency = seconds{0};
+
+  seconds latency = seconds{0};
+  double throughput = 0;
+  double direction = step;
+
+  void adjust();
+};
+} // namespace game
+
+#endif // SOCCER_MONITORING_BATCH_SIZE_CONTROLLER_HPP
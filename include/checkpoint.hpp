@@ -0,0 +1,46 @@
+#ifndef SOCCER_MONITORING_CHECKPOINT_HPP
+#define SOCCER_MONITORING_CHECKPOINT_HPP
+
+#include "context.hpp"
+#include "event_fetcher.hpp"
+#include "game_statistics.hpp"
+
+#include <filesystem>
+
+namespace game {
+/**
+ * Writes a checkpoint of the monitoring state of a match: the Context
+ * positions, the EventFetcher state, including the number of bytes of the
+ * stream consumed, and the GameStatistics accumulators and partials, along
+ * with the state of its possession timeline, if any.
+ *
+ * The checkpoint is written to a temporary file renamed over @p path, so that
+ * a crash while writing leaves the previous checkpoint intact. To be called
+ * between two batches, e.g. once a period is over.
+ *
+ * @param path The checkpoint file path
+ * @param context The game::Context
+ * @param fetcher The game::EventFetcher
+ * @param stats The game::GameStatistics
+ * @throws std::runtime_error if the checkpoint cannot be written
+ */
+void save_checkpoint(std::filesystem::path const &path, Context const &context,
+                     EventFetcher const &fetcher, GameStatistics const &stats);
+/**
+ * Restores the monitoring state of a match from a checkpoint written by
+ * save_checkpoint(), and moves the fetcher stream to the first line not
+ * consumed at checkpoint time. The objects must be built from the same
+ * metadata and configurations as the checkpointed ones.
+ *
+ * @param path The checkpoint file path
+ * @param context The game::Context
+ * @param fetcher The game::EventFetcher
+ * @param stats The game::GameStatistics
+ * @throws std::runtime_error if the file is not a checkpoint, or was written
+ *         for other metadata or configurations
+ */
+void restore_checkpoint(std::filesystem::path const &path, Context &context,
+                        EventFetcher &fetcher, GameStatistics &stats);
+} // namespace game
+
+#endif // SOCCER_MONITORING_CHECKPOINT_HPP
@@ -6,6 +6,8 @@
 
 #include <filesystem>
 #include <functional>
+#include <istream>
+#include <ostream>
 #include <unordered_map>
 #include <vector>
 
@@ -122,7 +124,7 @@ public:
    * @param position the entity game::Position
    * @param sids the list of sensor ids attached to the entity
    */
-  void add_position(Positions const &position, std::vector<int> const &sids);
+  void add_position(Positions const &position, SensorIds sids);
   /**
    * @param sid the sensor id
    * @return the game::Position of the entity wearing the input sensor @p sid.
@@ -145,17 +147,41 @@ public:
   Positions const &get_ball_position() const {
     return positions[ball_position_idx];
   }
+  /**
+   * Set the instants splitting the match into halves.
+   * @param timeline the match timeline
+   */
+  void set_timeline(MatchTimeline const &timeline) {
+    this->timeline = timeline;
+  }
+  /**
+   * @return the instants splitting the match into halves
+   */
+  MatchTimeline const &get_timeline() const { return timeline; }
   /**
    * Takes a Snapshot of the Position of players and ball on the field. @see
    * game::Snapshot for details.
    * @return the Snapshot of the field
    */
   Snapshot take_snapshot() const;
+  /**
+   * Writes the positions of players and ball to a binary checkpoint.
+   * @param os the stream to write to
+   */
+  void save_positions(std::ostream &os) const;
+  /**
+   * Restores the positions of players and ball written by save_positions().
+   * @param is the stream to read from
+   * @throws std::runtime_error if the positions are not those of this
+   *         Context's metadata
+   */
+  void restore_positions(std::istream &is);
 
 private:
   PlayerMap players = {};
   TeamMap teams = {};
   BallMap balls = {};
+  MatchTimeline timeline = {};
 
   std::vector<Positions> positions = {};
   std::vector<Positions>::size_type ball_position_idx = {};
@@ -0,0 +1,85 @@
+#ifndef SOCCER_MONITORING_BINARY_IO_HPP
+#define SOCCER_MONITORING_BINARY_IO_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace game {
+namespace details {
+/**
+ * Writes the bytes of a trivially copyable value, in native byte order.
+ *
+ * @param os The stream to write to
+ * @param value The value
+ */
+template <typename T> void write_raw(std::ostream &os, T const &value) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Only trivially copyable values are written as raw bytes");
+  os.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+/**
+ * Reads the bytes of a trivially copyable value written by write_raw().
+ *
+ * @param is The stream to read from
+ * @param value The value read
+ * @throws std::runtime_error if the stream ends before the value
+ */
+template <typename T> void read_raw(std::istream &is, T &value) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Only trivially copyable values are read as raw bytes");
+  if (!is.read(reinterpret_cast<char *>(&value), sizeof(T))) {
+    throw std::runtime_error{"Unexpected end of binary data"};
+  }
+}
+/**
+ * Writes the size then the elements of a vector of trivially copyable values.
+ */
+template <typename T>
+void write_vector(std::ostream &os, std::vector<T> const &values) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Only trivially copyable values are written as raw bytes");
+  write_raw(os, static_cast<std::uint64_t>(values.size()));
+  os.write(reinterpret_cast<char const *>(values.data()),
+           values.size() * sizeof(T));
+}
+/**
+ * Reads a vector written by write_vector().
+ *
+ * @throws std::runtime_error if the stream ends before the vector
+ */
+template <typename T>
+void read_vector(std::istream &is, std::vector<T> &values) {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Only trivially copyable values are read as raw bytes");
+  auto size = std::uint64_t{};
+  read_raw(is, size);
+  values.resize(size);
+  if (!is.read(reinterpret_cast<char *>(values.data()), size * sizeof(T))) {
+    throw std::runtime_error{"Unexpected end of binary data"};
+  }
+}
+/**
+ * Writes the size then the characters of a string.
+ */
+inline void write_string(std::ostream &os, std::string const &value) {
+  write_vector(os, std::vector<char>(value.cbegin(), value.cend()));
+}
+/**
+ * Reads a string written by write_string().
+ *
+ * @throws std::runtime_error if the stream ends before the string
+ */
+inline void read_string(std::istream &is, std::string &value) {
+  auto chars = std::vector<char>{};
+  read_vector(is, chars);
+  value.assign(chars.cbegin(), chars.cend());
+}
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_BINARY_IO_HPP
@@ -0,0 +1,29 @@
+#ifndef SOCCER_MONITORING_CHILD_PROCESSES_HPP
+#define SOCCER_MONITORING_CHILD_PROCESSES_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace game {
+namespace details {
+/**
+ * Runs commands as concurrent child processes and collects the standard output
+ * of each one. Their standard error is the one of the calling process.
+ *
+ * @param commands The commands, program first. A program without a slash is
+ *        looked up in the PATH.
+ * @param on_exit Called on the calling thread once a process exited with
+ *        success, in the order they exit, with the index of its command and
+ *        the whole output of the process.
+ * @throws std::runtime_error if a process cannot be started or exits with
+ *         failure. Processes still running are then killed.
+ */
+void run_child_processes(
+    std::vector<std::vector<std::string>> const &commands,
+    std::function<void(std::size_t, std::string)> const &on_exit);
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_CHILD_PROCESSES_HPP
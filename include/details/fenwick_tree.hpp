@@ -0,0 +1,52 @@
+#ifndef SOCCER_MONITORING_FENWICK_TREE_HPP
+#define SOCCER_MONITORING_FENWICK_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace game {
+namespace details {
+/**
+ * A binary indexed tree of counts: adds to a count and sums a range of counts
+ * in O(log n) time.
+ */
+class FenwickTree {
+public:
+  FenwickTree() = default;
+  /**
+   * Construct a new FenwickTree of @p size counts, all 0.
+   */
+  explicit FenwickTree(std::size_t size) : nodes(size + 1, 0) {}
+  /**
+   * Adds @p value to the count at @p index.
+   */
+  void add(std::size_t index, std::int64_t value);
+  /**
+   * @return the sum of the counts before @p index.
+   */
+  std::int64_t prefix_sum(std::size_t index) const;
+  /**
+   * @return the sum of the counts from @p first to @p last, excluded.
+   */
+  std::int64_t range_sum(std::size_t first, std::size_t last) const {
+    return last > first ? prefix_sum(last) - prefix_sum(first) : 0;
+  }
+  /**
+   * @return the number of counts.
+   */
+  std::size_t size() const { return nodes.empty() ? 0 : nodes.size() - 1; }
+  /**
+   * @return the tree nodes, node i + 1 summing the counts of the range ending
+   *         at index i whose length is the lowest set bit of i + 1.
+   */
+  std::vector<std::int64_t> &get_nodes() { return nodes; }
+  std::vector<std::int64_t> const &get_nodes() const { return nodes; }
+
+private:
+  std::vector<std::int64_t> nodes = {};
+};
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_FENWICK_TREE_HPP
@@ -1,41 +1,64 @@
 #ifndef SOCCER_MONITORING_GAME_STATISTICS_IMPL_HPP
 #define SOCCER_MONITORING_GAME_STATISTICS_IMPL_HPP
 
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "position.hpp"
+#include "scratch_arena.hpp"
 
 namespace game {
 namespace details {
 
+/**
+ * The positions a player and the ball have in a player's scan of a batch. They
+ * are carried over from one tile of the batch to the next. Tracks are written
+ * by the thread scanning the player, hence aligned to a cache line so that
+ * threads never write the same line.
+ */
+struct alignas(64) PlayerTrack {
+  Positions player;
+  Positions ball;
+};
+
 /**
  * The distances vector for a player. Creates a mapping between a player and its
- * distances from the ball.
+ * distances from the ball. Distances are stored in an external scratch buffer,
+ * e.g. one handed out by a details::ScratchArena, which must be large enough to
+ * hold one distance per ball event of the batch.
  */
 class DistanceResults {
 public:
-  explicit DistanceResults(std::string player)
-      : player_name{std::move(player)} {}
+  using size_type = std::size_t;
+  using iterator = double *;
+  using const_iterator = double const *;
 
-  void push_back(double distance) { distances.push_back(distance); }
-  std::string const &get_player_name() const { return player_name; }
+  /**
+   * @param player The index of the player in GameStatistics' player list
+   * @param storage The buffer distances are written to
+   */
+  DistanceResults(std::size_t player, double *storage)
+      : player{player}, distances{storage} {}
 
-  using size_type = typename std::vector<double>::size_type;
-  using iterator = typename std::vector<double>::iterator;
-  using const_iterator = typename std::vector<double>::const_iterator;
+  void push_back(double distance) { distances[count++] = distance; }
+  std::size_t get_player() const { return player; }
 
   double const &operator[](size_type index) const { return distances[index]; }
 
-  iterator begin() { return distances.begin(); }
-  const_iterator cbegin() const { return distances.cbegin(); }
+  iterator begin() { return distances; }
+  const_iterator cbegin() const { return distances; }
 
-  iterator end() { return distances.end(); }
-  const_iterator cend() const { return distances.cend(); }
+  iterator end() { return distances + count; }
+  const_iterator cend() const { return distances + count; }
 
-  size_type size() const { return distances.size(); }
+  size_type size() const { return count; }
 
 private:
-  std::string player_name;
-  std::vector<double> distances = {};
+  std::size_t player;
+  double *distances;
+  size_type count = 0;
 };
 
 // ==-----------------------------------------------------------------------==
@@ -43,6 +66,10 @@ private:
 // ==-----------------------------------------------------------------------==
 template <bool IsConst> class ball_possession_iterator; // Forward-declared
 
+/**
+ * The closest player to the ball, and its distance, for each ball event of a
+ * batch. Players are identified by their index in GameStatistics' player list.
+ */
 class BallPossession {
   friend class details::ball_possession_iterator<true>;
   friend class details::ball_possession_iterator<false>;
@@ -52,9 +79,21 @@ public:
   using iterator = details::ball_possession_iterator<false>;
 
   static constexpr auto infinite_distance = std::numeric_limits<double>::max();
-  static const std::string none_player;
+  static constexpr auto none_player = std::numeric_limits<std::size_t>::max();
+
+  /**
+   * Construct a BallPossession whose data lives in @p arena.
+   *
+   * @param arena The arena to allocate the per-event data from
+   * @param capacity The maximum number of ball events to track
+   */
+  BallPossession(ScratchArena &arena, std::size_t capacity)
+      : closest_players{arena.allocate<std::size_t>(capacity)},
+        min_distances{arena.allocate<double>(capacity)} {}
 
   void reduce(details::DistanceResults const &distance);
+  /// Forget the reduced distances, keeping the storage for the next tile
+  void clear();
 
   iterator begin();
   const_iterator begin() const;
@@ -64,8 +103,10 @@ public:
   const_iterator cend() const;
 
 private:
-  std::vector<std::string> closest_players = {};
-  std::vector<double> min_distances = {};
+  std::size_t *closest_players;
+  double *min_distances;
+  std::size_t size = 0;
+  bool is_reduced = false;
 };
 
 // ==-----------------------------------------------------------------------==
@@ -74,7 +115,7 @@ private:
 template <bool IsConst> class ball_possession_iterator {
 public:
   using difference_type = std::ptrdiff_t;
-  using value_type = std::pair<double, std::string>;
+  using value_type = std::pair<double, std::size_t>;
   using reference = std::conditional_t<IsConst, const value_type, value_type> &;
   using pointer = std::add_pointer_t<reference>;
   using iterator_category = std::input_iterator_tag;
@@ -84,11 +125,11 @@ public:
   ball_possession_iterator(BallPossession const &ballPossession,
                            std::size_t index = 0)
       : bp{ballPossession}, index{index} {
-    if (index < bp.min_distances.size()) {
+    if (index < bp.size) {
       current_value =
           std::make_pair(bp.min_distances[index], bp.closest_players[index]);
     } else {
-      current_value = std::make_pair(-1, "iterator_end");
+      current_value = std::make_pair(-1, BallPossession::none_player);
     }
   }
 
@@ -97,11 +138,11 @@ public:
 
   iterator &operator++() {
     ++index;
-    if (index < bp.min_distances.size()) {
+    if (index < bp.size) {
       current_value =
           std::make_pair(bp.min_distances[index], bp.closest_players[index]);
     } else {
-      current_value = std::make_pair(-1, "iterator_end");
+      current_value = std::make_pair(-1, BallPossession::none_player);
     }
     return *this;
   }
@@ -135,7 +176,7 @@ public:
 private:
   BallPossession const &bp;
   std::size_t index;
-  std::pair<double, std::string> current_value;
+  std::pair<double, std::size_t> current_value;
 };
 } // namespace details
 } // namespace game
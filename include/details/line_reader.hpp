@@ -0,0 +1,85 @@
+#ifndef SOCCER_MONITORING_LINE_READER_HPP
+#define SOCCER_MONITORING_LINE_READER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace game {
+namespace details {
+/**
+ * Reads the lines of a stream on a background thread, so that they can be
+ * waited for with a deadline. Lines are buffered in a bounded queue.
+ */
+class LineReader {
+public:
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * Enumerates the outcomes of a read.
+   */
+  enum class Status {
+    line,    ///< A line was read
+    timeout, ///< No line is available yet and the deadline passed
+    eof      ///< The stream reached EOF and every line was read
+  };
+
+  /**
+   * The maximum number of lines read ahead.
+   */
+  static constexpr std::size_t capacity = 1 << 16;
+
+  /**
+   * A hook called on the thread creating the reader with the background
+   * thread it starts, e.g. to bind it to CPUs.
+   */
+  using StartHook = std::function<void(std::thread &thread)>;
+
+  /**
+   * Starts reading @p is on a background thread.
+   * @param is The stream to read.
+   * @param on_start The hook called with the background thread, if any. If it
+   *        throws, the thread is stopped and the exception is rethrown.
+   */
+  explicit LineReader(std::unique_ptr<std::istream> is,
+                      StartHook const &on_start = {});
+  /**
+   * Stops and joins the background thread. The thread may only stop once a
+   * read on the stream returns.
+   */
+  ~LineReader();
+  LineReader(LineReader const &) = delete;
+  LineReader &operator=(LineReader const &) = delete;
+  /**
+   * Takes the next line of the stream, waiting for it until @p deadline.
+   *
+   * @param line The line read, if any.
+   * @param deadline The time point after which to stop waiting.
+   * @return the outcome of the read.
+   */
+  Status read_line(std::string &line, clock::time_point deadline);
+
+private:
+  std::unique_ptr<std::istream> is;
+  std::deque<std::string> lines = {};
+  bool is_eof = false;
+  bool is_stopping = false;
+  std::mutex mutex = {};
+  std::condition_variable line_ready = {};
+  std::condition_variable space_ready = {};
+  std::thread reader;
+
+  void stop();
+  void read_all();
+};
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_LINE_READER_HPP
@@ -0,0 +1,70 @@
+#ifndef SOCCER_MONITORING_MAPPED_FILE_HPP
+#define SOCCER_MONITORING_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+
+namespace game {
+namespace details {
+/**
+ * A file mapped in memory, shared with the other processes mapping it.
+ */
+class MappedFile {
+public:
+  /**
+   * Enumerates the ways a file is mapped.
+   */
+  enum class Mode {
+    read,   ///< Maps an existing file, read-only
+    create, ///< Creates or truncates the file, mapped read-write
+    update  ///< Maps an existing file, read-write
+  };
+
+  /**
+   * Opens and maps a file.
+   *
+   * @param path The file path
+   * @param mode How the file is opened and mapped
+   * @param size In create mode, the initial size of the file. Ignored in the
+   *        other modes, where the whole file is mapped.
+   * @throws std::runtime_error if the file cannot be opened or mapped
+   */
+  MappedFile(std::filesystem::path const &path, Mode mode,
+             std::size_t size = 0);
+  /**
+   * Unmaps and closes the file.
+   */
+  ~MappedFile();
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+  /**
+   * Resizes a file mapped read-write and maps it again. Pointers to the
+   * previous mapping are invalidated.
+   *
+   * @param size The new size of the file
+   * @throws std::runtime_error if the file cannot be resized or mapped
+   */
+  void resize(std::size_t size);
+  /**
+   * @return the first byte of the mapping, or nullptr if the file is empty.
+   */
+  std::byte *data() const { return bytes; }
+  /**
+   * @return the number of bytes mapped, i.e. the file size.
+   */
+  std::size_t size() const { return nb_bytes; }
+
+private:
+  std::filesystem::path path;
+  int fd = -1;
+  Mode mode;
+  std::byte *bytes = nullptr;
+  std::size_t nb_bytes = 0;
+
+  void map();
+  void unmap();
+};
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_MAPPED_FILE_HPP
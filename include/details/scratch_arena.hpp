@@ -0,0 +1,74 @@
+#ifndef SOCCER_MONITORING_SCRATCH_ARENA_HPP
+#define SOCCER_MONITORING_SCRATCH_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace game {
+namespace details {
+/**
+ * A bump allocator for the scratch data of a batch computation.
+ *
+ * Buffers handed out by allocate() stay valid until the next reset(). On
+ * reset() the memory is not released: the arena keeps a single block as large
+ * as the total amount of memory requested since the previous reset, so that a
+ * batch of the same size as the previous one is served without touching the
+ * heap.
+ */
+class alignas(64) ScratchArena {
+public:
+  /**
+   * Hands out an uninitialized buffer of @p n elements of type @p T.
+   *
+   * @tparam T The element type. Must be trivially destructible, since the
+   *         arena never runs destructors.
+   * @param n The number of elements.
+   * @return a pointer to the first element of the buffer.
+   */
+  template <typename T> T *allocate(std::size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "ScratchArena never runs destructors");
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "ScratchArena blocks are aligned to std::max_align_t");
+
+    auto bytes = n * sizeof(T);
+    offset = (offset + alignof(T) - 1) / alignof(T) * alignof(T);
+    if (offset + bytes > capacity) {
+      grow(bytes);
+    }
+
+    auto *p = reinterpret_cast<T *>(block.get() + offset);
+    offset += bytes;
+    // Upper bound of the space taken in a single block, alignment included
+    used += bytes + alignof(std::max_align_t);
+    return p;
+  }
+  /**
+   * Invalidate every buffer handed out so far. If the current block was too
+   * small to serve the requests since the previous reset, it is replaced by a
+   * single block large enough to serve them all.
+   */
+  void reset();
+  /**
+   * @return the number of heap allocations performed by this arena so far.
+   *         In steady state, i.e. once a batch as large as the largest one has
+   *         been served, this value no longer changes.
+   */
+  std::size_t nb_allocations() const { return allocations; }
+
+private:
+  std::unique_ptr<std::byte[]> block = {};
+  std::vector<std::unique_ptr<std::byte[]>> retired = {};
+  std::size_t capacity = 0;
+  std::size_t offset = 0;
+  std::size_t used = 0;
+  std::size_t allocations = 0;
+
+  void grow(std::size_t bytes);
+};
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_SCRATCH_ARENA_HPP
@@ -0,0 +1,82 @@
+#ifndef SOCCER_MONITORING_SLIDING_WINDOWS_HPP
+#define SOCCER_MONITORING_SLIDING_WINDOWS_HPP
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace game {
+namespace details {
+/**
+ * Sums of counters over the last slots of a stream, for several window
+ * lengths at once.
+ *
+ * The counters of each slot are kept in a ring buffer as long as the longest
+ * window. Each window keeps the running sums of its slots: pushing a slot adds
+ * its counters to every window and takes off those of the slot each window
+ * slides past, in O(#windows * width) time whatever the window lengths.
+ */
+class SlidingWindows {
+public:
+  SlidingWindows() = default;
+  /**
+   * Construct a new SlidingWindows object with empty windows.
+   *
+   * @param lengths The length of each window, in slots. Must be greater
+   *        than 0.
+   * @param width The number of counters of a slot
+   */
+  SlidingWindows(std::vector<std::size_t> lengths, std::size_t width);
+  /**
+   * Slides every window by one slot.
+   *
+   * @param counts The width counters of the new slot
+   */
+  void push(int const *counts);
+  /**
+   * Empties every window.
+   */
+  void clear();
+  /**
+   * @param window The index of the window
+   * @return the width sums of the counters of the last slots of the window.
+   */
+  int const *get_sums(std::size_t window) const {
+    return sums.data() + window * width;
+  }
+  /**
+   * @return the number of windows.
+   */
+  std::size_t size() const { return lengths.size(); }
+  /**
+   * Writes the ring buffer and the window sums, to be restored by restore().
+   *
+   * @param os The stream to write to
+   */
+  void save(std::ostream &os) const;
+  /**
+   * Restores the windows written by save() for the same lengths and width.
+   *
+   * @param is The stream to read from
+   * @throws std::runtime_error if the saved windows do not fit this object
+   */
+  void restore(std::istream &is);
+
+private:
+  std::vector<std::size_t> lengths = {};
+  std::size_t width = 0;
+  std::size_t capacity = 0;
+  /// Counters of the last slots, indexed by [slot][counter]
+  std::vector<int> ring = {};
+  /// The ring slot the next pushed slot is written to
+  std::size_t head = 0;
+  /// The number of slots in the ring
+  std::size_t nb_slots = 0;
+  /// Sums of each window, indexed by [window][counter]
+  std::vector<int> sums = {};
+};
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_SLIDING_WINDOWS_HPP
@@ -0,0 +1,84 @@
+#ifndef SOCCER_MONITORING_UNIFORM_GRID_HPP
+#define SOCCER_MONITORING_UNIFORM_GRID_HPP
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace game {
+namespace details {
+/**
+ * A uniform grid hashing items by their (x, y) position over the field.
+ *
+ * Cells are squares of a given size laid over the field extents of event.hpp;
+ * positions outside of the field fall in the border cells. Items whose
+ * position is not finite are in no cell.
+ *
+ * Items of the 3x3 cells around a point include every item within the cell
+ * size of that point, and items of any other cell are farther than the cell
+ * size from it.
+ */
+class UniformGrid {
+public:
+  /**
+   * Constructs a grid of @p nb_items items, initially in no cell.
+   *
+   * @param cell_size The side of the cells, in millimeters. Must be positive.
+   * @param nb_items The number of items, identified by their index.
+   */
+  UniformGrid(double cell_size, std::size_t nb_items);
+  /**
+   * Moves an item to the cell of its new position.
+   *
+   * @param item The index of the item.
+   * @param x The x coordinate of the item, in millimeters.
+   * @param y The y coordinate of the item, in millimeters.
+   */
+  void update(std::size_t item, double x, double y);
+  /**
+   * Calls @p f with the index of every item of the 3x3 cells around (x, y),
+   * in no particular order. Nothing is called if (x, y) is not finite.
+   *
+   * @param x The x coordinate of the point, in millimeters.
+   * @param y The y coordinate of the point, in millimeters.
+   * @param f The function to call with each item index.
+   */
+  template <typename F> void for_each_near(double x, double y, F &&f) const {
+    auto cell = cell_of(x, y);
+    if (cell == no_cell) {
+      return;
+    }
+    auto cx = cell % nb_columns;
+    auto cy = cell / nb_columns;
+    auto x_begin = cx > 0 ? cx - 1 : cx;
+    auto x_end = cx + 1 < nb_columns ? cx + 2 : cx + 1;
+    auto y_begin = cy > 0 ? cy - 1 : cy;
+    auto y_end = cy + 1 < nb_rows ? cy + 2 : cy + 1;
+    for (auto j = y_begin; j < y_end; ++j) {
+      for (auto i = x_begin; i < x_end; ++i) {
+        for (auto item : cells[j * nb_columns + i]) {
+          f(item);
+        }
+      }
+    }
+  }
+  /**
+   * @return the side of the cells, in millimeters.
+   */
+  double get_cell_size() const { return cell_size; }
+
+private:
+  static constexpr auto no_cell = std::numeric_limits<std::size_t>::max();
+
+  double cell_size;
+  std::size_t nb_columns;
+  std::size_t nb_rows;
+  std::vector<std::vector<std::size_t>> cells = {};
+  std::vector<std::size_t> item_cells = {};
+
+  std::size_t cell_of(double x, double y) const;
+};
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_UNIFORM_GRID_HPP
@@ -0,0 +1,141 @@
+#ifndef SOCCER_MONITORING_WORK_STEALING_POOL_HPP
+#define SOCCER_MONITORING_WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace game {
+namespace details {
+/**
+ * A pool of worker threads running tasks out of work-stealing deques.
+ *
+ * Workers live as long as the pool and sleep while there is no task to run.
+ * Each worker runs the tasks of its own deque last-in first-out; once it is
+ * empty, the worker steals the oldest task of another worker. Workers finding
+ * no task to run nor to steal sleep until a task is pushed.
+ *
+ * Tasks are plain indices given meaning by the body passed to run(). A task
+ * may push follow-up tasks to its worker's deque, e.g. the next tile of the
+ * same player, which then run on the same worker unless they are stolen.
+ * Several threads may call run() at once, e.g. one per match monitored: their
+ * tasks then share the workers.
+ */
+class WorkStealingPool {
+public:
+  /**
+   * The body of the tasks, called with the task index and the index of the
+   * worker running it.
+   */
+  using Body = std::function<void(std::size_t task, std::size_t worker)>;
+  /**
+   * A hook called on the thread creating the pool with each worker thread it
+   * starts and its index, e.g. to bind it to a CPU.
+   */
+  using StartHook =
+      std::function<void(std::thread &thread, std::size_t worker)>;
+
+  /**
+   * Starts a pool of @p nb_workers worker threads.
+   * @param nb_workers The number of workers. Must be greater than 0.
+   * @param on_start The hook called with each worker thread started, if any.
+   *        If it throws, the workers are stopped and the exception is
+   *        rethrown.
+   */
+  explicit WorkStealingPool(std::size_t nb_workers,
+                            StartHook const &on_start = {});
+  /**
+   * Stops and joins the workers.
+   */
+  ~WorkStealingPool();
+  WorkStealingPool(WorkStealingPool const &) = delete;
+  WorkStealingPool &operator=(WorkStealingPool const &) = delete;
+  /**
+   * Runs @p nb_tasks tasks on the workers and returns once all of them are
+   * done. The calling thread sleeps meanwhile.
+   *
+   * @param initial The tasks to start from, dealt round-robin to the workers.
+   * @param nb_tasks The number of tasks to run: the initial ones plus the ones
+   *        they push.
+   * @param body The body of the tasks.
+   */
+  void run(std::vector<std::size_t> const &initial, std::size_t nb_tasks,
+           Body const &body);
+  /**
+   * Pushes a task of the running body to the deque of a worker. To be called
+   * from a task body.
+   *
+   * @param worker The index of the worker running the calling task.
+   * @param task The task index.
+   */
+  void push(std::size_t worker, std::size_t task);
+  /**
+   * @return the number of workers.
+   */
+  std::size_t nb_workers() const { return workers.size(); }
+  /**
+   * @return the number of tasks taken from another worker's deque so far.
+   */
+  std::size_t nb_steals() const;
+  /**
+   * @return the time workers spent looking for a task while run() was called
+   *         so far, summed over the workers.
+   */
+  std::chrono::nanoseconds idle_time() const;
+
+private:
+  /// The tasks of a call to run()
+  struct Job {
+    Body const *body;
+    std::atomic<std::size_t> remaining;
+  };
+  struct Task {
+    Job *job;
+    std::size_t index;
+  };
+  struct alignas(64) Worker {
+    std::mutex mutex = {};
+    std::deque<Task> tasks = {};
+    /// The job of the task being run, which the tasks pushed belong to
+    Job *job = nullptr;
+    std::atomic<std::size_t> steals = 0;
+    std::atomic<std::chrono::nanoseconds::rep> idle = 0;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers = {};
+  std::vector<std::thread> threads = {};
+
+  /// Guards the fields below but the atomic ones
+  std::mutex mutex = {};
+  /// Notified when a task is pushed to sleeping workers, when the last job is
+  /// done or when the pool stops
+  std::condition_variable task_ready = {};
+  /// Notified when the last task of a job is done
+  std::condition_variable job_done = {};
+  bool is_stopping = false;
+  /// Number of calls to run() in progress
+  std::size_t nb_jobs = 0;
+  /// Number of tasks in the deques
+  std::atomic<std::size_t> nb_queued = 0;
+  /// Number of workers sleeping until a task is ready
+  std::atomic<std::size_t> nb_sleeping = 0;
+  /// The worker the next job deals its first task to
+  std::atomic<std::size_t> next_worker = 0;
+
+  void stop();
+  void thread_main(std::size_t worker);
+  void sleep(Worker &worker);
+  bool pop(std::size_t worker, Task &task);
+  bool steal(std::size_t worker, Task &task);
+};
+} // namespace details
+} // namespace game
+
+#endif // SOCCER_MONITORING_WORK_STEALING_POOL_HPP
@@ -40,6 +40,24 @@ constexpr auto break_end = std::chrono::picoseconds{13086639146403495};
  * @brief The instant of game end (in picoseconds).
  */
 constexpr auto game_end = std::chrono::picoseconds{14879639146403495};
+/**
+ * @brief The instants splitting a match into halves. Each match monitored by
+ * the process has its own, set in its Context.
+ */
+struct MatchTimeline {
+  /// The declared duration of a game half
+  std::chrono::picoseconds half_duration = expected_half_duration;
+  /// The instant of game start
+  std::chrono::picoseconds game_start = game::game_start;
+  /// The instant of first half end
+  std::chrono::picoseconds break_start = game::break_start;
+  /// The declared instant of first half end
+  std::chrono::picoseconds official_break_start = game::official_break_start;
+  /// The instant of second half start
+  std::chrono::picoseconds break_end = game::break_end;
+  /// The instant of game end
+  std::chrono::picoseconds game_end = game::game_end;
+};
 /**
  * The field lower x coordinate
  */
@@ -65,6 +83,8 @@ public:
   explicit InterruptionEvent(std::chrono::picoseconds timestamp)
       : timestamp{timestamp} {}
 
+  std::chrono::picoseconds get_timestamp() const { return timestamp; }
+
 private:
   std::chrono::picoseconds timestamp;
 };
@@ -77,19 +97,22 @@ public:
   explicit ResumeEvent(std::chrono::picoseconds timestamp)
       : timestamp{timestamp} {}
 
+  std::chrono::picoseconds get_timestamp() const { return timestamp; }
+
 private:
   std::chrono::picoseconds timestamp;
 };
 
 /**
- * @brief A new position event for a sensor.
+ * @brief A new position event for a sensor, along with the sensor speed if it
+ * is parsed.
  */
 class PositionEvent {
 public:
   PositionEvent() = default;
   PositionEvent(int sensor_id, std::chrono::picoseconds timestamp, int x, int y,
-                int z)
-      : sid{sensor_id}, timestamp{timestamp}, x{x}, y{y}, z{z} {}
+                int z, int speed = 0)
+      : sid{sensor_id}, timestamp{timestamp}, x{x}, y{y}, z{z}, speed{speed} {}
 
   int get_sid() const { return sid; }
   std::chrono::picoseconds get_timestamp() const { return timestamp; }
@@ -97,6 +120,8 @@ public:
   int get_y() const { return y; }
   int get_z() const { return z; }
   std::tuple<int, int, int> get_vector() const { return {x, y, z}; }
+  /// @return the sensor speed, in micrometers per second
+  int get_speed() const { return speed; }
 
   friend std::ostream &operator<<(std::ostream &, PositionEvent const &);
 
@@ -106,6 +131,7 @@ private:
   int x;
   int y;
   int z;
+  int speed;
 };
 } // namespace game
 
@@ -4,13 +4,18 @@
 #include "batch.hpp"
 #include "context.hpp"
 #include "details/event_fetcher_impl.hpp"
+#include "details/line_reader.hpp"
 #include "event.hpp"
+#include "event_store.hpp"
 #include "stream_types.hpp"
 
+#include <chrono>
+#include <cstdint>
 #include <exception>
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <regex>
 #include <sstream>
 #include <string_view>
@@ -22,6 +27,41 @@
 #include "fmt/format.h"
 
 namespace game {
+/**
+ * @brief A PositionEvent along with what it means to the game, for per-event
+ * processing of the stream.
+ */
+struct StreamEvent {
+  /**
+   * The position event.
+   */
+  PositionEvent event;
+  /**
+   * True if the event updates the position of its sensor. In-game events of a
+   * paused game are dropped, as parse_batch() does. False otherwise.
+   */
+  bool is_position_update = true;
+  /**
+   * True if the event happens during the game and while the game is not paused,
+   * i.e. it counts for ball possession. False otherwise.
+   */
+  bool is_in_play = false;
+  /**
+   * True if a period is over right before this event. False otherwise.
+   */
+  bool is_period_over = false;
+  /**
+   * True if a game half is over right before this event. A period is then over
+   * as well. False otherwise.
+   */
+  bool is_half_over = false;
+  /**
+   * If a period is over, the timestamp of its last event, as the final_ts of
+   * the Batch closing it.
+   */
+  std::chrono::picoseconds period_final_ts = {};
+};
+
 /**
  * @brief Class to consume the streaming game events.
  * Initialized with the dataset source and the batch size it returns a batch of
@@ -43,6 +83,32 @@ public:
   template <typename Stream>
   EventFetcher(std::string const &, Stream, int time_units,
                std::size_t batch_size, Context &context);
+  /**
+   * @brief Construct a new EventFetcher object replaying the events of an
+   * EventStore instead of parsing a stream.
+   *
+   * @param store The events to replay. It must outlive this object.
+   * @param batch_size The size of the batch of parsed PositionEvent.
+   */
+  EventFetcher(EventStore const &store, int time_units, std::size_t batch_size,
+               Context &context);
+  /**
+   * @brief Stores the events parsed from the stream from now on, i.e. the game
+   * interruptions and resumes and the positions of the players and balls, so
+   * that they can be replayed without parsing the stream again.
+   *
+   * @param store The store the events are appended to, which must outlive
+   *        this object, or nullptr to store none.
+   */
+  void set_event_store(EventStore *store) { recorded_store = store; }
+  /**
+   * @brief Parses the sensor speed of the position events as well, for the
+   * running analysis. Speeds are not kept by an EventStore: events replayed
+   * from it have a speed of 0.
+   *
+   * @param is_parsed Whether speeds are parsed
+   */
+  void set_speed_parsing(bool is_parsed) { is_speed_parsed = is_parsed; }
   /**
    * @brief Parses next in-game PositionEvent. If next event is an
    * InterruptionEvent, PositionEvents are skipped until a ResumEvent is found.
@@ -61,6 +127,98 @@ public:
    * @return the batch of PositionEvent.
    */
   Batch parse_batch();
+  /**
+   * @brief Parses next PositionEvent for per-event processing, i.e. without
+   * gathering events into batches. Periods and halves are over, and events
+   * dropped, according to the same rules as parse_batch() with an unbounded
+   * batch size. Neither the context positions nor snapshots are updated.
+   *
+   * @return the next PositionEvent and its meaning to the game, or an empty
+   *         optional if the stream reached EOF.
+   */
+  std::optional<StreamEvent> parse_stream_event();
+  /**
+   * @return once parse_stream_event() reached EOF, the timestamp of the last
+   *         event of the last period, as the final_ts of the last Batch.
+   */
+  std::chrono::picoseconds get_stream_final_ts() const {
+    return pending_final_ts.value_or(last_in_game_ts);
+  }
+  /**
+   * @brief Sets the size of the following batches. The batch being filled, if
+   * any, is completed with the new size.
+   *
+   * @param batch_size The maximum number of PositionEvents of a batch.
+   */
+  void set_batch_size(std::size_t batch_size);
+  /**
+   * @return the maximum number of PositionEvents of a batch.
+   */
+  std::size_t get_batch_size() const { return batch_size; }
+  /**
+   * @brief Lets parse_batch() close a period when the stream stalls.
+   *
+   * The stream is then read on a background thread. Event time is assumed to
+   * advance as wall-clock time since the last event was read: if no event
+   * arrives by @p delay after the current period end, the period is closed by
+   * a batch of the events read so far. Periods are only closed this way within
+   * a game half. Events arriving later for a closed period are accounted in
+   * the current one.
+   *
+   * Periods are not closed by timer in parse_stream_event(), nor when events
+   * are replayed from an EventStore, which never stalls.
+   *
+   * @param delay The maximum delay between the end of a period and the batch
+   *        closing it. Must be greater than 0.
+   * @param on_reader_start The hook called with the background thread once
+   *        started, if any, e.g. to bind it to CPUs
+   */
+  void set_emission_delay(
+      std::chrono::milliseconds delay,
+      details::LineReader::StartHook const &on_reader_start = {});
+  /**
+   * @return true once the stream reached EOF, i.e. the last batch was parsed.
+   */
+  bool is_game_over() const { return game_over; }
+  /**
+   * Writes the parsing state to a binary checkpoint: game pause, period start,
+   * deferred events, snapshot and the number of bytes of the stream consumed.
+   * To be called between two batches.
+   *
+   * @param os The stream to write to
+   */
+  void save(std::ostream &os) const;
+  /**
+   * Restores the parsing state written by save() and moves the stream to the
+   * first line not consumed at that time. Must be called before
+   * set_emission_delay().
+   *
+   * @param is The stream to read from
+   * @throws std::runtime_error if the state cannot be read or the stream
+   *         cannot be moved
+   * @throws std::logic_error if events are replayed from an EventStore
+   */
+  void restore(std::istream &is);
+  /**
+   * Moves the stream to byte @p offset, the start of a line, and resets the
+   * parsing state to the one of the lines before, as far as no events are
+   * deferred to the next batch. Context positions are left as they are: they
+   * are set by the lines parsed from there. Must be called before
+   * set_emission_delay().
+   *
+   * @param offset The byte of the stream to parse from
+   * @param period_start The current period start at that line
+   * @param is_paused Whether the game is paused at that line
+   * @throws std::runtime_error if the stream cannot be moved
+   * @throws std::logic_error if events are replayed from an EventStore
+   */
+  void seek(std::uint64_t offset, std::chrono::picoseconds period_start,
+            bool is_paused);
+  /**
+   * @return the start of the current period, i.e. of the period the next
+   *         in-game events fall in.
+   */
+  std::chrono::picoseconds get_period_start() const { return period_start; }
   /**
    * Tests whether an event is valid to be added to a batch, i.e. its timestamp
    * is within the first half or the second half of the game.
@@ -96,14 +254,35 @@ private:
   Snapshot snapshot;
   int time_units = 0;
   std::chrono::picoseconds period_start;
-  std::chrono::picoseconds last_in_game_ts = game_start;
+  std::chrono::picoseconds last_in_game_ts =
+      context.get_timeline().game_start;
   std::size_t batch_size = 0;
+  /// Timestamp of the last in-play event since the stream was last cut, in
+  /// per-event processing
+  std::optional<std::chrono::picoseconds> pending_final_ts = {};
+  /// The background reader of the stream, if periods may be closed by timer
+  std::unique_ptr<details::LineReader> reader = {};
+  std::chrono::milliseconds emission_delay = {};
+  bool is_timer_enabled = true;
+  bool is_timed_out = false;
+  bool has_position_event = false;
+  std::chrono::picoseconds last_event_ts = {};
+  details::LineReader::clock::time_point last_event_time = {};
+  /// Number of bytes of the stream consumed by the lines read so far
+  std::uint64_t consumed_bytes = 0;
+  /// The store events are replayed from instead of the stream, if any
+  std::optional<EventStore::Reader> store_reader = {};
+  EventStore *recorded_store = nullptr;
+  bool is_speed_parsed = false;
 
   bool is_period_over(PositionEvent const &event);
   Batch batch_period_over(PositionEvent const &event);
   Batch batch_game_paused(PositionEvent const &event);
   Batch batch_game_break(PositionEvent const &event);
   Batch batch_game_over();
+  Batch batch_period_timeout();
+  bool read_line(std::string &line);
+  std::optional<std::chrono::picoseconds> timed_period_end() const;
   Batch batch_full_size();
   void add_event_to_batch(PositionEvent const &event);
   void update_sensor_position(PositionEvent const &event);
@@ -168,6 +347,7 @@ struct Dataset {
   static constexpr std::size_t se_x_idx = 3;
   static constexpr std::size_t se_y_idx = 4;
   static constexpr std::size_t se_z_idx = 5;
+  static constexpr std::size_t se_speed_idx = 6;
 
   // =------------------------------------------=
   //       GI custom parser token indices
@@ -230,7 +410,10 @@ struct parser_regex {};
 /**
  * A class-tag to select parsing through custom parser.
  */
-struct parser_custom {};
+struct parser_custom {
+  /// Whether the speed of SE events is parsed as well
+  bool with_speed = false;
+};
 /**
  * @brief Parse a single event line into an event.
  *
@@ -0,0 +1,110 @@
+#ifndef SOCCER_MONITORING_EVENT_STORE_HPP
+#define SOCCER_MONITORING_EVENT_STORE_HPP
+
+#include "context.hpp"
+#include "event.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace game {
+/**
+ * An in-memory store of the events of a game, to replay them into an
+ * EventFetcher any number of times without reading nor parsing the stream
+ * again.
+ *
+ * Events are kept in stream order, in blocks of block_size events. Each block
+ * is compressed column by column, as zigzag varints: the sensor ids, the
+ * timestamps as deltas from the previous event, and the x, y and z coordinates
+ * as deltas from the previous position of the same sensor. Deltas restart with
+ * each block, so that blocks are decoded independently. Game interruptions and
+ * resumes are stored as events of reserved sensor ids.
+ */
+class EventStore {
+public:
+  /// An event of the stream, as parsed by parse_event_line()
+  using Event = std::variant<std::monostate, PositionEvent, InterruptionEvent,
+                             ResumeEvent>;
+  /// The number of events of a compressed block
+  static constexpr std::size_t block_size = 4096;
+
+  /**
+   * Decodes the events of an EventStore, in stream order.
+   */
+  class Reader {
+  public:
+    /**
+     * Construct a new Reader from the first event of @p store, which must
+     * outlive this object and not be appended to meanwhile.
+     */
+    explicit Reader(EventStore const &store);
+    /**
+     * Decodes the next event.
+     *
+     * @param event The decoded event
+     * @return false if every event was read, true otherwise.
+     */
+    bool next(Event &event);
+
+  private:
+    EventStore const *store;
+    std::size_t block = 0;
+    std::size_t index = 0;
+    std::size_t nb_positions = 0;
+    std::array<std::uint8_t const *, 5> cursors = {};
+    std::int64_t timestamp = 0;
+    /// The last position of each sensor in the block, indexed by sensor id
+    std::vector<std::array<int, 3>> positions = {};
+
+    void open_block();
+  };
+
+  /**
+   * Appends an event to the store. Empty events are ignored.
+   */
+  void append(Event const &event);
+  /**
+   * @return the number of events in the store.
+   */
+  std::size_t size() const {
+    return blocks.size() * block_size + open_codes.size();
+  }
+  /**
+   * @return the number of bytes taken by the events.
+   */
+  std::size_t get_memory_size() const;
+  /**
+   * @return a Reader of the events from the first one.
+   */
+  Reader read() const { return Reader{*this}; }
+
+private:
+  /// The sensor ids, timestamps, x, y and z columns of a block
+  using Block = std::array<std::vector<std::uint8_t>, 5>;
+
+  std::vector<Block> blocks = {};
+  /// Events of the block being filled, uncompressed
+  std::vector<std::uint32_t> open_codes = {};
+  std::vector<std::int64_t> open_timestamps = {};
+  std::vector<std::array<int, 3>> open_positions = {};
+
+  void seal_block();
+};
+
+/**
+ * Reads the events of a game stream into an EventStore, keeping only the game
+ * interruptions and resumes and the positions of the players and of the balls
+ * of @p context.
+ *
+ * @param path The game events file path
+ * @param context The game::Context. Its positions are not updated.
+ * @return the store of the events.
+ */
+EventStore load_event_store(std::string const &path, Context &context);
+} // namespace game
+
+#endif // SOCCER_MONITORING_EVENT_STORE_HPP
@@ -3,15 +3,65 @@
 
 #include "batch.hpp"
 #include "context.hpp"
+#include "details/fenwick_tree.hpp"
 #include "details/game_statistics_impl.hpp"
+#include "details/scratch_arena.hpp"
+#include "details/sliding_windows.hpp"
+#include "details/work_stealing_pool.hpp"
 #include "event.hpp"
+#include "partials_archive.hpp"
+#include "possession_timeline.hpp"
 
+#include <chrono>
+#include <filesystem>
+#include <istream>
 #include <limits>
+#include <memory>
+#include <ostream>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace game {
+/**
+ * Settings of the approximate mode of GameStatistics::accumulate_stats().
+ *
+ * Only a sample of the ball events is evaluated. Each sample counts for the
+ * event time since the previous sample, converted into the unit exact
+ * possessions are counted in, i.e. divided by the mean time between two ball
+ * events. Base periods of the calibration window count exact possessions.
+ */
+struct BallSampling {
+  /// Evaluate one ball event out of every. 1 evaluates every ball event.
+  std::size_t every = 1;
+  /// Evaluate at most one ball event per interval of event time. 0 sets no
+  /// limit.
+  std::chrono::picoseconds interval = {};
+  /// Number of base periods over which every ball event is evaluated as well,
+  /// to measure the error of the approximation
+  std::size_t calibration_periods = 0;
+};
+
+/**
+ * Counts and accuracy of the approximate mode.
+ */
+struct SamplingReport {
+  /// Number of ball events seen since sampling was enabled
+  std::size_t nb_ball_events = 0;
+  /// Number of ball events evaluated as samples
+  std::size_t nb_samples = 0;
+  /// Number of base periods of the calibration window processed so far
+  std::size_t calibration_periods = 0;
+  /// Number of base periods counted from samples only
+  std::size_t approximate_periods = 0;
+  /// Largest error over the calibration window on the possession share of a
+  /// player within the largest K, in percentage points, of the samples against
+  /// the exact possessions
+  double max_error = 0;
+  /// Mean over the players of that error, in percentage points
+  double mean_error = 0;
+};
+
 /**
  * Manage and compute ball possession statistics.
  *
@@ -20,6 +70,12 @@ namespace game {
  * the ball. The statistics accumulate every T time units as the game unfolds
  * and after T time units partial statistics are computed.
  * Moreover, at any point of time statistics for the whole game are available.
+ *
+ * Several MAXIMUM_DISTANCE (K) and T values can be evaluated at once: distances
+ * are computed once against the largest K and each closest player is then
+ * bucketed by the smallest K it satisfies. Batches must be cut every
+ * base_time_units() seconds, i.e. the greatest common divisor of all the T
+ * values, and each T keeps its own period accumulator.
  */
 class GameStatistics {
 public:
@@ -28,16 +84,36 @@ public:
    */
   static constexpr auto infinite_distance = std::numeric_limits<double>::max();
   /**
-   * Constructs a GameStatistics object.
+   * Default number of events of a batch processed at once. Scratch memory of
+   * accumulate_stats() is proportional to this value, not to the batch size.
+   */
+  static constexpr std::size_t default_tile_size = 1024;
+  /// Number of tiles scanned at once on a work-stealing pool
+  static constexpr std::size_t tile_ring_size = 4;
+  /**
+   * Constructs a GameStatistics object for a single K. A period is over every
+   * time a batch marked as the last one for the period is accumulated.
    *
    * @param maximum_distance The maximum distance at which any player is still
    *        considered in computing the closest one.
    * @param context The game::Context
    */
   GameStatistics(double maximum_distance, Context &context)
-      : maximum_distance{maximum_distance}, context{context} {
-    player_names = context.get_player_names();
-  }
+      : GameStatistics{{maximum_distance}, {1}, context} {}
+  /**
+   * Constructs a GameStatistics object for every (K, T) configuration in
+   * @p maximum_distances x @p time_units. Both lists are sorted and
+   * deduplicated: configurations are then identified by the index of K in
+   * maximum_distances() and of T in time_units().
+   *
+   * @param maximum_distances The maximum distances at which any player is still
+   *        considered in computing the closest one.
+   * @param time_units The number of seconds after which to compute partial
+   *        statistics.
+   * @param context The game::Context
+   */
+  GameStatistics(std::vector<double> maximum_distances,
+                 std::vector<int> time_units, Context &context);
   /**
    * Accumulate statistics from a batch of game::PositionEvent. Statistics are
    * computed as following: 0) Let B be the ball position before calling
@@ -53,42 +129,387 @@ public:
    * be the player such that d(P_i, B) == d_min at instant j; then increment the
    * number of possessions of player i by one.
    *
-   * If the input batch is the last one for the current T time units, partial
-   * statistics are computed as the weighted average of the number of ball
-   * possessions and the accumulator is cleared.
+   * Steps 2) to 4) run on tiles of at most tile-size events at a time, P_i and
+   * B being carried over from a tile to the next one. Memory usage is thus
+   * bounded by the tile size rather than by the batch size.
+   *
+   * If the input batch is the last one for the current base_time_units()
+   * seconds, each T whose period is over computes partial statistics as the
+   * weighted average of the number of ball possessions and clears its
+   * accumulator. Every T period is also over at the end of a game half.
    *
    * @param batch The Batch to compute statistics on
    */
   void accumulate_stats(game::Batch const &batch);
   /**
+   * Accumulate ball possessions computed by another GameStatistics object with
+   * the same configurations, as if accumulate_stats() was called on the
+   * batches they come from. This allows computing possessions of different
+   * periods concurrently and accumulating them in game order.
+   *
+   * @param possessions Possessions returned by take_possessions()
+   * @param batch The last Batch the possessions were computed on. Its data is
+   *        not accessed.
+   */
+  void accumulate_possessions(std::vector<int> const &possessions,
+                              game::Batch const &batch);
+  /**
+   * Count a ball possession of a player, for per-event processing of the
+   * stream. The possession is counted only if the player is within the largest
+   * maximum distance.
+   *
+   * @param player The index of the player closest to the ball, in the order of
+   *        Context::get_player_names()
+   * @param distance The distance of the player from the ball, in millimeters
+   * @param weight The number of possessions to count
+   * @return true if the possession is counted, false otherwise.
+   */
+  bool accumulate_possession(std::size_t player, double distance,
+                             int weight = 1) {
+    auto meters = as_meters(distance);
+    if (!(meters <= maximum_distances.back())) {
+      return false;
+    }
+    buckets[smallest_k(meters) * player_names.size() + player] += weight;
+    return true;
+  }
+  /**
+   * Record the winner of a ball event to the possession timeline and to the
+   * range index, if any. Possessions are counted by accumulate_possession().
+   *
+   * @param player The index of the player closest to the ball, or
+   *        PossessionTimeline::none_player
+   * @param distance The distance of the player from the ball, in millimeters.
+   *        The ball event is won by none if beyond the largest maximum
+   *        distance.
+   * @param ts The timestamp of the ball event
+   * @param weight The number of possessions the ball event counts for
+   */
+  void record_ball_event(std::size_t player, double distance,
+                         std::chrono::picoseconds ts, int weight = 1);
+  /**
+   * Close the current base period, for per-event processing of the stream.
+   * Possessions counted so far are accumulated as by accumulate_stats() on the
+   * last batch of a period.
+   *
+   * @param timestamp The timestamp of the event the period is over at
+   * @param is_half_over True if a game half is over as well
+   */
+  void close_period(std::chrono::picoseconds timestamp, bool is_half_over);
+  /**
+   * Take the ball possessions accumulated since the last batch closing a
+   * period, clearing them.
+   *
+   * @return the possessions, to be passed to accumulate_possessions()
+   */
+  std::vector<int> take_possessions();
+  /**
+   * @param k The index of K in maximum_distances()
+   * @param t The index of T in time_units()
    * @return the accumulated statistics for the current period, for each player.
    *         Each value is percentage of ball possession for a given player in
    *         the current time units slot.
    */
-  std::unordered_map<std::string, double> accumulated_stats() const;
+  std::unordered_map<std::string, double>
+  accumulated_stats(std::size_t k = 0, std::size_t t = 0) const;
   /**
+   * @param k The index of K in maximum_distances()
+   * @param t The index of T in time_units()
    * @return the last computed partial statistics.
    */
-  std::unordered_map<std::string, double> const &last_partial() const;
+  std::unordered_map<std::string, double> const &
+  last_partial(std::size_t k = 0, std::size_t t = 0) const;
+  /**
+   * @param k The index of K in maximum_distances()
+   * @param t The index of T in time_units()
+   * @return the number of periods of T over so far.
+   */
+  std::size_t get_nb_partials(std::size_t k = 0, std::size_t t = 0) const;
+  /**
+   * @param period The index of the period of T, from 0
+   * @param k The index of K in maximum_distances()
+   * @param t The index of T in time_units()
+   * @return the possession share of each player over the period, in the order
+   *         of get_player_names(). Shares are all 0 if no player had the ball.
+   */
+  float const *get_partial(std::size_t period, std::size_t k = 0,
+                           std::size_t t = 0) const;
+  /**
+   * @return the players statistics are computed for.
+   */
+  std::vector<std::string> const &get_player_names() const {
+    return player_names;
+  }
+  /**
+   * Record the winner of each ball event, within the largest K, to a possession
+   * timeline. Its current segment is cut at the end of each game half.
+   *
+   * Ball events are recorded as they are accumulated, hence in game order
+   * unless possessions are computed apart. In approximate mode, only the
+   * sampled ball events are recorded past the calibration window.
+   *
+   * @param timeline The timeline, which must outlive this object, or nullptr
+   *        to record none.
+   */
+  void set_timeline(PossessionTimeline *timeline) { this->timeline = timeline; }
+  /**
+   * @return the possession timeline ball events are recorded to, if any.
+   */
+  PossessionTimeline *get_timeline() const { return timeline; }
+  /**
+   * Index the possessions by time slots of @p resolution, over the match
+   * timeline, so that possession_between() answers in O(log #slots).
+   *
+   * @param resolution The time slot length, or 0 to disable the index
+   */
+  void set_range_index(std::chrono::picoseconds resolution);
+  /**
+   * @param from The timestamp the range starts at
+   * @param to The timestamp the range ends at, excluded
+   * @param k The index of K in maximum_distances()
+   * @return the ball possession statistics of the ball events between @p from
+   *         and @p to, rounded down to the range index resolution.
+   * @throws std::logic_error if possessions are not indexed
+   */
+  std::unordered_map<std::string, double>
+  possession_between(std::chrono::picoseconds from, std::chrono::picoseconds to,
+                     std::size_t k = 0) const;
   /**
+   * Append the partial statistics of each (K, T) configuration to an archive,
+   * as periods are over. Partial statistics computed so far are written first,
+   * unless the archive is resumed.
+   *
+   * @param path The archive file path. If more than one configuration is
+   *        evaluated, the archive of each one is suffixed by _K<K>_T<T>
+   *        before the extension.
+   * @param is_resumed True if the statistics were restored from a checkpoint.
+   *        An existing archive then keeps the periods computed so far and is
+   *        appended to.
+   * @throws std::runtime_error if an archive cannot be created, or if a resumed
+   *         archive was written for other players or configurations
+   */
+  void set_archive(std::filesystem::path const &path, bool is_resumed = false);
+  /**
+   * Compute sliding-window statistics alongside the periods of each T: the
+   * possessions of the last seconds of the game, for several window lengths,
+   * updated every @p step seconds. Possessions are kept per base period in a
+   * ring buffer, so that memory does not grow with the game.
+   *
+   * Base periods are shortened to divide @p step, hence this must be called
+   * before base_time_units() is used to cut batches. Windows are emptied when
+   * the second half starts.
+   *
+   * @param lengths The window lengths, in seconds
+   * @param step The number of seconds between two updates of the windows
+   * @throws std::invalid_argument if a length is not a positive multiple of
+   *         @p step
+   */
+  void set_sliding_windows(std::vector<int> lengths, int step = 1);
+  /**
+   * @return the sorted list of window lengths, in seconds.
+   */
+  std::vector<int> const &get_window_lengths() const { return window_lengths; }
+  /**
+   * @return the number of seconds between two updates of the sliding windows.
+   */
+  int get_window_step() const { return window_step; }
+  /**
+   * @return true if the last accumulated batch updated the sliding windows.
+   */
+  bool is_window_over() const { return window_over; }
+  /**
+   * @param w The index of the window length in get_window_lengths()
+   * @param k The index of K in maximum_distances()
+   * @return the ball possession statistics of the last window seconds.
+   */
+  std::unordered_map<std::string, double> window_stats(std::size_t w,
+                                                       std::size_t k = 0) const;
+  /**
+   * @param t The index of T in time_units()
+   * @return true if the last accumulated batch closed a period of T.
+   */
+  bool is_period_over(std::size_t t = 0) const { return periods_over[t]; }
+  /**
+   * In approximate mode, base periods past the calibration window are counted
+   * from samples only. As the window opens the game, the last partial
+   * statistics, windows and whole game ones are approximate if the last base
+   * period is.
+   *
+   * @return true if the last base period was counted from samples only.
+   */
+  bool is_approximate() const { return is_last_period_approximate; }
+  /**
+   * @param k The index of K in maximum_distances()
    * @return the computed ball possession statistics of the whole game, for each
    *         player. Each value is the percentage of ball possession for a given
    *         player from the beginning of the game up to now.
    */
-  std::unordered_map<std::string, double> game_stats() const;
+  std::unordered_map<std::string, double> game_stats(std::size_t k = 0) const;
+  /**
+   * @return the sorted list of evaluated maximum distances (K)
+   */
+  std::vector<double> const &get_maximum_distances() const {
+    return maximum_distances;
+  }
+  /**
+   * @return the sorted list of evaluated period lengths (T), in seconds
+   */
+  std::vector<int> const &get_time_units() const { return time_units; }
+  /**
+   * @return the period length, in seconds, batches must be cut at: the greatest
+   *         common divisor of get_time_units().
+   */
+  int base_time_units() const { return base_units; }
+  /**
+   * @return the number of heap allocations performed so far for the scratch
+   *         data of accumulate_stats(). Once batches stop growing in size, this
+   *         value no longer changes.
+   */
+  std::size_t scratch_allocations() const;
+  /**
+   * Set the number of events of a batch processed at once.
+   * @param size The tile size. Must be greater than 0.
+   */
+  void set_tile_size(std::size_t size) { tile_size = size; }
+  /**
+   * Run accumulate_stats() on a work-stealing pool instead of OpenMP threads.
+   * Each (tile, player) scan is a task, and the scan of a player's next tile is
+   * pushed to the worker that scanned the previous one. Idle workers steal
+   * scans from the others, so that players with more sensors do not delay the
+   * batch. Each tile is reduced as soon as all its scans are done, and at most
+   * tile_ring_size tiles are in flight, so memory stays bounded by the tile
+   * size rather than by the batch size.
+   *
+   * @param pool The pool, which must outlive this object, or nullptr to run on
+   *        OpenMP threads.
+   */
+  void set_worker_pool(details::WorkStealingPool *pool) { worker_pool = pool; }
+  /**
+   * Enable the approximate mode of accumulate_stats(): the distances of the
+   * players are computed only on sampled ball events. During the calibration
+   * window, every ball event is evaluated as well and the statistics of the
+   * samples are compared against the exact ones in get_sampling_report().
+   *
+   * @param sampling The sampling settings. A default BallSampling evaluates
+   *        every ball event.
+   */
+  void set_sampling(BallSampling sampling);
+  /**
+   * @return the sample counts and the error of the approximate mode.
+   */
+  SamplingReport const &get_sampling_report() const { return sampling_report; }
+  /**
+   * Writes the accumulated possessions, partial statistics and sampling state
+   * to a binary checkpoint, along with the (K, T) configurations and players
+   * they are computed for. To be called between two batches.
+   *
+   * @param os The stream to write to
+   */
+  void save(std::ostream &os) const;
+  /**
+   * Restores the state written by save().
+   *
+   * @param is The stream to read from
+   * @throws std::runtime_error if the state cannot be read or was saved for
+   *         other configurations or players
+   */
+  void restore(std::istream &is);
 
 private:
   Context &context;
-  double maximum_distance = 0.0;
+  std::vector<double> maximum_distances = {};
+  std::vector<int> time_units = {};
+  int base_units = 0;
   std::vector<std::string> player_names = {};
-  std::vector<std::unordered_map<std::string, double>> partials = {};
-  std::unordered_map<std::string, int> accumulator = {};
-  std::unordered_map<std::string, int> game_accumulator = {};
+  /// Partial statistics history, indexed by configuration (K index * #T + T
+  /// index), as a periods x players matrix of possession shares
+  std::vector<std::vector<float>> partials = {};
+  /// Last partial statistics, indexed by configuration
+  std::vector<std::unordered_map<std::string, double>> last_partials = {};
+  /// Archives of the partial statistics, indexed by configuration, if any
+  std::vector<std::unique_ptr<PartialsArchiveWriter>> archives = {};
+  PossessionTimeline *timeline = nullptr;
+  std::chrono::picoseconds range_resolution = {};
+  /// Possessions by time slot, indexed by [smallest K index][player]
+  std::vector<details::FenwickTree> range_trees = {};
+  /// Possessions of the latest time slot, not in range_trees yet
+  std::vector<int> slot_counts = {};
+  std::size_t current_slot = 0;
+  std::vector<int> window_lengths = {};
+  int window_step = 0;
+  /// Possessions of the last base periods, indexed by [K index][player]
+  details::SlidingWindows windows = {};
+  /// Possessions of the current base period, indexed by [K index][player]
+  std::vector<int> window_counts = {};
+  int elapsed_window_units = 0;
+  bool window_over = false;
+  /// Current base period possessions, indexed by [smallest K index][player]
+  std::vector<int> buckets = {};
+  /// Current period possessions, indexed by [T index][K index][player]
+  std::vector<int> accumulators = {};
+  /// Whole game possessions, indexed by [K index][player]
+  std::vector<int> game_accumulators = {};
+  /// Number of base periods in the current period of each T
+  std::vector<int> elapsed_periods = {};
+  std::vector<bool> periods_over = {};
+  bool is_second_half = false;
+  std::size_t tile_size = default_tile_size;
+  std::vector<details::PlayerTrack> tracks = {};
+  details::ScratchArena possession_arena = {};
+  std::vector<details::ScratchArena> thread_arenas = {};
+  details::WorkStealingPool *worker_pool = nullptr;
+  /// Closest players of the tiles in flight, tile t being in t % ring size
+  std::vector<details::BallPossession> tile_ring = {};
+
+  BallSampling sampling = {};
+  bool is_sampling = false;
+  std::size_t since_sample = 0;
+  std::chrono::picoseconds next_sample_ts = {};
+  std::chrono::picoseconds first_ball_ts = {};
+  std::chrono::picoseconds latest_ball_ts = {};
+  std::chrono::picoseconds last_sample_ts = {};
+  /// Event time not counted yet by the samples, in mean ball event intervals
+  double sample_credit = 0;
+  bool is_last_period_approximate = false;
+  /// Weight of each ball event of the batch, 0 if not sampled
+  std::vector<int> sample_weights = {};
+  /// Index in sample_weights of the first ball event of each tile
+  std::vector<std::size_t> tile_ball_offsets = {};
+  std::size_t calibration_left = 0;
+  std::vector<int> calibration_exact = {};
+  std::vector<int> calibration_samples = {};
+  SamplingReport sampling_report = {};
 
   double as_meters(double mm) const { return mm / 1000; }
+  /// The index of the smallest K @p meters is within
+  std::size_t smallest_k(double meters) const {
+    std::size_t k = 0;
+    while (meters > maximum_distances[k]) {
+      ++k;
+    }
+    return k;
+  }
+  void begin_batch(std::chrono::picoseconds initial_ts);
+  void scan_batch_openmp(Batch const &batch);
+  void scan_batch_stealing(Batch const &batch);
+  void scan_tile(Batch const &batch, std::size_t first, std::size_t last,
+                 details::PlayerTrack &track,
+                 details::DistanceResults &distances) const;
+  std::vector<int> possessions(std::size_t k, std::size_t t) const;
+  std::unordered_map<std::string, double>
+  as_percentages(std::vector<int> const &possessions) const;
   void
-  accumulate_partial_statistics(details::BallPossession const &ball_possession);
-  void compute_partial_statistics();
+  accumulate_partial_statistics(details::BallPossession const &ball_possession,
+                                std::size_t first);
+  void record_ball_events(details::BallPossession const &ball_possession,
+                          Batch const &batch, std::size_t first);
+  std::size_t range_slot(std::chrono::picoseconds ts) const;
+  void flush_slot_counts();
+  void compute_partial_statistics(bool is_half_over);
+  void append_partial(std::size_t k, std::size_t t);
+  void sample_ball_events(Batch const &batch);
+  int sample_weight(std::chrono::picoseconds ts);
+  void update_sampling_error();
 };
 } // namespace game
 #endif // SOCCER_MONITORING_GAME_STATISTICS_H
@@ -0,0 +1,124 @@
+#ifndef SOCCER_MONITORING_HEAT_MAPS_HPP
+#define SOCCER_MONITORING_HEAT_MAPS_HPP
+
+#include "batch.hpp"
+#include "batch_operator.hpp"
+#include "context.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace game {
+/**
+ * A grid of cells splitting the field, from field_lower_x to field_upper_x
+ * and from field_lower_y to field_upper_y.
+ */
+struct HeatMapGrid {
+  /// The number of cells along the x axis
+  std::size_t nb_x = 8;
+  /// The number of cells along the y axis
+  std::size_t nb_y = 13;
+};
+
+/**
+ * Computes the heat maps of DEBS 2013 Query 3 as a BatchOperator: the time
+ * each player spends in each cell of a grid over the field, over the periods
+ * of each T and the whole game.
+ *
+ * The cell of a player is the one of the last event of its sensors, positions
+ * out of the field counting for the closest cell. Each interval between two
+ * events of a player is spent in the cell of the first one. Intervals longer
+ * than max_interval, e.g. over a game interruption, are not counted.
+ *
+ * Times are accumulated for the whole game in a single players x cells array,
+ * updated on each player event. The heat maps of a period of T are the
+ * difference between that array at the period end and a copy of it taken at
+ * the period start. They are written as CSV lines "T,period,player,x,y,seconds"
+ * once the period is over, after a "T,period,player,x,y,seconds" header line,
+ * with T and period 0 for the whole game. Only the cells a player spent time
+ * in are written.
+ */
+class HeatMaps : public BatchOperator {
+public:
+  /// The longest interval between two events of a player that is counted
+  static constexpr auto max_interval = std::chrono::seconds{1};
+
+  /**
+   * Construct a new HeatMaps object and write the CSV header.
+   *
+   * @param grid The grid of the heat maps. Each axis must have a cell at
+   *        least.
+   * @param time_units The sorted list of period lengths (T), in seconds, as
+   *        GameStatistics::get_time_units()
+   * @param base_time_units The period length, in seconds, batches are cut at
+   * @param context The game::Context, for the players and their sensors
+   * @param os The stream heat maps are written to. It must outlive this
+   *        object.
+   * @throws std::invalid_argument if an axis of @p grid has no cell
+   */
+  HeatMaps(HeatMapGrid grid, std::vector<int> time_units, int base_time_units,
+           Context const &context, std::ostream &os);
+
+  void on_batch(Batch const &batch) override;
+  void on_period_end(Batch const &batch) override;
+  void on_game_end() override;
+
+  /**
+   * @return the players heat maps are computed for.
+   */
+  std::vector<std::string> const &get_player_names() const {
+    return player_names;
+  }
+  /**
+   * @return the index of the cell of a position, in the order of the heat
+   *         maps: x cell * nb_y + y cell.
+   */
+  std::size_t cell(int x, int y) const;
+  /**
+   * @param t The index of T in the time units
+   * @return the heat maps of the last period of T over, indexed by
+   *         [player][cell], in picoseconds.
+   */
+  std::int64_t const *last_period(std::size_t t = 0) const {
+    return last_periods.data() + t * player_names.size() * nb_cells;
+  }
+  /**
+   * @return the heat maps of the whole game so far, indexed by [player][cell],
+   *         in picoseconds.
+   */
+  std::int64_t const *game_heat_maps() const { return game_times.data(); }
+
+private:
+  HeatMapGrid grid = {};
+  std::size_t nb_cells = 0;
+  std::vector<int> time_units = {};
+  int base_units = 0;
+  std::ostream *os;
+  std::vector<std::string> player_names = {};
+  /// Player index of each sensor id, -1 for the sensors of no player
+  std::vector<int> sensor_players = {};
+  /// Cell and timestamp of the last event of each player
+  std::vector<std::size_t> cells = {};
+  std::vector<std::chrono::picoseconds> last_ts = {};
+  /// Times of the whole game, indexed by [player][cell]
+  std::vector<std::int64_t> game_times = {};
+  /// Copies of game_times at the start of the current period of each T,
+  /// indexed by [T index][player][cell]
+  std::vector<std::int64_t> period_starts = {};
+  /// Times of the last period over of each T, indexed by
+  /// [T index][player][cell]
+  std::vector<std::int64_t> last_periods = {};
+  /// Number of base periods in the current period of each T
+  std::vector<int> elapsed_periods = {};
+  /// Number of periods over of each T
+  std::vector<std::size_t> nb_periods = {};
+
+  void write(int time_units, std::size_t period, std::int64_t const *times);
+};
+} // namespace game
+
+#endif // SOCCER_MONITORING_HEAT_MAPS_HPP
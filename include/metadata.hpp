@@ -10,6 +10,7 @@
 
 #include "fmt/format.h"
 
+#include "event.hpp"
 #include "position.hpp"
 #include "stream_types.hpp"
 
@@ -129,6 +130,9 @@ struct Metadata {
 
   ///< The positions of players and balls on the field.
   std::vector<Positions> positions;
+
+  ///< The instants splitting the match into halves.
+  MatchTimeline timeline = {};
 };
 
 /**
@@ -141,8 +145,9 @@ struct ParseMetadata {
   static const std::regex player_re;
   static constexpr auto player_re_team_idx = 1;
   static constexpr auto player_re_name_idx = 2;
-  static constexpr auto player_re_sid_start_idx = 3;
-  static constexpr auto player_re_sid_end_idx = 6;
+  static constexpr auto player_re_sids_idx = 3;
+
+  static const std::regex timeline_re;
 };
 
 /**
@@ -165,12 +170,18 @@ private:
  * Parses metadata from a file.
  * @param path The metadata file path.
  * @return The game metadata.
+ * @throws std::length_error if a player wears more than
+ *         game::max_player_sensors sensors, or if there are more than
+ *         game::max_ball_sensors balls.
  */
 Metadata parse_metadata_file(std::string const &path);
 /**
  * Parses metadata from a string.
  * @param path The metadata string.
  * @return The game metadata.
+ * @throws std::length_error if a player wears more than
+ *         game::max_player_sensors sensors, or if there are more than
+ *         game::max_ball_sensors balls.
  */
 Metadata parse_metadata_string(std::string const &metadata);
 } // namespace game
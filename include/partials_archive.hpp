@@ -0,0 +1,153 @@
+#ifndef SOCCER_MONITORING_PARTIALS_ARCHIVE_HPP
+#define SOCCER_MONITORING_PARTIALS_ARCHIVE_HPP
+
+#include "details/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace game {
+/**
+ * The layout of a partial statistics archive, holding the partial statistics
+ * of one (K, T) configuration. Values are in native byte order:
+ * - a header of header_size bytes: the magic "SMPA", the uint32 version, the
+ *   uint32 number of players, the int32 period length T in seconds, the double
+ *   maximum distance K in meters and the uint64 number of periods;
+ * - the player names, name_size bytes each, padded with NUL characters;
+ * - one row per period, of one float32 possession share per player, in the
+ *   order of the names. Shares of a period sum to 1, or are all 0 if no player
+ *   had the ball.
+ *
+ * The period p row is thus at byte rows_offset(#players) + p * #players * 4.
+ */
+struct PartialsArchiveLayout {
+  static constexpr std::uint32_t version = 1;
+  static constexpr std::size_t header_size = 32;
+  static constexpr std::size_t name_size = 64;
+
+  /**
+   * @return the offset of the first row of an archive of @p nb_players.
+   */
+  static constexpr std::size_t rows_offset(std::size_t nb_players) {
+    return header_size + nb_players * name_size;
+  }
+};
+
+/**
+ * Appends the partial statistics of a (K, T) configuration to an archive, one
+ * period at a time. The archive is a memory-mapped file, grown by doubling as
+ * periods are appended. The number of periods in the header is updated once
+ * the row of a period is written, so that the file can be mapped by readers
+ * while it is written.
+ */
+class PartialsArchiveWriter {
+public:
+  /// The number of periods the archive is first sized for
+  static constexpr std::size_t initial_periods = 256;
+
+  /**
+   * Creates an empty archive, replacing any file at @p path.
+   *
+   * @param path The archive file path
+   * @param player_names The players, in the order of the shares appended
+   * @param maximum_distance The maximum distance K, in meters
+   * @param time_units The period length T, in seconds
+   * @throws std::runtime_error if the file cannot be created
+   * @throws std::invalid_argument if a name does not fit in name_size bytes
+   */
+  PartialsArchiveWriter(std::filesystem::path const &path,
+                        std::vector<std::string> const &player_names,
+                        double maximum_distance, int time_units);
+  /**
+   * Reopens an archive to append to, e.g. when resuming from a checkpoint.
+   * Periods past the first @p nb_periods ones are dropped.
+   *
+   * @param path The archive file path
+   * @param player_names The players, in the order of the shares appended
+   * @param maximum_distance The maximum distance K, in meters
+   * @param time_units The period length T, in seconds
+   * @param nb_periods The number of periods to keep
+   * @throws std::runtime_error if the file cannot be mapped, or is not an
+   *         archive of this version written for the same players and
+   *         configuration with at least @p nb_periods periods
+   */
+  PartialsArchiveWriter(std::filesystem::path const &path,
+                        std::vector<std::string> const &player_names,
+                        double maximum_distance, int time_units,
+                        std::size_t nb_periods);
+  /**
+   * Shrinks the file to the periods appended and closes it.
+   */
+  ~PartialsArchiveWriter();
+  PartialsArchiveWriter(PartialsArchiveWriter const &) = delete;
+  PartialsArchiveWriter &operator=(PartialsArchiveWriter const &) = delete;
+  /**
+   * Appends the partial statistics of the next period.
+   *
+   * @param shares The possession share of each player
+   * @throws std::runtime_error if the file cannot be grown
+   */
+  void append(float const *shares);
+  /**
+   * @return the number of periods appended.
+   */
+  std::size_t get_nb_periods() const { return nb_periods; }
+
+private:
+  details::MappedFile file;
+  std::size_t nb_players;
+  std::size_t nb_periods = 0;
+};
+
+/**
+ * A read-only view of an archive written by PartialsArchiveWriter. The file is
+ * mapped rather than read, so that any period is read in constant time.
+ */
+class PartialsArchive {
+public:
+  /**
+   * Maps an archive. Periods appended afterwards are not visible.
+   *
+   * @param path The archive file path
+   * @throws std::runtime_error if the file cannot be mapped or is not an
+   *         archive of this version
+   */
+  explicit PartialsArchive(std::filesystem::path const &path);
+  /**
+   * @return the number of periods in the archive.
+   */
+  std::size_t get_nb_periods() const { return nb_periods; }
+  /**
+   * @return the players, in the order of the shares of a period.
+   */
+  std::vector<std::string> const &get_player_names() const {
+    return player_names;
+  }
+  /**
+   * @return the maximum distance K, in meters.
+   */
+  double get_maximum_distance() const { return maximum_distance; }
+  /**
+   * @return the period length T, in seconds.
+   */
+  int get_time_units() const { return time_units; }
+  /**
+   * @param period The index of the period, from 0
+   * @return the possession share of each player over the period.
+   * @throws std::out_of_range if @p period is not in the archive
+   */
+  float const *get_period(std::size_t period) const;
+
+private:
+  details::MappedFile file;
+  std::vector<std::string> player_names = {};
+  double maximum_distance = 0;
+  int time_units = 0;
+  std::size_t nb_periods = 0;
+};
+} // namespace game
+
+#endif // SOCCER_MONITORING_PARTIALS_ARCHIVE_HPP
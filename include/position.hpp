@@ -2,14 +2,48 @@
 #define GAME_POSITION_H
 
 #include <array>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
 #include <tuple>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
 #include "event.hpp"
 
 namespace game {
+/**
+ * The maximum number of sensors worn by a player, i.e. the number of sensor
+ * slots of a PLAYER line in the metadata (left/right leg, left/right arm).
+ */
+constexpr std::size_t max_player_sensors = 4;
+/**
+ * The maximum number of ball sensors tracked on the field.
+ */
+constexpr std::size_t max_ball_sensors = 8;
+
+/**
+ * A read-only view over the sensor ids stored inline in a game::Position. It
+ * is only valid as long as the position it was taken from.
+ */
+class SensorIds {
+public:
+  SensorIds(int const *first, std::size_t size) : first{first}, nb{size} {}
+
+  int const *begin() const { return first; }
+  int const *end() const { return first + nb; }
+  int const *cbegin() const { return first; }
+  int const *cend() const { return first + nb; }
+  std::size_t size() const { return nb; }
+  bool empty() const { return nb == 0; }
+  int operator[](std::size_t i) const { return first[i]; }
+
+private:
+  int const *first;
+  std::size_t nb;
+};
+
 /**
  * The position of an entity on the field. Each entity has some sensors at some
  * coordinates on the field. This class abstracts away the number of sensors,
@@ -43,10 +77,10 @@ public:
     static_cast<Derived &>(*this).update_sensor(sid, vector);
   }
   /**
-   * @return the list of sensor ids attached to this entity.
+   * @return a view over the sensor ids attached to this entity.
    */
-  std::vector<int> const &get_sids() const {
-    return static_cast<Derived &>(*this).get_sids();
+  SensorIds get_sids() const {
+    return static_cast<Derived const &>(*this).get_sids();
   }
 };
 
@@ -71,26 +105,23 @@ public:
    * Implementation of game::Position::add_sensor().
    *
    * The new sensor is set as the ball on the field.
+   *
+   * @throws std::length_error if more than game::max_ball_sensors sensors are
+   *         added.
    */
-  void add_sensor(int sid) {
-    sids.push_back(sid);
-    xs.push_back(0);
-    ys.push_back(0);
-    zs.push_back(0);
-
-    game_ball = sids.size() - 1; // Set last add ball as the game one
-  }
+  void add_sensor(int sid);
   /**
    * Implementation of game::Position::get_sids().
    */
-  std::vector<int> const &get_sids() const { return sids; }
+  SensorIds get_sids() const { return {sids.data(), nb_sensors}; }
 
 private:
   std::size_t game_ball = out_range_idx;
-  std::vector<int> sids = {};
-  std::vector<int> xs = {};
-  std::vector<int> ys = {};
-  std::vector<int> zs = {};
+  std::size_t nb_sensors = 0;
+  std::array<int, max_ball_sensors> sids = {};
+  std::array<int, max_ball_sensors> xs = {};
+  std::array<int, max_ball_sensors> ys = {};
+  std::array<int, max_ball_sensors> zs = {};
 
   std::size_t sid_index(int sid) const;
   static constexpr auto out_range_idx = std::numeric_limits<std::size_t>::max();
@@ -106,33 +137,51 @@ public:
   /**
    * Implementation of game::Position::vector().
    *
+   * The per-dimension sums of the sensor coordinates are kept up to date by
+   * update_sensor(), hence this is just a scaling of the running sums.
+   *
    * @return a vector (x_hat, y_hat, z_hat) where each entry is the average for
    * that dimension of the values of each sensor.
    */
-  std::tuple<double, double, double> vector() const;
+  std::tuple<double, double, double> vector() const {
+    return {sum_x * inv_nb_sensors, sum_y * inv_nb_sensors,
+            sum_z * inv_nb_sensors};
+  }
   /**
    * Implementation of game::Position::update_sensor().
    */
   void update_sensor(int sid, std::tuple<int, int, int> vector);
   /**
    * Implementation of game::Position::add_sensor().
+   *
+   * @throws std::length_error if more than game::max_player_sensors sensors
+   *         are added.
    */
-  void add_sensor(int sid) {
-    sids.push_back(sid);
-    xs.push_back(0);
-    ys.push_back(0);
-    zs.push_back(0);
-  }
+  void add_sensor(int sid);
   /**
    * Implementation of game::Position::get_sids().
    */
-  std::vector<int> const &get_sids() const { return sids; };
+  SensorIds get_sids() const { return {sids.data(), nb_sensors}; }
+  /**
+   * @param sid The sensor id
+   * @return the last coordinates of the sensor.
+   * @throws std::out_of_range if the player does not wear the sensor.
+   */
+  std::tuple<int, int, int> get_sensor(int sid) const {
+    auto idx = sid_index(sid);
+    return {xs[idx], ys[idx], zs[idx]};
+  }
 
 private:
-  std::vector<int> sids = {};
-  std::vector<int> xs = {};
-  std::vector<int> ys = {};
-  std::vector<int> zs = {};
+  std::size_t nb_sensors = 0;
+  double inv_nb_sensors = 0.0;
+  std::array<int, max_player_sensors> sids = {};
+  std::array<int, max_player_sensors> xs = {};
+  std::array<int, max_player_sensors> ys = {};
+  std::array<int, max_player_sensors> zs = {};
+  long long sum_x = 0;
+  long long sum_y = 0;
+  long long sum_z = 0;
 
   std::size_t sid_index(int sid) const;
 };
@@ -142,6 +191,8 @@ private:
  * static-polymorphism.
  */
 using Positions = std::variant<BallPosition, PlayerPosition>;
+static_assert(std::is_trivially_copyable_v<Positions>,
+              "Positions are copied in every snapshot and batch");
 /**
  * Updates a Positions with the new coordinates from an event
  *
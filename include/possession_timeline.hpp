@@ -0,0 +1,101 @@
+#ifndef SOCCER_MONITORING_POSSESSION_TIMELINE_HPP
+#define SOCCER_MONITORING_POSSESSION_TIMELINE_HPP
+
+#include "event.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace game {
+/**
+ * Run-length encodes the ball possession of the game into segments, each one
+ * being the ball events won in a row by the same player, or by none.
+ *
+ * Segments are written as CSV lines "player,start,end" once over, after a
+ * "player,start,end" header line. The player is "None" if no player is within
+ * the maximum distance. Start and end are the timestamps, in picoseconds, of
+ * the first and of the last ball event of the segment.
+ */
+class PossessionTimeline {
+public:
+  /// The player index of the ball events won by no player
+  static constexpr auto none_player = std::numeric_limits<std::size_t>::max();
+
+  /**
+   * What a timeline resumed from a checkpoint needs: the stream offset past
+   * the segments written and the segment being recorded.
+   */
+  struct State {
+    std::int64_t offset = 0;
+    std::uint64_t nb_segments = 0;
+    std::uint64_t current_player = none_player;
+    std::chrono::picoseconds start = {};
+    std::chrono::picoseconds end = {};
+    bool is_open = false;
+  };
+
+  /**
+   * Construct a new PossessionTimeline and write the CSV header.
+   *
+   * @param os The stream segments are written to
+   * @param player_names The players, by index
+   */
+  PossessionTimeline(std::ostream &os, std::vector<std::string> player_names);
+  /**
+   * Records the winner of a ball event. Ball events must be recorded in game
+   * order.
+   *
+   * @param player The index of the player winning the ball event, or
+   *        none_player
+   * @param ts The timestamp of the ball event
+   */
+  void record(std::size_t player, std::chrono::picoseconds ts) {
+    if (player == current_player && is_open) {
+      end = ts;
+      return;
+    }
+    cut();
+    current_player = player;
+    start = end = ts;
+    is_open = true;
+  }
+  /**
+   * Writes the current segment, if any, so that the next ball event starts a
+   * new one, e.g. at the end of a game half.
+   */
+  void cut();
+  /**
+   * @return the number of segments written.
+   */
+  std::size_t get_nb_segments() const { return nb_segments; }
+  /**
+   * Flushes the segments written, e.g. before checkpointing the game.
+   *
+   * @return the state to resume recording from.
+   */
+  State save();
+  /**
+   * Resumes recording from a state returned by save(). The stream is moved to
+   * the offset saved; segments written past it are overwritten.
+   *
+   * @param state The saved state
+   */
+  void restore(State const &state);
+
+private:
+  std::ostream *os;
+  std::vector<std::string> player_names;
+  bool is_open = false;
+  std::size_t current_player = none_player;
+  std::chrono::picoseconds start = {};
+  std::chrono::picoseconds end = {};
+  std::size_t nb_segments = 0;
+};
+} // namespace game
+
+#endif // SOCCER_MONITORING_POSSESSION_TIMELINE_HPP
@@ -0,0 +1,134 @@
+#ifndef SOCCER_MONITORING_RUNNING_STATISTICS_HPP
+#define SOCCER_MONITORING_RUNNING_STATISTICS_HPP
+
+#include "batch.hpp"
+#include "batch_operator.hpp"
+#include "context.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace game {
+/**
+ * Computes the running analysis of DEBS 2013 Query 1 as a BatchOperator: the
+ * distance covered by each player and the time spent in each speed band, from
+ * standing to sprint, over the periods of each T and the whole game.
+ *
+ * The speed of a player is the one of the last event of its sensors, parsed
+ * by EventFetcher::set_speed_parsing(). Each interval between two events of a
+ * player counts for the speed of the first one: the distance covered is the
+ * speed times the interval, spent in the band of the speed. Intervals longer
+ * than max_interval, e.g. over a game interruption, are not counted.
+ *
+ * Counters are kept per player in a single array, allocated at construction,
+ * for the current base period, the current and last period of each T and the
+ * whole game. The statistics of a period of T are drawn once it is over.
+ */
+class RunningStatistics : public BatchOperator {
+public:
+  /// The number of speed bands
+  static constexpr std::size_t nb_bands = 6;
+  /// The speed band names, from the slowest
+  static constexpr std::array<char const *, nb_bands> band_names = {
+      "Stand", "Trot", "Low", "Medium", "High", "Sprint"};
+  /// The upper speed of each band but the last one, in km/h
+  static constexpr std::array<double, nb_bands - 1> band_limits = {1, 11, 14,
+                                                                   17, 24};
+  /// The longest interval between two events of a player that is counted
+  static constexpr auto max_interval = std::chrono::seconds{1};
+
+  /**
+   * The running statistics of a player over some time of the game.
+   */
+  struct Counters {
+    /// The distance covered, in meters
+    double distance = 0;
+    /// The time spent in each speed band
+    std::array<std::chrono::picoseconds, nb_bands> band_times = {};
+  };
+
+  /**
+   * Construct a new RunningStatistics object, computing the running analysis
+   * over the periods of each T.
+   *
+   * @param time_units The sorted list of period lengths (T), in seconds, as
+   *        GameStatistics::get_time_units()
+   * @param base_time_units The period length, in seconds, batches are cut at
+   * @param context The game::Context, for the players and their sensors
+   * @param os The stream to draw the statistics on. It must outlive this
+   *        object.
+   */
+  RunningStatistics(std::vector<int> time_units, int base_time_units,
+                    Context const &context, std::ostream &os);
+
+  void on_batch(Batch const &batch) override;
+  void on_period_end(Batch const &batch) override;
+  void on_game_end() override;
+
+  /**
+   * @return the players statistics are computed for.
+   */
+  std::vector<std::string> const &get_player_names() const {
+    return player_names;
+  }
+  /**
+   * @param t The index of T in the time units
+   * @return true if the last period end closed a period of T.
+   */
+  bool is_period_over(std::size_t t = 0) const { return periods_over[t]; }
+  /**
+   * @param player The index of the player, in the order of get_player_names()
+   * @param t The index of T in the time units
+   * @return the running statistics of the player over the last period of T
+   *         over.
+   */
+  Counters const &last_period(std::size_t player, std::size_t t = 0) const {
+    return counters[(1 + time_units.size() + t) * player_names.size() +
+                    player];
+  }
+  /**
+   * @param player The index of the player, in the order of get_player_names()
+   * @return the running statistics of the player over the whole game so far.
+   */
+  Counters const &game_stats(std::size_t player) const {
+    return counters[(1 + 2 * time_units.size()) * player_names.size() +
+                    player];
+  }
+  /**
+   * @param speed A speed, in micrometers per second
+   * @return the index of the speed band of @p speed.
+   */
+  static std::size_t speed_band(int speed);
+
+private:
+  std::vector<int> time_units = {};
+  int base_units = 0;
+  TeamMap const &teams;
+  std::ostream *os;
+  std::vector<std::string> player_names = {};
+  /// The players, in the order they are drawn
+  std::vector<std::size_t> drawing_order = {};
+  /// Player index of each sensor id, -1 for the sensors of no player
+  std::vector<int> sensor_players = {};
+  /// Speed, in micrometers per second, and timestamp of the last event of
+  /// each player
+  std::vector<int> speeds = {};
+  std::vector<std::chrono::picoseconds> last_ts = {};
+  /// Counters indexed by [slot][player]. Slots are the base period, then the
+  /// current period of each T, the last period over of each T, and the game.
+  std::vector<Counters> counters = {};
+  /// Number of base periods in the current period of each T
+  std::vector<int> elapsed_periods = {};
+  /// Number of periods over of each T
+  std::vector<std::size_t> nb_periods = {};
+  std::vector<bool> periods_over = {};
+
+  void draw(std::string const &label, std::size_t slot);
+};
+} // namespace game
+
+#endif // SOCCER_MONITORING_RUNNING_STATISTICS_HPP
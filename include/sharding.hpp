@@ -0,0 +1,109 @@
+#ifndef SOCCER_MONITORING_SHARDING_HPP
+#define SOCCER_MONITORING_SHARDING_HPP
+
+#include "batch.hpp"
+#include "context.hpp"
+#include "soccer_monitoring.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace game {
+/**
+ * A time shard of the stream: a range of base periods computed by a worker
+ * process, after parsing a lead-in so that positions are those of the whole
+ * stream at the shard start. Periods are identified by their start, as set by
+ * EventFetcher, which lags behind event time after a gap of more than a
+ * period in the stream.
+ */
+struct Shard {
+  /// The start of the first period of the shard
+  std::chrono::picoseconds begin = {};
+  /// The start of the first period after the shard
+  std::chrono::picoseconds end = {};
+  /// The byte of the stream the lead-in starts at
+  std::uint64_t offset = 0;
+  /// The period start of the EventFetcher where the lead-in starts
+  std::chrono::picoseconds period_start = {};
+  /// Whether the game is paused where the lead-in starts
+  bool is_paused = false;
+};
+
+/**
+ * Splits the stream into time shards of about the same number of base periods,
+ * in a single pass over the stream that follows the period starts of
+ * EventFetcher without parsing positions.
+ *
+ * The lead-in of a shard starts with a period, at least @p lead_in of unpaused
+ * game before the shard. As in-game events do not move the players while the
+ * game is paused, pauses do not count in the lead-in. The first shard starts
+ * with the stream.
+ *
+ * @param game_data The game events file path
+ * @param context The game::Context, for the match timeline and the sensors
+ * @param time_units The number of seconds of a base period
+ * @param nb_shards The number of shards. There may be fewer if the stream has
+ *        fewer periods.
+ * @param lead_in The minimum lead-in. Each sensor must send an event within
+ *        this time for positions to be exact at the shard start.
+ * @return the shards, in game order
+ * @throws std::runtime_error if the stream cannot be read
+ */
+std::vector<Shard> plan_shards(std::filesystem::path const &game_data,
+                               Context const &context, int time_units,
+                               std::size_t nb_shards,
+                               std::chrono::picoseconds lead_in);
+/**
+ * @return the shard as "BEGIN,END,OFFSET,PERIOD_START,PAUSED", timestamps
+ *         being in picoseconds and PAUSED 0 or 1.
+ */
+std::string to_string(Shard const &shard);
+/**
+ * Parses a shard written by to_string().
+ *
+ * @return the shard, or nothing if @p value is invalid.
+ */
+std::optional<Shard> parse_shard(std::string const &value);
+
+/**
+ * The possessions of a base period, computed by a shard worker.
+ */
+struct ShardPeriod {
+  /// Possessions returned by GameStatistics::take_possessions()
+  std::vector<int> possessions = {};
+  /// The period last batch, without data
+  Batch last = {};
+};
+
+/**
+ * Computes the base periods of a shard and writes their possessions to
+ * @p os, in binary, for the process coordinating the shards. The stream is
+ * parsed from the lead-in of the shard, whose periods are not computed.
+ *
+ * @param options The game monitoring settings. Only files, maximum distances,
+ *        time units, number of threads and batch size are applied. The batch
+ *        size is fixed.
+ * @param shard The shard
+ * @param os The stream to write the possessions to
+ */
+void run_shard_worker(MonitoringOptions const &options, Shard const &shard,
+                      std::ostream &os);
+/**
+ * Reads the possessions written by run_shard_worker().
+ *
+ * @param is The stream to read from
+ * @return the periods of the shard, in game order
+ * @throws std::runtime_error if the stream is not the whole output of a shard
+ *         worker
+ */
+std::vector<ShardPeriod> read_shard_periods(std::istream &is);
+} // namespace game
+
+#endif // SOCCER_MONITORING_SHARDING_HPP
@@ -1,10 +1,19 @@
 #ifndef SOCCER_MONITORING_SOCCER_MONITORING_HPP
 #define SOCCER_MONITORING_SOCCER_MONITORING_HPP
 
+#include "batch_operator.hpp"
 #include "context.hpp"
+#include "event_store.hpp"
+#include "game_statistics.hpp"
+#include "heat_maps.hpp"
+#include "thread_pinning.hpp"
 #include "visualizer.hpp"
+#include <chrono>
 #include <filesystem>
+#include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace game {
 /**
@@ -18,7 +27,8 @@ namespace game {
  * @param game_data The game events file path.
  * @param metadata The metadata file path
  * @param nb_threads The number of threads to use in computation.
- * @param batch_size The maximum size of a batch of computation.
+ * @param batch_size The maximum size of a batch of computation, or zero to
+ *        adapt it while the game is monitored.
  */
 void run_game_monitoring(int time_units, double maximum_distance,
                          std::filesystem::path const &game_data,
@@ -35,7 +45,8 @@ void run_game_monitoring(int time_units, double maximum_distance,
  * @param game_data The game events file path.
  * @param metadata The metadata file path
  * @param nb_threads The number of threads to use in computation.
- * @param batch_size The maximum size of a batch of computation.
+ * @param batch_size The maximum size of a batch of computation, or zero to
+ *        adapt it while the game is monitored.
  * @param output_path The output file path
  */
 void run_game_monitoring(int time_units, double maximum_distance,
@@ -43,12 +54,177 @@ void run_game_monitoring(int time_units, double maximum_distance,
                          std::filesystem::path const &metadata, int nb_threads,
                          std::size_t batch_size,
                          std::string const &output_path);
+/**
+ * Enumerates the schedulers running the per-player scans of a batch.
+ */
+enum class Scheduler {
+  openmp,       ///< An OpenMP parallel for over players, for each tile
+  work_stealing ///< A persistent work-stealing pool of (tile, player) tasks
+};
+
+/**
+ * The game monitoring settings.
+ */
+struct MonitoringOptions {
+  /// The list of number of seconds after which to output partial statistics
+  std::vector<int> time_units = {};
+  /// The list of maximum distances at which any player is still eligible for
+  /// ball possession
+  std::vector<double> maximum_distances = {};
+  /// The game events file path
+  std::filesystem::path game_data = {};
+  /// The metadata file path
+  std::filesystem::path metadata = {};
+  /// The number of threads to use in computation
+  int nb_threads = 0;
+  /// How the computation threads, batch fetching included, are bound to CPUs.
+  /// Work-stealing workers are bound to the CPU of the OpenMP thread of the
+  /// same index, and stream reader threads to the CPUs of the OpenMP threads.
+  ThreadPinning pinning = {};
+  /// The scheduler running the per-player scans of a batch. Whole periods are
+  /// always computed by OpenMP tasks in period-parallel mode, and matches of
+  /// run_matches() always share a work-stealing pool.
+  Scheduler scheduler = Scheduler::openmp;
+  /// The maximum size of a batch of computation. If zero, the batch size is
+  /// chosen and adapted while the game is monitored.
+  std::size_t batch_size = 0;
+  /// The mean per-event latency the automatic batch size aims at. If zero,
+  /// the automatic batch size maximizes throughput instead.
+  std::chrono::duration<double> target_latency = {};
+  /// The maximum delay between the end of a period and its statistics being
+  /// displayed, when the stream stalls. If zero, periods are only closed by
+  /// the next in-game event. Not applied in streaming and sharded modes, nor
+  /// when replaying an event_store.
+  std::chrono::milliseconds max_emission_delay = {};
+  /// The output file path. Statistics are displayed on the standard output
+  /// stream if empty.
+  std::string output_path = {};
+  /// Whether whole periods are computed concurrently (offline analysis)
+  /// instead of parallelizing each batch across players. Batches are not
+  /// resized in this mode.
+  bool period_parallel = false;
+  /// Whether events are processed one at a time on a single thread, for
+  /// low-latency monitoring. Batch size and scheduler settings are then
+  /// ignored. Excludes the period-parallel and sharded modes.
+  bool streaming = false;
+  /// Whether the streaming mode skips evaluating every player when the closest
+  /// one cannot have changed. Requires streaming mode.
+  bool incremental = false;
+  /// Whether the streaming mode only evaluates the players of the grid cells
+  /// around the ball. Requires streaming mode.
+  bool spatial_index = false;
+  /// Whether the streaming mode measures the ball distance to the closest
+  /// sensor of each player instead of its centroid. Requires streaming mode.
+  bool foot_level = false;
+  /// The ball events evaluated in approximate mode. Every ball event is
+  /// evaluated by default. Not applied in streaming, period-parallel and
+  /// sharded modes.
+  BallSampling sampling = {};
+  /// The checkpoint file path. No checkpoint is written if empty. Not applied
+  /// in streaming, period-parallel and sharded modes, by run_matches(), nor
+  /// when replaying an event_store.
+  std::filesystem::path checkpoint_path = {};
+  /// The number of base periods between two checkpoints. Checkpoints are only
+  /// written at period boundaries in batch-parallel mode.
+  std::size_t checkpoint_periods = 10;
+  /// Whether to restore the checkpoint, if any, and resume the stream from it.
+  /// The timeline and archives are then appended to rather than recreated.
+  bool resume = false;
+  /// The partial statistics archive path. No archive is written if empty.
+  /// Not applied by run_matches().
+  std::filesystem::path archive_path = {};
+  /// The possession timeline CSV path. No timeline is written if empty. Not
+  /// applied in period-parallel and sharded modes, nor by run_matches().
+  std::filesystem::path timeline_path = {};
+  /// The events to replay instead of reading game_data, if any. It must
+  /// outlive the monitoring. The checkpoint, if any, is then not restored.
+  EventStore const *event_store = nullptr;
+  /// The lengths, in seconds, of the sliding windows whose possession
+  /// statistics are displayed along the periods of each T. Not applied by
+  /// run_matches().
+  std::vector<int> window_lengths = {};
+  /// The number of seconds between two updates of the sliding windows
+  int window_step = 1;
+  /// The game clock ranges, from start to end, whose possession statistics
+  /// are displayed after the game. Not applied in period-parallel and sharded
+  /// modes, nor by run_matches().
+  std::vector<std::pair<std::chrono::seconds, std::chrono::seconds>>
+      range_queries = {};
+  /// The time resolution of the possessions indexed for range_queries
+  std::chrono::picoseconds range_resolution = std::chrono::milliseconds{100};
+  /// The number of time shards of the stream computed by worker processes.
+  /// The stream is not sharded if at most 1. Sharded monitoring applies
+  /// neither sampling, timeline, range queries, checkpoints, emission delays,
+  /// running statistics nor heat maps, and the batch size is fixed.
+  std::size_t nb_shards = 1;
+  /// The minimum unpaused game parsed by a shard worker before its shard, for
+  /// positions to be those of the whole stream at the shard start
+  std::chrono::picoseconds shard_lead_in = std::chrono::seconds{2};
+  /// The command running a shard worker, followed by its arguments. It may
+  /// run the worker on another host, e.g. through ssh, as the worker output
+  /// is read from the standard output of the command. If empty, workers run
+  /// this executable.
+  std::vector<std::string> worker_command = {};
+  /// Whether the distance covered by each player and the time spent in each
+  /// speed band are displayed along ball possession, over the periods of each
+  /// T. Only applied in unsharded batch-parallel mode, not by run_matches(),
+  /// and not when replaying an event_store, which keeps no speeds. Running
+  /// statistics are not checkpointed, so they cannot be combined with resume.
+  bool running = false;
+  /// The heat maps CSV path. No heat maps are computed if empty. Only applied
+  /// in unsharded batch-parallel mode, and not by run_matches(). Heat maps are
+  /// not checkpointed, so they cannot be combined with resume.
+  std::filesystem::path heat_map_path = {};
+  /// The grid of the heat maps
+  HeatMapGrid heat_map_grid = {};
+  /// The analytics computed along ball possession, in the same pass over the
+  /// stream, after it and in this order. They must outlive the monitoring.
+  /// Only applied in batch-parallel mode, and not checkpointed.
+  std::vector<BatchOperator *> operators = {};
+};
+/**
+ * Application entry-point, the top-level function to run the game monitoring
+ * for several (K, T) configurations in a single pass over the stream.
+ * Statistics of each configuration are labelled with the configuration if more
+ * than one is evaluated.
+ *
+ * @param options The game monitoring settings
+ */
+void run_game_monitoring(MonitoringOptions const &options);
+/**
+ * The input and output files of a match monitored by run_matches().
+ */
+struct MatchFiles {
+  /// The game events file path
+  std::filesystem::path game_data = {};
+  /// The metadata file path, which may set the match timeline
+  std::filesystem::path metadata = {};
+  /// The output file path. Statistics are displayed on the standard output
+  /// stream if empty, period by period under a label of the match, so that
+  /// the tables of concurrent matches are not mixed up.
+  std::string output_path = {};
+};
+/**
+ * Runs the game monitoring of several matches in a single process.
+ *
+ * Each match has its own Context, EventFetcher and GameStatistics, built from
+ * its own files, and is evaluated for the (K, T) configurations, sampling and
+ * batch size of @p options. An automatic batch size adapts to each match
+ * separately. Batches of each match are fetched on a dedicated thread and
+ * computed on another, which submits them to a work-stealing pool of
+ * @p options nb_threads workers shared by the matches, so that matches are
+ * computed concurrently. The throughput of each match is displayed at the end.
+ *
+ * @param options The settings common to the matches. Their files are ignored,
+ *        and the work-stealing scheduler is always used.
+ * @param matches The files of each match
+ */
+void run_matches(MonitoringOptions const &options,
+                 std::vector<MatchFiles> const &matches);
 
 namespace details {
-void run_game_monitoring(int time_units, double maximum_distance,
-                         std::filesystem::path const &game_data, int nb_threads,
-                         std::size_t batch_size, Context &context,
-                         Visualizer &visualizer);
+void run_game_monitoring(MonitoringOptions const &options, Context &context,
+                         std::ostream &os);
 }
 } // namespace game
 
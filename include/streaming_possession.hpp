@@ -0,0 +1,178 @@
+#ifndef SOCCER_MONITORING_STREAMING_POSSESSION_HPP
+#define SOCCER_MONITORING_STREAMING_POSSESSION_HPP
+
+#include "context.hpp"
+#include "details/uniform_grid.hpp"
+#include "event_fetcher.hpp"
+#include "game_statistics.hpp"
+#include "position.hpp"
+
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace game {
+/**
+ * Computes ball possession one event at a time, for low-latency monitoring.
+ *
+ * Unlike GameStatistics::accumulate_stats(), there is no batch, snapshot nor
+ * thread: the positions of every player and of the ball are kept up to date in
+ * place, and each in-play ball event immediately counts a possession for the
+ * closest player within the largest K. Sensor ids are mapped to players
+ * through a lookup table indexed by sensor id.
+ */
+class StreamingPossession {
+public:
+  /**
+   * The index of no player, e.g. when no player is within the largest K.
+   */
+  static constexpr auto none_player = std::numeric_limits<std::size_t>::max();
+  /**
+   * The callback of a possession change, called with the index of the player
+   * now in possession of the ball (or none_player) and the ball event
+   * timestamp.
+   */
+  using PossessionCallback =
+      std::function<void(std::size_t player, std::chrono::picoseconds ts)>;
+
+  /**
+   * Construct a new StreamingPossession counting possessions into @p stats.
+   * Positions start from the current positions of @p context.
+   *
+   * @param stats The statistics to count possessions into. Players are
+   *        identified by their index in Context::get_player_names().
+   * @param context The game::Context
+   */
+  StreamingPossession(GameStatistics &stats, Context const &context);
+  /**
+   * Set the callback of possession changes. It is called from process(), as
+   * soon as the ball event changing the possession is processed.
+   */
+  void set_possession_callback(PossessionCallback callback) {
+    on_possession_change = std::move(callback);
+  }
+  /**
+   * Process an event of the stream: close the period if over, update the
+   * position of the sensor and, if an in-play ball event, count the
+   * possession.
+   *
+   * @param stream_event The event.
+   * @return true if a period is over before the event, false otherwise.
+   */
+  bool process(StreamEvent const &stream_event);
+  /**
+   * Close the last period, at the end of the stream.
+   */
+  void finish();
+  /**
+   * @return the index of the player in possession of the ball, or
+   *         none_player.
+   */
+  std::size_t get_possessor() const { return possessor; }
+  /**
+   * Enable or disable incremental evaluation of the closest player.
+   *
+   * The closest player (the winner) and the distance of the second closest
+   * (the runner-up) are kept from the last full evaluation, along with how far
+   * the ball and the other players moved since. On a ball event, only the
+   * winner distance is computed: if the winner is still closer than the
+   * runner-up distance minus these movements, no other player can have become
+   * the closest one and the evaluation of every other player is skipped.
+   * Possessions counted are identical to the full evaluation.
+   *
+   * @param is_incremental True to enable incremental evaluation.
+   */
+  void set_incremental(bool is_incremental);
+  /**
+   * @return the number of ball events for which the distance of every player
+   *         was computed.
+   */
+  std::size_t get_nb_evaluated() const { return nb_evaluated; }
+  /**
+   * @return the number of ball events for which only the distance of the
+   *         winner was computed.
+   */
+  std::size_t get_nb_skipped() const { return nb_skipped; }
+  /**
+   * Enable or disable the spatial index of the players.
+   *
+   * Players are hashed into a uniform grid over the field, with cells as large
+   * as the largest K, and moved between cells as their sensors are updated. A
+   * full evaluation then only computes the distance of the players of the 3x3
+   * cells around the ball: any other player is farther than K and cannot be in
+   * possession. Possessions counted are identical to the brute force over
+   * every player.
+   *
+   * @param is_indexed True to enable the spatial index.
+   */
+  void set_spatial_index(bool is_indexed);
+  /**
+   * Enable or disable foot-level evaluation.
+   *
+   * The ball distance is computed against every sensor worn by a player rather
+   * than against the player centroid, in a single pass over the coordinates of
+   * every player sensor. The player wearing the closest sensor is in
+   * possession. Incremental evaluation and the spatial index bound centroid
+   * distances and are not used in this mode.
+   *
+   * @param is_foot_level True to enable foot-level evaluation.
+   */
+  void set_foot_level(bool is_foot_level) {
+    this->is_foot_level = is_foot_level;
+  }
+
+private:
+  /// Entity of a sensor id which is not tracked
+  static constexpr int no_entity = -1;
+  /// Entity of a ball sensor id. Players are entities 0 to #players - 1.
+  static constexpr int ball_entity = -2;
+  /// Margin, in millimeters, covering the rounding errors of the movement
+  /// bound in incremental evaluation
+  static constexpr double margin_tolerance = 1e-6;
+  /// Margin, in millimeters, added to the largest K for the grid cell size so
+  /// that rounding cannot leave a player within K outside of the 3x3 cells
+  static constexpr double cell_tolerance = 1;
+
+  GameStatistics &stats;
+  std::vector<int> entities = {};
+  std::vector<PlayerPosition> players = {};
+  BallPosition ball = {};
+  std::size_t possessor = none_player;
+  std::chrono::picoseconds last_ts = {};
+  PossessionCallback on_possession_change = {};
+
+  bool is_incremental = false;
+  std::size_t winner = none_player;
+  double runner_up_distance = GameStatistics::infinite_distance;
+  std::tuple<double, double, double> evaluated_ball = {};
+  std::vector<std::tuple<double, double, double>> evaluated_players = {};
+  double max_player_movement = 0;
+  std::size_t nb_evaluated = 0;
+  std::size_t nb_skipped = 0;
+
+  std::optional<details::UniformGrid> grid = {};
+
+  bool is_foot_level = false;
+  /// Index of each player sensor id in the sensor coordinates below
+  std::vector<std::size_t> sensor_slots = {};
+  std::vector<double> sensor_xs = {};
+  std::vector<double> sensor_ys = {};
+  std::vector<double> sensor_zs = {};
+  std::vector<std::size_t> sensor_players = {};
+  std::vector<double> squared_distances = {};
+
+  void update_player(std::size_t player, int sid,
+                     std::tuple<int, int, int> coordinates);
+  void update_possession(std::chrono::picoseconds ts);
+  void update_possession_by_sensor(std::chrono::picoseconds ts);
+  std::tuple<std::size_t, double, double>
+  closest_players(std::tuple<double, double, double> const &ball_vector) const;
+  void count_possession(std::size_t closest, double distance,
+                        std::chrono::picoseconds ts);
+};
+} // namespace game
+
+#endif // SOCCER_MONITORING_STREAMING_POSSESSION_HPP
@@ -0,0 +1,92 @@
+#ifndef SOCCER_MONITORING_THREAD_PINNING_HPP
+#define SOCCER_MONITORING_THREAD_PINNING_HPP
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace game {
+/**
+ * Enumerates the policies to bind the computation threads to CPUs.
+ */
+enum class PinPolicy {
+  none,    ///< Threads are left to the OS scheduler
+  compact, ///< Threads fill a socket, one core after the other, before the next
+  spread,  ///< Threads are dealt round-robin across sockets, then cores
+  list     ///< Threads are bound to an explicit list of CPUs
+};
+
+/**
+ * How the computation threads are bound to CPUs.
+ */
+struct ThreadPinning {
+  /// The binding policy
+  PinPolicy policy = PinPolicy::none;
+  /// The CPUs to bind threads to, in thread order, if policy is
+  /// PinPolicy::list
+  std::vector<int> cpus = {};
+};
+
+/**
+ * A logical CPU and its place in the machine topology.
+ */
+struct Cpu {
+  int id = 0;      ///< The logical CPU id
+  int package = 0; ///< The socket the CPU belongs to
+  int core = 0;    ///< The physical core the CPU belongs to, within its socket
+};
+
+/**
+ * Parses a --pin option value, i.e. either "none", "compact", "spread" or a
+ * comma-separated list of CPU ids.
+ *
+ * @param value The option value.
+ * @throws std::invalid_argument if @p value is none of them.
+ * @return the thread pinning.
+ */
+ThreadPinning parse_thread_pinning(std::string const &value);
+/**
+ * @return the CPUs this process may run on, along with their topology. If the
+ *         topology cannot be read, every CPU is reported on socket 0, as its
+ *         own core.
+ */
+std::vector<Cpu> available_cpus();
+/**
+ * Chooses the CPU of each thread.
+ *
+ * @param pinning The thread pinning.
+ * @param cpus The CPUs threads may be bound to.
+ * @param nb_threads The number of threads.
+ * @return the CPU id of each thread, in thread order. If there are more
+ *         threads than CPUs, CPUs are reused in the same order. Empty if
+ *         threads are not pinned.
+ */
+std::vector<int> assign_cpus(ThreadPinning const &pinning,
+                             std::vector<Cpu> const &cpus, int nb_threads);
+/**
+ * Binds each thread of the OpenMP thread pool to its CPU. Thread 0, which
+ * also fetches the batches, is the calling thread.
+ *
+ * The pool is expected to keep the same threads as long as the number of
+ * threads does not change, which is the case of the common OpenMP runtimes.
+ *
+ * @param pinning The thread pinning.
+ * @param nb_threads The number of threads of the pool.
+ * @return the CPU id of each thread, in thread order, or an empty vector if
+ *         threads are not pinned.
+ */
+std::vector<int> pin_threads(ThreadPinning const &pinning, int nb_threads);
+/**
+ * Binds a thread started apart from the OpenMP thread pool, e.g. a worker of
+ * a work-stealing pool or a stream reader, to a set of CPUs.
+ *
+ * @param thread The native handle of the thread to bind.
+ * @param cpus The CPU ids the thread may run on. The thread is left to the OS
+ *        scheduler if empty.
+ * @throws std::runtime_error if the thread could not be bound.
+ */
+void pin_thread(std::thread::native_handle_type thread,
+                std::vector<int> const &cpus);
+} // namespace game
+
+#endif // SOCCER_MONITORING_THREAD_PINNING_HPP
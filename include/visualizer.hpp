@@ -61,6 +61,20 @@ public:
    */
   Visualizer(PlayerMap const &players, TeamMap const &teams, int time_units,
              std::string const &output_path);
+  /**
+   * Construct a new Visualizer object drawing on an existing output stream.
+   * Each drawn table is preceded by @p label, if not empty, so that several
+   * Visualizers can share the same stream.
+   *
+   * @param players The players map
+   * @param teams The teams map
+   * @param time_units the number of seconds after which to output partial
+   *        statistics
+   * @param os The stream to display statistics on. It must outlive this object.
+   * @param label The label identifying the displayed statistics
+   */
+  Visualizer(PlayerMap const &players, TeamMap const &teams, int time_units,
+             std::ostream &os, std::string label);
   /**
    * Destruct this object, closing open resources.
    */
@@ -102,16 +116,37 @@ public:
    */
   void update_stats(std::unordered_map<std::string, double> const &partial,
                     bool is_game_end, std::chrono::picoseconds last_ts);
+  /**
+   * Set the instants of the match the game time is computed from.
+   *
+   * @param timeline The match timeline
+   */
+  void set_timeline(MatchTimeline const &timeline) {
+    this->timeline = timeline;
+  }
+  /**
+   * Mark the next drawn statistics as approximate, i.e. computed from sampled
+   * ball events only.
+   *
+   * @param is_approximate True to mark the statistics as approximate
+   */
+  void set_approximate(bool is_approximate) {
+    this->is_approximate = is_approximate;
+  }
 
 private:
   std::ostream *os;
+  bool owns_stream = false;
+  std::string label = {};
   PlayerMap const &players;
   TeamMap const &teams;
   std::map<std::string, double, details::PartialsCmp> partials;
   int time_units = 0;
+  MatchTimeline timeline = {};
   std::chrono::seconds game_time = std::chrono::seconds{0};
   double team_a_partial = 0.0;
   double team_b_partial = 0.0;
+  bool is_approximate = false;
 
   void init_partials(TeamMap const &teams);
   void update_game_time(std::chrono::picoseconds last_ts);
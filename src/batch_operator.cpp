@@ -0,0 +1,20 @@
+#include "batch_operator.hpp"
+
+namespace game {
+void OperatorPipeline::on_batch(Batch const &batch) {
+  for (auto *op : operators) {
+    op->on_batch(batch);
+  }
+  if (batch.is_period_last_batch) {
+    for (auto *op : operators) {
+      op->on_period_end(batch);
+    }
+  }
+}
+
+void OperatorPipeline::on_game_end() {
+  for (auto *op : operators) {
+    op->on_game_end();
+  }
+}
+} // namespace game
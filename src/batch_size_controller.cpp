@@ -0,0 +1,55 @@
+#include "batch_size_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace game {
+BatchSizeController::BatchSizeController(seconds target_latency,
+                                         std::size_t batch_size)
+    : target_latency{target_latency},
+      batch_size{std::clamp(batch_size, min_batch_size, max_batch_size)} {}
+
+std::size_t BatchSizeController::observe(std::size_t nb_events,
+                                         seconds fetch_time,
+                                         seconds compute_time) {
+  window_events += nb_events;
+  window_time += fetch_time + compute_time;
+  window_latency += static_cast<double>(nb_events) *
+                    (fetch_time / 2.0 + compute_time);
+
+  // Batches cut short by a period end or a game pause only count for their
+  // events, so a window always measures about the same amount of work
+  if (window_events >= window_batches * batch_size) {
+    adjust();
+  }
+  return batch_size;
+}
+
+void BatchSizeController::adjust() {
+  if (window_time.count() > 0) {
+    auto previous_throughput = throughput;
+    throughput = static_cast<double>(window_events) / window_time.count();
+    latency = window_latency / static_cast<double>(window_events);
+
+    auto factor = 1.0;
+    if (target_latency.count() > 0) {
+      // Latency grows about linearly with the batch size. Bound the factor so
+      // that a single noisy window cannot throw the size far off.
+      factor = std::clamp(target_latency / latency, 0.5, 2.0);
+    } else {
+      if (throughput < previous_throughput) {
+        direction = 1.0 / direction;
+      }
+      factor = direction;
+    }
+
+    auto size = std::llround(static_cast<double>(batch_size) * factor);
+    batch_size = std::clamp(static_cast<std::size_t>(std::max(size, 1LL)),
+                            min_batch_size, max_batch_size);
+  }
+
+  window_events = 0;
+  window_time = seconds{0};
+  window_latency = seconds{0};
+}
+} // namespace game
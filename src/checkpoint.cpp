@@ -0,0 +1,59 @@
+#include "checkpoint.hpp"
+#include "details/binary_io.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace {
+/// Identifies checkpoint files
+constexpr auto magic = std::array<char, 4>{'S', 'M', 'C', 'P'};
+/// Bumped on every change of the checkpoint layout
+constexpr std::uint32_t version = 5;
+} // namespace
+
+void save_checkpoint(std::filesystem::path const &path, Context const &context,
+                     EventFetcher const &fetcher, GameStatistics const &stats) {
+  auto tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    auto os = std::ofstream{tmp_path, std::ios::binary | std::ios::trunc};
+    details::write_raw(os, magic);
+    details::write_raw(os, version);
+    context.save_positions(os);
+    fetcher.save(os);
+    stats.save(os);
+    if (!os.flush()) {
+      throw std::runtime_error{
+          fmt::format("Cannot write checkpoint {}", tmp_path.string())};
+    }
+  }
+  std::filesystem::rename(tmp_path, path);
+}
+
+void restore_checkpoint(std::filesystem::path const &path, Context &context,
+                        EventFetcher &fetcher, GameStatistics &stats) {
+  auto is = std::ifstream{path, std::ios::binary};
+  if (!is) {
+    throw std::runtime_error{
+        fmt::format("Cannot open checkpoint {}", path.string())};
+  }
+
+  auto file_magic = decltype(magic){};
+  auto file_version = std::uint32_t{};
+  details::read_raw(is, file_magic);
+  details::read_raw(is, file_version);
+  if (file_magic != magic || file_version != version) {
+    throw std::runtime_error{
+        fmt::format("{} is not a checkpoint of this version", path.string())};
+  }
+
+  context.restore_positions(is);
+  fetcher.restore(is);
+  stats.restore(is);
+}
+} // namespace game
@@ -2,6 +2,7 @@
 #include <context.hpp>
 
 #include "context.hpp"
+#include "details/binary_io.hpp"
 
 namespace game {
 
@@ -15,6 +16,7 @@ Context Context::build_from(std::filesystem::path const &metadata) {
   context.set_player_map(players);
   context.set_team_map(teams);
   context.set_ball_map(balls);
+  context.set_timeline(meta.timeline);
 
   for (auto &position : meta.positions) {
     auto sids = std::visit([](auto &&pos) { return pos.get_sids(); }, position);
@@ -33,6 +35,7 @@ Context Context::build_from(std::string const &metadata) {
   context.set_player_map(players);
   context.set_team_map(teams);
   context.set_ball_map(balls);
+  context.set_timeline(meta.timeline);
 
   for (auto &position : meta.positions) {
     auto sids = std::visit([](auto &&pos) { return pos.get_sids(); }, position);
@@ -53,8 +56,26 @@ Snapshot Context::take_snapshot() const {
   return snapshot;
 }
 
-void Context::add_position(Positions const &position,
-                           std::vector<int> const &sids) {
+void Context::save_positions(std::ostream &os) const {
+  details::write_vector(os, positions);
+}
+
+void Context::restore_positions(std::istream &is) {
+  auto restored = std::vector<Positions>{};
+  details::read_vector(is, restored);
+  if (restored.size() != positions.size()) {
+    throw std::runtime_error{"Checkpoint positions do not match the metadata"};
+  }
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    if (restored[i].index() != positions[i].index()) {
+      throw std::runtime_error{
+          "Checkpoint positions do not match the metadata"};
+    }
+  }
+  positions = std::move(restored);
+}
+
+void Context::add_position(Positions const &position, SensorIds sids) {
   positions.push_back(position);
   auto idx = positions.size() - 1;
   for (int sid : sids) {
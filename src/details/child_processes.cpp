@@ -0,0 +1,152 @@
+#include "details/child_processes.hpp"
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace details {
+namespace {
+/**
+ * A child process and the read end of the pipe of its standard output.
+ */
+struct ChildProcess {
+  pid_t pid = -1;
+  int fd = -1;
+  std::string output = {};
+};
+
+std::runtime_error system_error(char const *what) {
+  return std::runtime_error{fmt::format("{}: {}", what, std::strerror(errno))};
+}
+
+int wait_for(pid_t pid) {
+  auto status = 0;
+  while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  return status;
+}
+
+std::string describe_status(int status) {
+  if (WIFEXITED(status)) {
+    return fmt::format("exited with status {}", WEXITSTATUS(status));
+  }
+  if (WIFSIGNALED(status)) {
+    return fmt::format("was killed by signal {}", WTERMSIG(status));
+  }
+  return "failed";
+}
+} // namespace
+
+void run_child_processes(
+    std::vector<std::vector<std::string>> const &commands,
+    std::function<void(std::size_t, std::string)> const &on_exit) {
+  auto children = std::vector<ChildProcess>(commands.size());
+  try {
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+      auto argv = std::vector<char *>{};
+      for (auto const &arg : commands[i]) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+      }
+      argv.push_back(nullptr);
+
+      // Pipes are closed on exec, so that a child does not hold the pipes of
+      // the others open
+      int fds[2];
+      if (::pipe2(fds, O_CLOEXEC) != 0) {
+        throw system_error("Cannot create a pipe");
+      }
+      auto pid = ::fork();
+      if (pid < 0) {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        throw system_error("Cannot fork");
+      }
+      if (pid == 0) {
+        // Only async-signal-safe calls in the child until exec
+        ::dup2(fds[1], STDOUT_FILENO);
+        ::execvp(argv[0], argv.data());
+        ::_exit(127);
+      }
+      ::close(fds[1]);
+      children[i].pid = pid;
+      children[i].fd = fds[0];
+    }
+
+    auto nb_running = children.size();
+    auto polled = std::vector<pollfd>{};
+    auto polled_children = std::vector<std::size_t>{};
+    auto buffer = std::array<char, 1 << 16>{};
+    while (nb_running > 0) {
+      polled.clear();
+      polled_children.clear();
+      for (std::size_t i = 0; i < children.size(); ++i) {
+        if (children[i].fd >= 0) {
+          polled.push_back({children[i].fd, POLLIN, 0});
+          polled_children.push_back(i);
+        }
+      }
+      if (::poll(polled.data(), polled.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw system_error("Cannot poll child processes");
+      }
+
+      for (std::size_t j = 0; j < polled.size(); ++j) {
+        if (polled[j].revents == 0) {
+          continue;
+        }
+        auto i = polled_children[j];
+        auto &child = children[i];
+        auto nb_read = ::read(child.fd, buffer.data(), buffer.size());
+        if (nb_read > 0) {
+          child.output.append(buffer.data(),
+                              static_cast<std::size_t>(nb_read));
+          continue;
+        }
+        if (nb_read < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throw system_error("Cannot read a child process output");
+        }
+
+        // The output is over: the process is exiting
+        ::close(child.fd);
+        child.fd = -1;
+        auto status = wait_for(child.pid);
+        child.pid = -1;
+        --nb_running;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+          throw std::runtime_error{fmt::format("Child process {} ({}) {}", i,
+                                               commands[i].front(),
+                                               describe_status(status))};
+        }
+        on_exit(i, std::move(child.output));
+      }
+    }
+  } catch (...) {
+    for (auto &child : children) {
+      if (child.fd >= 0) {
+        ::close(child.fd);
+      }
+      if (child.pid > 0) {
+        ::kill(child.pid, SIGKILL);
+        wait_for(child.pid);
+      }
+    }
+    throw;
+  }
+}
+} // namespace details
+} // namespace game
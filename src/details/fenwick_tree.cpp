@@ -0,0 +1,19 @@
+#include "details/fenwick_tree.hpp"
+
+namespace game {
+namespace details {
+void FenwickTree::add(std::size_t index, std::int64_t value) {
+  for (auto i = index + 1; i < nodes.size(); i += i & (~i + 1)) {
+    nodes[i] += value;
+  }
+}
+
+std::int64_t FenwickTree::prefix_sum(std::size_t index) const {
+  auto sum = std::int64_t{0};
+  for (auto i = index; i > 0; i -= i & (~i + 1)) {
+    sum += nodes[i];
+  }
+  return sum;
+}
+} // namespace details
+} // namespace game
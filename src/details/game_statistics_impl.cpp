@@ -1,35 +1,38 @@
 #include "details/game_statistics_impl.hpp"
-#include <boost/concept_check.hpp>
+
+#include <algorithm>
 
 namespace game {
 namespace details {
-using namespace std::string_literals;
-
-const std::string BallPossession::none_player = "None"s;
-
 void BallPossession::reduce(DistanceResults const &distance) {
-  if (min_distances.empty()) {
+  if (!is_reduced) {
     // Initialize internal containers
-    std::copy(distance.cbegin(), distance.cend(),
-              std::back_inserter(min_distances));
+    size = distance.size();
+    std::copy(distance.cbegin(), distance.cend(), min_distances);
 
-    for (auto const &d : min_distances) {
-      if (d == infinite_distance) {
-        closest_players.push_back(none_player);
+    for (std::size_t i = 0; i < size; ++i) {
+      if (min_distances[i] == infinite_distance) {
+        closest_players[i] = none_player;
       } else {
-        closest_players.push_back(distance.get_player_name());
+        closest_players[i] = distance.get_player();
       }
     }
+    is_reduced = true;
   } else {
-    for (std::size_t i = 0; i < min_distances.size(); ++i) {
+    for (std::size_t i = 0; i < size; ++i) {
       if (distance[i] < min_distances[i]) {
         min_distances[i] = distance[i];
-        closest_players[i] = distance.get_player_name();
+        closest_players[i] = distance.get_player();
       }
     }
   }
 }
 
+void BallPossession::clear() {
+  size = 0;
+  is_reduced = false;
+}
+
 BallPossession::iterator BallPossession::begin() { return iterator{*this}; }
 BallPossession::const_iterator BallPossession::begin() const {
   return const_iterator{*this};
@@ -38,13 +41,13 @@ BallPossession::const_iterator BallPossession::cbegin() const {
   return const_iterator{*this};
 }
 BallPossession::iterator BallPossession::end() {
-  return iterator{*this, min_distances.size()};
+  return iterator{*this, size};
 }
 BallPossession::const_iterator BallPossession::end() const {
-  return const_iterator{*this, min_distances.size()};
+  return const_iterator{*this, size};
 }
 BallPossession::const_iterator BallPossession::cend() const {
-  return const_iterator{*this, min_distances.size()};
+  return const_iterator{*this, size};
 }
 } // namespace details
 } // namespace game
@@ -0,0 +1,69 @@
+#include "details/line_reader.hpp"
+
+namespace game {
+namespace details {
+LineReader::LineReader(std::unique_ptr<std::istream> is,
+                       StartHook const &on_start)
+    : is{std::move(is)}, reader{&LineReader::read_all, this} {
+  if (on_start) {
+    try {
+      on_start(reader);
+    } catch (...) {
+      stop();
+      throw;
+    }
+  }
+}
+
+LineReader::~LineReader() { stop(); }
+
+void LineReader::stop() {
+  {
+    auto lock = std::lock_guard{mutex};
+    is_stopping = true;
+  }
+  space_ready.notify_all();
+  reader.join();
+}
+
+LineReader::Status LineReader::read_line(std::string &line,
+                                         clock::time_point deadline) {
+  auto lock = std::unique_lock{mutex};
+  auto is_ready = line_ready.wait_until(
+      lock, deadline, [&] { return !lines.empty() || is_eof; });
+  if (!is_ready) {
+    return Status::timeout;
+  }
+  if (lines.empty()) {
+    return Status::eof;
+  }
+
+  line = std::move(lines.front());
+  lines.pop_front();
+  lock.unlock();
+  space_ready.notify_one();
+  return Status::line;
+}
+
+void LineReader::read_all() {
+  auto line = std::string{};
+  while (std::getline(*is, line)) {
+    auto lock = std::unique_lock{mutex};
+    space_ready.wait(lock,
+                     [&] { return lines.size() < capacity || is_stopping; });
+    if (is_stopping) {
+      return;
+    }
+    lines.push_back(std::move(line));
+    lock.unlock();
+    line_ready.notify_one();
+  }
+
+  {
+    auto lock = std::lock_guard{mutex};
+    is_eof = true;
+  }
+  line_ready.notify_one();
+}
+} // namespace details
+} // namespace game
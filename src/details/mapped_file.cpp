@@ -0,0 +1,92 @@
+#include "details/mapped_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace details {
+namespace {
+std::runtime_error file_error(char const *what,
+                              std::filesystem::path const &path) {
+  return std::runtime_error{
+      fmt::format("{} {}: {}", what, path.string(), std::strerror(errno))};
+}
+} // namespace
+
+MappedFile::MappedFile(std::filesystem::path const &path, Mode mode,
+                       std::size_t size)
+    : path{path}, mode{mode} {
+  if (mode == Mode::read) {
+    fd = ::open(path.c_str(), O_RDONLY);
+  } else if (mode == Mode::update) {
+    fd = ::open(path.c_str(), O_RDWR);
+  } else {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  }
+  if (fd < 0) {
+    throw file_error("Cannot open", path);
+  }
+
+  if (mode != Mode::create) {
+    struct stat status = {};
+    if (::fstat(fd, &status) != 0) {
+      ::close(fd);
+      throw file_error("Cannot stat", path);
+    }
+    nb_bytes = static_cast<std::size_t>(status.st_size);
+  } else if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    throw file_error("Cannot resize", path);
+  } else {
+    nb_bytes = size;
+  }
+
+  try {
+    map();
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+MappedFile::~MappedFile() {
+  unmap();
+  ::close(fd);
+}
+
+void MappedFile::resize(std::size_t size) {
+  unmap();
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    throw file_error("Cannot resize", path);
+  }
+  nb_bytes = size;
+  map();
+}
+
+void MappedFile::map() {
+  if (nb_bytes == 0) {
+    return;
+  }
+  auto protection = mode == Mode::read ? PROT_READ : PROT_READ | PROT_WRITE;
+  auto *address = ::mmap(nullptr, nb_bytes, protection, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    throw file_error("Cannot map", path);
+  }
+  bytes = static_cast<std::byte *>(address);
+}
+
+void MappedFile::unmap() {
+  if (bytes != nullptr) {
+    ::munmap(bytes, nb_bytes);
+    bytes = nullptr;
+  }
+}
+} // namespace details
+} // namespace game
@@ -0,0 +1,31 @@
+#include "details/scratch_arena.hpp"
+
+#include <algorithm>
+
+namespace game {
+namespace details {
+void ScratchArena::reset() {
+  if (!retired.empty()) {
+    // Requests did not fit a single block: coalesce them for next time.
+    retired.clear();
+    capacity = std::max(capacity, used);
+    block = std::make_unique<std::byte[]>(capacity);
+    ++allocations;
+  }
+  offset = 0;
+  used = 0;
+}
+
+void ScratchArena::grow(std::size_t bytes) {
+  // Buffers already handed out must stay valid: retire the current block
+  // instead of reallocating it.
+  if (block) {
+    retired.push_back(std::move(block));
+  }
+  capacity = std::max(2 * capacity, bytes);
+  block = std::make_unique<std::byte[]>(capacity);
+  offset = 0;
+  ++allocations;
+}
+} // namespace details
+} // namespace game
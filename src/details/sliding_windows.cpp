@@ -0,0 +1,81 @@
+#include "details/sliding_windows.hpp"
+#include "details/binary_io.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+namespace game {
+namespace details {
+SlidingWindows::SlidingWindows(std::vector<std::size_t> lengths,
+                               std::size_t width)
+    : lengths{std::move(lengths)}, width{width} {
+  capacity = this->lengths.empty() ? 0
+                                   : *std::max_element(this->lengths.cbegin(),
+                                                       this->lengths.cend());
+  ring.resize(capacity * width, 0);
+  sums.resize(this->lengths.size() * width, 0);
+}
+
+void SlidingWindows::push(int const *counts) {
+  if (capacity == 0) {
+    return;
+  }
+
+  // Take off the slot each full window slides past, before it is overwritten
+  for (std::size_t w = 0; w < lengths.size(); ++w) {
+    if (nb_slots < lengths[w]) {
+      continue;
+    }
+    auto const *oldest =
+        ring.data() + (head + capacity - lengths[w]) % capacity * width;
+    auto *window = sums.data() + w * width;
+    for (std::size_t i = 0; i < width; ++i) {
+      window[i] -= oldest[i];
+    }
+  }
+
+  std::copy(counts, counts + width, ring.begin() + head * width);
+  for (std::size_t w = 0; w < lengths.size(); ++w) {
+    auto *window = sums.data() + w * width;
+    for (std::size_t i = 0; i < width; ++i) {
+      window[i] += counts[i];
+    }
+  }
+  head = (head + 1) % capacity;
+  nb_slots = std::min(nb_slots + 1, capacity);
+}
+
+void SlidingWindows::clear() {
+  std::fill(ring.begin(), ring.end(), 0);
+  std::fill(sums.begin(), sums.end(), 0);
+  head = 0;
+  nb_slots = 0;
+}
+
+void SlidingWindows::save(std::ostream &os) const {
+  write_vector(os, ring);
+  write_vector(os, sums);
+  write_raw(os, static_cast<std::uint64_t>(head));
+  write_raw(os, static_cast<std::uint64_t>(nb_slots));
+}
+
+void SlidingWindows::restore(std::istream &is) {
+  auto ring_size = ring.size();
+  auto sums_size = sums.size();
+  read_vector(is, ring);
+  read_vector(is, sums);
+  auto saved_head = std::uint64_t{};
+  auto saved_nb_slots = std::uint64_t{};
+  read_raw(is, saved_head);
+  read_raw(is, saved_nb_slots);
+  if (ring.size() != ring_size || sums.size() != sums_size ||
+      saved_nb_slots > capacity || (capacity > 0 && saved_head >= capacity)) {
+    throw std::runtime_error{"Saved sliding windows have other lengths"};
+  }
+  head = static_cast<std::size_t>(saved_head);
+  nb_slots = static_cast<std::size_t>(saved_nb_slots);
+}
+} // namespace details
+} // namespace game
@@ -0,0 +1,58 @@
+#include "details/uniform_grid.hpp"
+#include "event.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace game {
+namespace details {
+namespace {
+std::size_t nb_cells(double extent, double cell_size) {
+  return static_cast<std::size_t>(std::floor(extent / cell_size)) + 1;
+}
+
+std::size_t clamp_cell(double coordinate, double lower, double cell_size,
+                       std::size_t nb) {
+  auto cell = std::floor((coordinate - lower) / cell_size);
+  if (!(cell > 0)) {
+    return 0;
+  }
+  return static_cast<std::size_t>(std::min(cell, double(nb - 1)));
+}
+} // namespace
+
+UniformGrid::UniformGrid(double cell_size, std::size_t nb_items)
+    : cell_size{cell_size},
+      nb_columns{nb_cells(field_upper_x - field_lower_x, cell_size)},
+      nb_rows{nb_cells(field_upper_y - field_lower_y, cell_size)},
+      cells(nb_columns * nb_rows), item_cells(nb_items, no_cell) {}
+
+void UniformGrid::update(std::size_t item, double x, double y) {
+  auto cell = cell_of(x, y);
+  auto previous = item_cells[item];
+  if (cell == previous) {
+    return;
+  }
+
+  if (previous != no_cell) {
+    auto &items = cells[previous];
+    auto it = std::find(items.begin(), items.end(), item);
+    *it = items.back();
+    items.pop_back();
+  }
+  if (cell != no_cell) {
+    cells[cell].push_back(item);
+  }
+  item_cells[item] = cell;
+}
+
+std::size_t UniformGrid::cell_of(double x, double y) const {
+  if (!std::isfinite(x) || !std::isfinite(y)) {
+    return no_cell;
+  }
+  auto cx = clamp_cell(x, field_lower_x, cell_size, nb_columns);
+  auto cy = clamp_cell(y, field_lower_y, cell_size, nb_rows);
+  return cy * nb_columns + cx;
+}
+} // namespace details
+} // namespace game
@@ -0,0 +1,165 @@
+#include "details/work_stealing_pool.hpp"
+
+namespace game {
+namespace details {
+WorkStealingPool::WorkStealingPool(std::size_t nb_workers,
+                                   StartHook const &on_start) {
+  for (std::size_t i = 0; i < nb_workers; ++i) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i = 0; i < nb_workers; ++i) {
+    threads.emplace_back(&WorkStealingPool::thread_main, this, i);
+  }
+  if (on_start) {
+    try {
+      for (std::size_t i = 0; i < nb_workers; ++i) {
+        on_start(threads[i], i);
+      }
+    } catch (...) {
+      stop();
+      throw;
+    }
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() { stop(); }
+
+void WorkStealingPool::stop() {
+  {
+    auto lock = std::lock_guard{mutex};
+    is_stopping = true;
+  }
+  task_ready.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::run(std::vector<std::size_t> const &initial,
+                           std::size_t nb_tasks, Body const &body) {
+  if (nb_tasks == 0) {
+    return;
+  }
+
+  auto job = Job{&body, {nb_tasks}};
+  {
+    auto lock = std::lock_guard{mutex};
+    ++nb_jobs;
+  }
+  // Concurrent jobs start on different workers
+  auto first = next_worker.fetch_add(initial.size());
+  for (std::size_t i = 0; i < initial.size(); ++i) {
+    auto &worker = *workers[(first + i) % workers.size()];
+    ++nb_queued;
+    auto lock = std::lock_guard{worker.mutex};
+    worker.tasks.push_back({&job, initial[i]});
+  }
+
+  auto lock = std::unique_lock{mutex};
+  task_ready.notify_all();
+  job_done.wait(lock, [&] { return job.remaining == 0; });
+
+  // Workers idle since then stop counting idle time
+  if (--nb_jobs == 0) {
+    task_ready.notify_all();
+  }
+}
+
+void WorkStealingPool::push(std::size_t worker, std::size_t task) {
+  auto &w = *workers[worker];
+  ++nb_queued;
+  {
+    auto lock = std::lock_guard{w.mutex};
+    w.tasks.push_back({w.job, task});
+  }
+  // A worker either sees the task queued before sleeping, or is counted as
+  // sleeping here and notified under the mutex
+  if (nb_sleeping > 0) {
+    auto lock = std::lock_guard{mutex};
+    task_ready.notify_one();
+  }
+}
+
+std::size_t WorkStealingPool::nb_steals() const {
+  std::size_t steals = 0;
+  for (auto const &worker : workers) {
+    steals += worker->steals;
+  }
+  return steals;
+}
+
+std::chrono::nanoseconds WorkStealingPool::idle_time() const {
+  auto idle = std::chrono::nanoseconds{0};
+  for (auto const &worker : workers) {
+    idle += std::chrono::nanoseconds{worker->idle};
+  }
+  return idle;
+}
+
+void WorkStealingPool::thread_main(std::size_t worker) {
+  auto &w = *workers[worker];
+  while (true) {
+    auto task = Task{};
+    if (!pop(worker, task) && !steal(worker, task)) {
+      auto lock = std::lock_guard{mutex};
+      if (is_stopping) {
+        return;
+      }
+    }
+    if (task.job == nullptr) {
+      sleep(w);
+      continue;
+    }
+
+    w.job = task.job;
+    (*task.job->body)(task.index, worker);
+    if (--task.job->remaining == 0) {
+      auto lock = std::lock_guard{mutex};
+      job_done.notify_all();
+    }
+  }
+}
+
+void WorkStealingPool::sleep(Worker &worker) {
+  using clock = std::chrono::steady_clock;
+  auto lock = std::unique_lock{mutex};
+  auto is_idle = nb_jobs > 0;
+  auto idle_since = clock::now();
+  ++nb_sleeping;
+  task_ready.wait(lock, [&] {
+    return nb_queued > 0 || is_stopping || (is_idle && nb_jobs == 0);
+  });
+  --nb_sleeping;
+  if (is_idle) {
+    worker.idle += (clock::now() - idle_since).count();
+  }
+}
+
+bool WorkStealingPool::pop(std::size_t worker, Task &task) {
+  auto &w = *workers[worker];
+  auto lock = std::lock_guard{w.mutex};
+  if (w.tasks.empty()) {
+    return false;
+  }
+  task = w.tasks.back();
+  w.tasks.pop_back();
+  --nb_queued;
+  return true;
+}
+
+bool WorkStealingPool::steal(std::size_t worker, Task &task) {
+  for (std::size_t i = 1; i < workers.size(); ++i) {
+    auto &victim = *workers[(worker + i) % workers.size()];
+    auto lock = std::lock_guard{victim.mutex};
+    if (!victim.tasks.empty()) {
+      task = victim.tasks.front();
+      victim.tasks.pop_front();
+      --nb_queued;
+      ++workers[worker]->steals;
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace details
+} // namespace game
@@ -6,8 +6,11 @@
 #include <regex>
 #include <string>
 
+#include "details/binary_io.hpp"
 #include "event.hpp"
 
+#include "fmt/format.h"
+
 namespace game {
 // ==-----------------------------------------------------------------------==
 //              Event lines parsers - Regex-based and Custom
@@ -47,7 +50,7 @@ parse_event_line(std::string const &line, game::parser_regex) {
 
 template <>
 std::variant<std::monostate, PositionEvent, InterruptionEvent, ResumeEvent>
-parse_event_line(std::string const &line, game::parser_custom) {
+parse_event_line(std::string const &line, game::parser_custom parser) {
   using boost::is_any_of, boost::token_compress_on;
   auto tokens = std::vector<std::string>{};
 
@@ -61,8 +64,10 @@ parse_event_line(std::string const &line, game::parser_custom) {
     auto x = std::stoi(tokens[Dataset::se_x_idx]);
     auto y = std::stoi(tokens[Dataset::se_y_idx]);
     auto z = std::stoi(tokens[Dataset::se_z_idx]);
+    auto speed =
+        parser.with_speed ? std::stoi(tokens[Dataset::se_speed_idx]) : 0;
 
-    return PositionEvent{sid, std::chrono::picoseconds{ts}, x, y, z};
+    return PositionEvent{sid, std::chrono::picoseconds{ts}, x, y, z, speed};
   } else if (event_type == "GI") {
     // Unpack GI fields
     auto event_id = std::stoi(tokens[Dataset::gi_event_id_idx]);
@@ -91,7 +96,8 @@ EventFetcher::EventFetcher(std::string const &path, game::file_stream,
                            int time_units, std::size_t batch_size,
                            Context &context)
     : time_units{time_units}, batch_size{batch_size}, context{context},
-      snapshot{context.take_snapshot()}, period_start{game_start} {
+      snapshot{context.take_snapshot()},
+      period_start{context.get_timeline().game_start} {
   // Open a file stream
   is = std::make_unique<std::ifstream>(path, std::ios_base::in);
 
@@ -104,7 +110,8 @@ EventFetcher::EventFetcher(std::string const &dataset, game::string_stream,
                            int time_units, std::size_t batch_size,
                            Context &context)
     : time_units{time_units}, batch_size{batch_size}, context{context},
-      snapshot{context.take_snapshot()}, period_start{game_start} {
+      snapshot{context.take_snapshot()},
+      period_start{context.get_timeline().game_start} {
   // Open a string stream
   is = std::make_unique<std::istringstream>(dataset);
 
@@ -112,41 +119,68 @@ EventFetcher::EventFetcher(std::string const &dataset, game::string_stream,
   batch.reserve(batch_size);
 }
 
+EventFetcher::EventFetcher(EventStore const &store, int time_units,
+                           std::size_t batch_size, Context &context)
+    : context{context}, snapshot{context.take_snapshot()},
+      time_units{time_units}, period_start{context.get_timeline().game_start},
+      batch_size{batch_size}, store_reader{store.read()} {
+  // Reserve storage in batch
+  batch.reserve(batch_size);
+}
+
 std::optional<PositionEvent> EventFetcher::parse_next_event() {
+  auto event = EventStore::Event{};
   while (true) {
-    if (*is) {
-      // Get an event line
+    // Get an event, from the store or from a line
+    auto read_ok = false;
+    if (store_reader) {
+      read_ok = store_reader->next(event);
+    } else {
       std::string line{};
-      auto &read_ok = std::getline(*is, line);
-
+      read_ok = read_line(line);
       if (read_ok) {
-        auto event = parse_event_line(line, game::parser_custom{});
+        event = parse_event_line(line, game::parser_custom{is_speed_parsed});
+      }
+    }
 
-        if (std::holds_alternative<InterruptionEvent>(event)) {
-          // If interruption, go next
-          if (!game_paused) {
-            game_paused = true;
-          }
-        } else if (std::holds_alternative<ResumeEvent>(event)) {
-          // If resume, go next
-          if (game_paused) {
-            game_paused = false;
-          }
-        } else if (std::holds_alternative<PositionEvent>(event)) {
-          auto pos_event = std::get<PositionEvent>(event);
-          auto event_sid = pos_event.get_sid();
-          if (context.get_balls().is_ball(event_sid) ||
-              context.get_players().is_player(event_sid)) {
-            return pos_event;
+    if (read_ok) {
+      if (std::holds_alternative<InterruptionEvent>(event)) {
+        // If interruption, go next
+        if (!game_paused) {
+          game_paused = true;
+        }
+        if (recorded_store) {
+          recorded_store->append(event);
+        }
+      } else if (std::holds_alternative<ResumeEvent>(event)) {
+        // If resume, go next
+        if (game_paused) {
+          game_paused = false;
+        }
+        if (recorded_store) {
+          recorded_store->append(event);
+        }
+      } else if (std::holds_alternative<PositionEvent>(event)) {
+        auto pos_event = std::get<PositionEvent>(event);
+        if (reader) {
+          // Track event time progress for timed period ends
+          has_position_event = true;
+          last_event_ts = pos_event.get_timestamp();
+          last_event_time = details::LineReader::clock::now();
+        }
+        auto event_sid = pos_event.get_sid();
+        if (context.get_balls().is_ball(event_sid) ||
+            context.get_players().is_player(event_sid)) {
+          if (recorded_store) {
+            recorded_store->append(event);
           }
-        } else {
-          throw unexpected_event_error{};
+          return pos_event;
         }
       } else {
-        // Cannot read a new line.
-        return {};
+        throw unexpected_event_error{};
       }
     } else {
+      // Cannot read a new line, or none arrived in time.
       return {};
     }
   }
@@ -177,7 +211,7 @@ Batch EventFetcher::parse_batch() {
         }
       } else {
         if (is_break(*position_event)) {
-          period_start = break_end;
+          period_start = context.get_timeline().break_end;
           if (!batch.empty()) {
             return batch_game_break(*position_event);
           }
@@ -185,27 +219,225 @@ Batch EventFetcher::parse_batch() {
         // In any case update sensor position
         update_sensor_position(*position_event);
       }
+    } else if (is_timed_out) {
+      return batch_period_timeout();
     } else {
       return batch_game_over();
     }
   }
 }
 
+std::optional<StreamEvent> EventFetcher::parse_stream_event() {
+  // Periods are only closed by events in per-event processing
+  is_timer_enabled = false;
+  auto position_event = parse_next_event();
+  if (!position_event) {
+    game_over = true;
+    return {};
+  }
+
+  // Where parse_batch() cuts a non-empty batch, the stream is cut if there are
+  // pending in-play events
+  auto event_ts = position_event->get_timestamp();
+  auto stream_event = StreamEvent{*position_event};
+  auto cut = [&]() {
+    stream_event.period_final_ts = pending_final_ts.value_or(event_ts);
+    pending_final_ts.reset();
+  };
+
+  if (is_in_game(*position_event)) {
+    last_in_game_ts = event_ts;
+    if (is_period_over(*position_event)) {
+      period_start += std::chrono::seconds(time_units);
+      stream_event.is_period_over = true;
+      cut();
+    } else if (game_paused) {
+      // Only the event pausing a non-empty batch updates a position
+      stream_event.is_position_update = pending_final_ts.has_value();
+      cut();
+    }
+
+    if (!game_paused) {
+      stream_event.is_in_play = true;
+      pending_final_ts = event_ts;
+    }
+  } else if (is_break(*position_event)) {
+    period_start = context.get_timeline().break_end;
+    if (pending_final_ts) {
+      stream_event.is_period_over = true;
+      stream_event.is_half_over = true;
+      cut();
+    }
+  }
+  return stream_event;
+}
+
+void EventFetcher::save(std::ostream &os) const {
+  details::write_raw(os, game_paused);
+  details::write_raw(os, game_over);
+  details::write_raw(os, period_start);
+  details::write_raw(os, last_in_game_ts);
+  details::write_raw(os, has_position_event);
+  details::write_raw(os, last_event_ts);
+  details::write_vector(os, bucket);
+
+  details::write_raw(os, static_cast<std::uint64_t>(snapshot.size()));
+  for (auto const &[name, position] : snapshot) {
+    details::write_string(os, name);
+    details::write_raw(os, position);
+  }
+  details::write_raw(os, consumed_bytes);
+}
+
+void EventFetcher::restore(std::istream &is) {
+  if (store_reader) {
+    throw std::logic_error{
+        "EventFetcher state cannot be restored when replaying an EventStore"};
+  }
+  if (reader) {
+    throw std::logic_error{
+        "EventFetcher state must be restored before setting an emission delay"};
+  }
+
+  details::read_raw(is, game_paused);
+  details::read_raw(is, game_over);
+  details::read_raw(is, period_start);
+  details::read_raw(is, last_in_game_ts);
+  details::read_raw(is, has_position_event);
+  details::read_raw(is, last_event_ts);
+  details::read_vector(is, bucket);
+
+  auto nb_entries = std::uint64_t{};
+  details::read_raw(is, nb_entries);
+  snapshot.clear();
+  for (std::uint64_t i = 0; i < nb_entries; ++i) {
+    auto name = std::string{};
+    auto position = Positions{};
+    details::read_string(is, name);
+    details::read_raw(is, position);
+    snapshot.emplace(std::move(name), position);
+  }
+  details::read_raw(is, consumed_bytes);
+
+  batch.clear();
+  pending_final_ts.reset();
+  this->is->clear();
+  if (!this->is->seekg(static_cast<std::streamoff>(consumed_bytes))) {
+    throw std::runtime_error{
+        fmt::format("Cannot move the stream to byte {}", consumed_bytes)};
+  }
+}
+
+void EventFetcher::seek(std::uint64_t offset,
+                        std::chrono::picoseconds period_start,
+                        bool is_paused) {
+  if (store_reader) {
+    throw std::logic_error{
+        "EventFetcher stream cannot be moved when replaying an EventStore"};
+  }
+  if (reader) {
+    throw std::logic_error{
+        "EventFetcher stream must be moved before setting an emission delay"};
+  }
+
+  game_paused = is_paused;
+  game_over = false;
+  this->period_start = period_start;
+  last_in_game_ts = period_start;
+  batch.clear();
+  bucket.clear();
+  pending_final_ts.reset();
+  snapshot = context.take_snapshot();
+  consumed_bytes = offset;
+  is->clear();
+  if (!is->seekg(static_cast<std::streamoff>(offset))) {
+    throw std::runtime_error{
+        fmt::format("Cannot move the stream to byte {}", offset)};
+  }
+}
+
+void EventFetcher::set_emission_delay(
+    std::chrono::milliseconds delay,
+    details::LineReader::StartHook const &on_reader_start) {
+  if (store_reader) {
+    return;
+  }
+  emission_delay = delay;
+  if (!reader) {
+    reader =
+        std::make_unique<details::LineReader>(std::move(is), on_reader_start);
+  }
+}
+
+bool EventFetcher::read_line(std::string &line) {
+  is_timed_out = false;
+  if (!reader) {
+    if (!std::getline(*is, line)) {
+      return false;
+    }
+    consumed_bytes += line.size() + 1;
+    return true;
+  }
+
+  auto deadline = details::LineReader::clock::time_point::max();
+  if (auto period_end = timed_period_end(); is_timer_enabled && period_end) {
+    deadline = last_event_time +
+               std::chrono::duration_cast<details::LineReader::clock::duration>(
+                   *period_end - last_event_ts) +
+               emission_delay;
+  }
+
+  switch (reader->read_line(line, deadline)) {
+  case details::LineReader::Status::line:
+    consumed_bytes += line.size() + 1;
+    return true;
+  case details::LineReader::Status::timeout:
+    is_timed_out = true;
+    return false;
+  default:
+    return false;
+  }
+}
+
+std::optional<std::chrono::picoseconds>
+EventFetcher::timed_period_end() const {
+  if (!has_position_event) {
+    return {};
+  }
+  auto const &timeline = context.get_timeline();
+  auto period_end = period_start + std::chrono::seconds(time_units);
+  auto first_half = timeline.game_start <= last_event_ts &&
+                    last_event_ts <= timeline.break_start &&
+                    period_end <= timeline.break_start;
+  auto second_half = timeline.break_end <= last_event_ts &&
+                     period_end <= timeline.game_end;
+  if (first_half || second_half) {
+    return period_end;
+  }
+  return {};
+}
+
+void EventFetcher::set_batch_size(std::size_t batch_size) {
+  this->batch_size = batch_size;
+  batch.reserve(batch_size);
+}
+
 EventFetcher::iterator EventFetcher::begin() { return iterator{*this}; }
 
 EventFetcher::iterator EventFetcher::end() { return iterator::end(); }
 
 bool EventFetcher::is_in_game(PositionEvent const &event) const {
-  auto first_half = game_start <= event.get_timestamp() &&
-                    event.get_timestamp() <= break_start;
-  auto second_half =
-      break_end <= event.get_timestamp() && event.get_timestamp() <= game_end;
+  auto const &timeline = context.get_timeline();
+  auto ts = event.get_timestamp();
+  auto first_half = timeline.game_start <= ts && ts <= timeline.break_start;
+  auto second_half = timeline.break_end <= ts && ts <= timeline.game_end;
   return first_half || second_half;
 }
 
 bool EventFetcher::is_break(PositionEvent const &event) const {
-  return break_start < event.get_timestamp() &&
-         event.get_timestamp() < break_end;
+  auto const &timeline = context.get_timeline();
+  return timeline.break_start < event.get_timestamp() &&
+         event.get_timestamp() < timeline.break_end;
 }
 
 bool EventFetcher::is_period_over(PositionEvent const &event) {
@@ -247,7 +479,7 @@ Batch EventFetcher::batch_game_break(PositionEvent const &event) {
       batch.empty() ? event.get_timestamp() : batch.front().get_timestamp();
   auto final_ts =
       batch.empty() ? event.get_timestamp() : batch.back().get_timestamp();
-  return {batch, true, std::move(prev_snapshot), initial_ts, final_ts};
+  return {batch, true, std::move(prev_snapshot), initial_ts, final_ts, true};
 }
 
 Batch EventFetcher::batch_game_over() {
@@ -257,7 +489,22 @@ Batch EventFetcher::batch_game_over() {
       batch.empty() ? last_in_game_ts : batch.front().get_timestamp();
   auto final_ts =
       batch.empty() ? last_in_game_ts : batch.back().get_timestamp();
-  return {batch, true, std::move(prev_snapshot), initial_ts, final_ts};
+  return {batch, true, std::move(prev_snapshot), initial_ts, final_ts, true};
+}
+
+Batch EventFetcher::batch_period_timeout() {
+  period_start += std::chrono::seconds(time_units);
+  if (batch.empty() && !bucket.empty()) {
+    // Events opening the period were not added to a batch yet. Snapshot have
+    // already been taken.
+    std::move(bucket.begin(), bucket.end(), std::back_inserter(batch));
+    bucket.clear();
+  }
+  auto initial_ts =
+      batch.empty() ? last_in_game_ts : batch.front().get_timestamp();
+  auto final_ts =
+      batch.empty() ? last_in_game_ts : batch.back().get_timestamp();
+  return {batch, true, snapshot, initial_ts, final_ts};
 }
 
 Batch EventFetcher::batch_full_size() {
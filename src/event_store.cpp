@@ -0,0 +1,191 @@
+#include "event_store.hpp"
+#include "event_fetcher.hpp"
+#include "stream_types.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace game {
+namespace {
+/// Codes of the sensor ids column, position events being coded sid + 2
+constexpr std::uint32_t interruption_code = 0;
+constexpr std::uint32_t resume_code = 1;
+constexpr std::uint32_t position_code = 2;
+
+enum Column : std::size_t { codes, timestamps, xs, ys, zs };
+
+std::uint64_t zigzag(std::int64_t value) {
+  return (static_cast<std::uint64_t>(value) << 1) ^
+         static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) {
+  return static_cast<std::int64_t>(value >> 1) ^
+         -static_cast<std::int64_t>(value & 1);
+}
+
+void put_varint(std::vector<std::uint8_t> &bytes, std::uint64_t value) {
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+std::uint64_t get_varint(std::uint8_t const *&cursor) {
+  auto value = std::uint64_t{0};
+  for (int shift = 0;; shift += 7) {
+    auto byte = *cursor++;
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return value;
+    }
+  }
+}
+} // namespace
+
+void EventStore::append(Event const &event) {
+  if (auto const *position = std::get_if<PositionEvent>(&event)) {
+    open_codes.push_back(position_code +
+                         static_cast<std::uint32_t>(position->get_sid()));
+    open_timestamps.push_back(position->get_timestamp().count());
+    open_positions.push_back(
+        {position->get_x(), position->get_y(), position->get_z()});
+  } else if (auto const *interruption =
+                 std::get_if<InterruptionEvent>(&event)) {
+    open_codes.push_back(interruption_code);
+    open_timestamps.push_back(interruption->get_timestamp().count());
+  } else if (auto const *resume = std::get_if<ResumeEvent>(&event)) {
+    open_codes.push_back(resume_code);
+    open_timestamps.push_back(resume->get_timestamp().count());
+  } else {
+    return;
+  }
+
+  if (open_codes.size() == block_size) {
+    seal_block();
+  }
+}
+
+std::size_t EventStore::get_memory_size() const {
+  auto bytes = open_codes.size() * sizeof(std::uint32_t) +
+               open_timestamps.size() * sizeof(std::int64_t) +
+               open_positions.size() * sizeof(std::array<int, 3>);
+  for (auto const &block : blocks) {
+    for (auto const &column : block) {
+      bytes += column.size();
+    }
+  }
+  return bytes;
+}
+
+void EventStore::seal_block() {
+  auto &block = blocks.emplace_back();
+  auto last_positions = std::vector<std::array<int, 3>>{};
+  auto last_timestamp = std::int64_t{0};
+  std::size_t p = 0;
+  for (std::size_t i = 0; i < open_codes.size(); ++i) {
+    auto code = open_codes[i];
+    put_varint(block[codes], code);
+    put_varint(block[timestamps], zigzag(open_timestamps[i] - last_timestamp));
+    last_timestamp = open_timestamps[i];
+    if (code < position_code) {
+      continue;
+    }
+
+    auto sid = code - position_code;
+    if (sid >= last_positions.size()) {
+      last_positions.resize(sid + 1, {0, 0, 0});
+    }
+    auto const &position = open_positions[p++];
+    for (std::size_t c = 0; c < 3; ++c) {
+      put_varint(block[xs + c], zigzag(static_cast<std::int64_t>(position[c]) -
+                                       last_positions[sid][c]));
+    }
+    last_positions[sid] = position;
+  }
+
+  for (auto &column : block) {
+    column.shrink_to_fit();
+  }
+  open_codes.clear();
+  open_timestamps.clear();
+  open_positions.clear();
+}
+
+EventStore::Reader::Reader(EventStore const &store) : store{&store} {
+  open_block();
+}
+
+void EventStore::Reader::open_block() {
+  index = 0;
+  nb_positions = 0;
+  timestamp = 0;
+  std::fill(positions.begin(), positions.end(), std::array<int, 3>{0, 0, 0});
+  if (block < store->blocks.size()) {
+    for (std::size_t c = 0; c < cursors.size(); ++c) {
+      cursors[c] = store->blocks[block][c].data();
+    }
+  }
+}
+
+bool EventStore::Reader::next(Event &event) {
+  if (index == block_size) {
+    ++block;
+    open_block();
+  }
+
+  auto code = std::uint32_t{};
+  if (block < store->blocks.size()) {
+    // A compressed block
+    code = static_cast<std::uint32_t>(get_varint(cursors[codes]));
+    timestamp += unzigzag(get_varint(cursors[timestamps]));
+    if (code >= position_code) {
+      auto sid = code - position_code;
+      if (sid >= positions.size()) {
+        positions.resize(sid + 1, {0, 0, 0});
+      }
+      auto &position = positions[sid];
+      for (std::size_t c = 0; c < 3; ++c) {
+        position[c] += static_cast<int>(unzigzag(get_varint(cursors[xs + c])));
+      }
+    }
+  } else if (index < store->open_codes.size()) {
+    // The block being filled
+    code = store->open_codes[index];
+    timestamp = store->open_timestamps[index];
+    if (code >= position_code) {
+      auto sid = code - position_code;
+      if (sid >= positions.size()) {
+        positions.resize(sid + 1, {0, 0, 0});
+      }
+      positions[sid] = store->open_positions[nb_positions++];
+    }
+  } else {
+    return false;
+  }
+  ++index;
+
+  auto ts = std::chrono::picoseconds{timestamp};
+  if (code == interruption_code) {
+    event = InterruptionEvent{ts};
+  } else if (code == resume_code) {
+    event = ResumeEvent{ts};
+  } else {
+    auto sid = code - position_code;
+    auto const &[x, y, z] = positions[sid];
+    event = PositionEvent{static_cast<int>(sid), ts, x, y, z};
+  }
+  return true;
+}
+
+EventStore load_event_store(std::string const &path, Context &context) {
+  auto store = EventStore{};
+  auto fetcher = EventFetcher{path, file_stream{}, 1, 1, context};
+  fetcher.set_event_store(&store);
+  while (fetcher.parse_next_event()) {
+    // Events are stored as they are parsed
+  }
+  return store;
+}
+} // namespace game
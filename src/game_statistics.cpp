@@ -3,128 +3,882 @@
 //
 
 #include "game_statistics.hpp"
+#include "details/binary_io.hpp"
 #include "distance.hpp"
 
+#include <algorithm>
 #include <batch.hpp>
+#include <cmath>
+#include <functional>
+#include <mutex>
 #include <game_statistics.hpp>
+#include <numeric>
+#include <omp.h>
+#include <stdexcept>
 #include <string>
 
+#include "fmt/format.h"
+
 namespace game {
 using namespace std::literals;
 
+GameStatistics::GameStatistics(std::vector<double> maximum_distances,
+                               std::vector<int> time_units, Context &context)
+    : context{context}, maximum_distances{std::move(maximum_distances)},
+      time_units{std::move(time_units)} {
+  auto sort_unique = [](auto &values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+  };
+  sort_unique(this->maximum_distances);
+  sort_unique(this->time_units);
+
+  base_units = std::accumulate(this->time_units.cbegin(),
+                               this->time_units.cend(), 0,
+                               [](int a, int b) { return std::gcd(a, b); });
+
+  player_names = context.get_player_names();
+  auto nb_players = player_names.size();
+  auto nb_ks = this->maximum_distances.size();
+  auto nb_ts = this->time_units.size();
+  partials.resize(nb_ks * nb_ts);
+  last_partials.resize(nb_ks * nb_ts);
+  buckets.resize(nb_ks * nb_players, 0);
+  accumulators.resize(nb_ts * nb_ks * nb_players, 0);
+  game_accumulators.resize(nb_ks * nb_players, 0);
+  elapsed_periods.resize(nb_ts, 0);
+  periods_over.resize(nb_ts, false);
+}
+
 void GameStatistics::accumulate_stats(const game::Batch &batch) {
-  auto ball_possession = details::BallPossession{};
+  begin_batch(batch.initial_ts);
 
-  // For each player, scan the batch only for events of sensors worn by that
-  // player
-#pragma omp parallel for shared(context, ball_possession)
+  // Each player starts scanning the batch from the snapshot positions
+  tracks.resize(player_names.size());
   for (std::size_t i = 0; i < player_names.size(); ++i) {
-    auto const &name = player_names[i];
-    auto const &sids = context.get_player_sids(name);
-    auto ball_position = batch.snapshot.at("Ball");
-    auto position = batch.snapshot.at(name);
-
-    auto mine = [&sids](int sid) {
-      return std::find(sids.cbegin(), sids.cend(), sid) != sids.cend();
-    };
-
-    auto as_vector = [](auto &&pos) -> std::tuple<double, double, double> {
-      return std::visit([](auto &&p) { return p.vector(); }, pos);
-    };
-
-    auto distances = details::DistanceResults{name};
-    for (auto const &event : *batch.data) {
-      auto event_sid = event.get_sid();
-
-      // If player sensor, check if mine
-      if (context.get_players().is_player(event_sid)) {
-        // If mine, update my position
-        if (mine(event_sid)) {
-          update_sensor_position(position, event);
+    tracks[i] = {batch.snapshot.at(player_names[i]), batch.snapshot.at("Ball")};
+  }
+
+  if (is_sampling) {
+    sample_ball_events(batch);
+  }
+
+  if (worker_pool != nullptr) {
+    scan_batch_stealing(batch);
+  } else {
+    scan_batch_openmp(batch);
+  }
+
+  // If last batch for this period, output partial statistics
+  if (batch.is_period_last_batch) {
+    compute_partial_statistics(batch.is_half_last_batch);
+  }
+}
+
+void GameStatistics::scan_batch_openmp(Batch const &batch) {
+  auto nb_events = batch.data->size();
+  auto nb_threads = static_cast<std::size_t>(omp_get_max_threads());
+  if (thread_arenas.size() < nb_threads) {
+    thread_arenas.resize(nb_threads);
+  }
+
+  // The batch is processed in tiles of events, so that scratch data is bounded
+  // by the tile size whatever the batch size is. Closest players of a tile are
+  // folded into the accumulator before moving to the next one.
+  for (std::size_t first = 0; first < nb_events; first += tile_size) {
+    auto last = std::min(first + tile_size, nb_events);
+
+    possession_arena.reset();
+    auto ball_possession =
+        details::BallPossession{possession_arena, last - first};
+
+    // For each player, scan the tile only for events of sensors worn by that
+    // player
+#pragma omp parallel for shared(batch, ball_possession)
+    for (std::size_t i = 0; i < player_names.size(); ++i) {
+      auto &arena = thread_arenas[omp_get_thread_num()];
+      arena.reset();
+
+      auto distances =
+          details::DistanceResults{i, arena.allocate<double>(last - first)};
+      scan_tile(batch, first, last, tracks[i], distances);
+
+#pragma omp critical(possession_update)
+      {
+        ball_possession.reduce(distances); // Reduce step
+      };
+    }
+
+    // Update partial statistics
+    accumulate_partial_statistics(ball_possession, first);
+    if (timeline != nullptr || !range_trees.empty()) {
+      record_ball_events(ball_possession, batch, first);
+    }
+  }
+}
+
+void GameStatistics::scan_batch_stealing(Batch const &batch) {
+  auto nb_events = batch.data->size();
+  auto nb_players = player_names.size();
+  auto nb_tiles = (nb_events + tile_size - 1) / tile_size;
+  if (thread_arenas.size() < worker_pool->nb_workers()) {
+    thread_arenas.resize(worker_pool->nb_workers());
+  }
+
+  possession_arena.reset();
+  tile_ring.clear();
+  for (std::size_t slot = 0; slot < tile_ring_size; ++slot) {
+    tile_ring.emplace_back(possession_arena, tile_size);
+  }
+
+  // Task tile * #players + player scans a tile for a player. The scans of the
+  // first tile are dealt to the workers, each scan then pushes the scan of the
+  // next tile of its player. Only the tiles from next_fold on are in flight:
+  // the scan of tile next_fold + ring size waits in its slot until tile
+  // next_fold, completed by its last scan, is folded into the statistics.
+  auto ring_mutex = std::mutex{};
+  auto nb_scans = std::vector<std::size_t>(tile_ring_size, 0);
+  auto waiting = std::vector<std::vector<std::size_t>>(tile_ring_size);
+  std::size_t next_fold = 0;
+  auto is_folding = false;
+
+  auto initial = std::vector<std::size_t>(nb_players);
+  std::iota(initial.begin(), initial.end(), 0);
+  auto nb_tasks = nb_tiles * nb_players;
+  worker_pool->run(
+      initial, nb_tasks, [&](std::size_t task, std::size_t worker) {
+        auto tile = task / nb_players;
+        auto player = task % nb_players;
+        auto first = tile * tile_size;
+        auto last = std::min(first + tile_size, nb_events);
+
+        auto &arena = thread_arenas[worker];
+        arena.reset();
+        auto distances = details::DistanceResults{
+            player, arena.allocate<double>(last - first)};
+        scan_tile(batch, first, last, tracks[player], distances);
+
+        auto lock = std::unique_lock{ring_mutex};
+        tile_ring[tile % tile_ring_size].reduce(distances);
+        ++nb_scans[tile % tile_ring_size];
+        if (tile + 1 < nb_tiles) {
+          if (tile + 1 < next_fold + tile_ring_size) {
+            worker_pool->push(worker, task + nb_players);
+          } else {
+            waiting[(tile + 1) % tile_ring_size].push_back(task + nb_players);
+          }
         }
-      }
 
-      // If ball sensor:
-      if (context.get_balls().is_ball(event_sid)) {
-        // Update local ball position
-        update_sensor_position(ball_position, event);
-
-        // Compute ball possession
-        auto distance =
-            distance::euclidean(as_vector(ball_position), as_vector(position));
-
-        // If distance is within maximum distance, add it. Otherwise set
-        // distance to infinity
-        if (as_meters(distance) <= maximum_distance) {
-          distances.push_back(distance);
-        } else {
-          distances.push_back(infinite_distance);
+        // Tiles are folded in order by a single worker at a time
+        if (is_folding) {
+          return;
         }
+        is_folding = true;
+        while (next_fold < nb_tiles &&
+               nb_scans[next_fold % tile_ring_size] == nb_players) {
+          auto slot = next_fold % tile_ring_size;
+          lock.unlock();
+          accumulate_partial_statistics(tile_ring[slot],
+                                        next_fold * tile_size);
+          if (timeline != nullptr || !range_trees.empty()) {
+            record_ball_events(tile_ring[slot], batch, next_fold * tile_size);
+          }
+          lock.lock();
+
+          tile_ring[slot].clear();
+          nb_scans[slot] = 0;
+          ++next_fold;
+          for (auto next : waiting[slot]) {
+            worker_pool->push(worker, next);
+          }
+          waiting[slot].clear();
+        }
+        is_folding = false;
+      });
+}
+
+void GameStatistics::accumulate_possessions(
+    std::vector<int> const &possessions, game::Batch const &batch) {
+  begin_batch(batch.initial_ts);
+
+  std::transform(buckets.cbegin(), buckets.cend(), possessions.cbegin(),
+                 buckets.begin(), std::plus<>{});
+
+  if (batch.is_period_last_batch) {
+    compute_partial_statistics(batch.is_half_last_batch);
+  }
+}
+
+std::vector<int> GameStatistics::take_possessions() {
+  auto possessions = buckets;
+  std::fill(buckets.begin(), buckets.end(), 0);
+  return possessions;
+}
+
+void GameStatistics::close_period(std::chrono::picoseconds timestamp,
+                                  bool is_half_over) {
+  begin_batch(timestamp);
+  compute_partial_statistics(is_half_over);
+}
+
+void GameStatistics::begin_batch(std::chrono::picoseconds initial_ts) {
+  std::fill(periods_over.begin(), periods_over.end(), false);
+  window_over = false;
+  if (!is_second_half && initial_ts >= context.get_timeline().break_end) {
+    // Periods and windows restart with the second half
+    is_second_half = true;
+    std::fill(elapsed_periods.begin(), elapsed_periods.end(), 0);
+    windows.clear();
+    elapsed_window_units = 0;
+  }
+}
+
+void GameStatistics::scan_tile(Batch const &batch, std::size_t first,
+                               std::size_t last, details::PlayerTrack &track,
+                               details::DistanceResults &distances) const {
+  auto const &name = player_names[distances.get_player()];
+  auto const &sids = context.get_player_sids(name);
+
+  auto mine = [&sids](int sid) {
+    return std::find(sids.cbegin(), sids.cend(), sid) != sids.cend();
+  };
+
+  auto as_vector = [](auto &&pos) -> std::tuple<double, double, double> {
+    return std::visit([](auto &&p) { return p.vector(); }, pos);
+  };
+
+  // In approximate mode, only sampled ball events are evaluated, unless the
+  // exact possessions are needed for calibration
+  auto const *weights =
+      is_sampling && calibration_left == 0
+          ? sample_weights.data() + tile_ball_offsets[first / tile_size]
+          : nullptr;
+
+  for (auto e = first; e < last; ++e) {
+    auto const &event = (*batch.data)[e];
+    auto event_sid = event.get_sid();
+
+    // If player sensor, check if mine
+    if (context.get_players().is_player(event_sid)) {
+      // If mine, update my position
+      if (mine(event_sid)) {
+        update_sensor_position(track.player, event);
       }
     }
 
-#pragma omp critical(possession_update)
-    {
-      ball_possession.reduce(distances); // Reduce step
-    };
-  }
+    // If ball sensor:
+    if (context.get_balls().is_ball(event_sid)) {
+      // Update local ball position
+      update_sensor_position(track.ball, event);
+      if (weights != nullptr && weights[distances.size()] == 0) {
+        distances.push_back(infinite_distance);
+        continue;
+      }
 
-  // Update partial statistics
-  accumulate_partial_statistics(ball_possession);
+      // Compute ball possession
+      auto distance =
+          distance::euclidean(as_vector(track.ball), as_vector(track.player));
 
-  // If last batch for this period, output partial statistics
-  if (batch.is_period_last_batch) {
-    compute_partial_statistics();
+      // If distance is within the largest maximum distance, add it.
+      // Otherwise set distance to infinity
+      if (as_meters(distance) <= maximum_distances.back()) {
+        distances.push_back(distance);
+      } else {
+        distances.push_back(infinite_distance);
+      }
+    }
   }
 }
 
 std::unordered_map<std::string, double>
-GameStatistics::accumulated_stats() const {
-  auto total =
-      std::accumulate(accumulator.cbegin(), accumulator.cend(), 0,
-                      [](int acc, auto &&pair) { return acc + pair.second; });
+GameStatistics::accumulated_stats(std::size_t k, std::size_t t) const {
+  return as_percentages(possessions(k, t));
+}
 
-  auto partials = std::unordered_map<std::string, double>();
+std::unordered_map<std::string, double> const &
+GameStatistics::last_partial(std::size_t k, std::size_t t) const {
+  return last_partials[k * time_units.size() + t];
+}
+
+std::size_t GameStatistics::get_nb_partials(std::size_t k,
+                                            std::size_t t) const {
+  return partials[k * time_units.size() + t].size() / player_names.size();
+}
 
-  for (auto const &[name, nb_possessions] : accumulator) {
-    partials.insert({name, static_cast<double>(nb_possessions) / total});
+float const *GameStatistics::get_partial(std::size_t period, std::size_t k,
+                                         std::size_t t) const {
+  return partials[k * time_units.size() + t].data() +
+         period * player_names.size();
+}
+
+void GameStatistics::set_archive(std::filesystem::path const &path,
+                                 bool is_resumed) {
+  auto nb_ts = time_units.size();
+  auto is_suffixed = partials.size() > 1;
+  archives.clear();
+  for (std::size_t k = 0; k < maximum_distances.size(); ++k) {
+    for (std::size_t t = 0; t < nb_ts; ++t) {
+      auto config_path = path;
+      if (is_suffixed) {
+        config_path.replace_filename(
+            fmt::format("{}_K{}_T{}{}", path.stem().string(),
+                        maximum_distances[k], time_units[t],
+                        path.extension().string()));
+      }
+      if (is_resumed && std::filesystem::exists(config_path)) {
+        archives.push_back(std::make_unique<PartialsArchiveWriter>(
+            config_path, player_names, maximum_distances[k], time_units[t],
+            get_nb_partials(k, t)));
+        continue;
+      }
+      auto &archive = archives.emplace_back(
+          std::make_unique<PartialsArchiveWriter>(
+              config_path, player_names, maximum_distances[k], time_units[t]));
+      for (std::size_t p = 0; p < get_nb_partials(k, t); ++p) {
+        archive->append(get_partial(p, k, t));
+      }
+    }
   }
+}
 
-  return partials;
+std::unordered_map<std::string, double>
+GameStatistics::game_stats(std::size_t k) const {
+  auto nb_players = player_names.size();
+  auto first = game_accumulators.cbegin() + k * nb_players;
+  return as_percentages(std::vector<int>(first, first + nb_players));
 }
 
-std::unordered_map<std::string, double> const &
-GameStatistics::last_partial() const {
-  return partials.back();
+std::vector<int> GameStatistics::possessions(std::size_t k,
+                                             std::size_t t) const {
+  auto nb_players = player_names.size();
+  auto const *period = &accumulators[(t * maximum_distances.size() + k) *
+                                     nb_players];
+
+  // Possessions of the current base period within K are those bucketed by any
+  // K up to it
+  auto result = std::vector<int>(period, period + nb_players);
+  for (std::size_t j = 0; j <= k; ++j) {
+    for (std::size_t p = 0; p < nb_players; ++p) {
+      result[p] += buckets[j * nb_players + p];
+    }
+  }
+  return result;
 }
 
-std::unordered_map<std::string, double> GameStatistics::game_stats() const {
+std::unordered_map<std::string, double>
+GameStatistics::as_percentages(std::vector<int> const &possessions) const {
+  auto total = std::accumulate(possessions.cbegin(), possessions.cend(), 0);
+
   auto stats = std::unordered_map<std::string, double>();
-  auto total =
-      std::accumulate(game_accumulator.cbegin(), game_accumulator.cend(), 0,
-                      [](int acc, auto &&pair) { return acc + pair.second; });
 
-  for (auto const &[name, nb_possessions] : game_accumulator) {
-    stats.insert({name, static_cast<double>(nb_possessions) / total});
+  for (std::size_t i = 0; i < player_names.size(); ++i) {
+    if (auto nb_possessions = possessions[i]; nb_possessions > 0) {
+      stats.insert(
+          {player_names[i], static_cast<double>(nb_possessions) / total});
+    }
   }
 
   return stats;
 }
 
+void GameStatistics::set_sliding_windows(std::vector<int> lengths, int step) {
+  if (step < 1) {
+    throw std::invalid_argument{"Sliding windows must slide by at least 1 s"};
+  }
+  std::sort(lengths.begin(), lengths.end());
+  lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+  for (auto length : lengths) {
+    if (length < step || length % step != 0) {
+      throw std::invalid_argument{fmt::format(
+          "Window length {} s is not a multiple of {} s", length, step)};
+    }
+  }
+
+  window_lengths = std::move(lengths);
+  window_step = step;
+  window_counts.clear();
+  windows = {};
+  if (window_lengths.empty()) {
+    return;
+  }
+
+  // Windows slide by whole base periods
+  base_units = std::gcd(base_units, step);
+  auto slots = std::vector<std::size_t>{};
+  for (auto length : window_lengths) {
+    slots.push_back(static_cast<std::size_t>(length / base_units));
+  }
+  window_counts.resize(maximum_distances.size() * player_names.size(), 0);
+  windows = details::SlidingWindows{std::move(slots), window_counts.size()};
+}
+
+std::unordered_map<std::string, double>
+GameStatistics::window_stats(std::size_t w, std::size_t k) const {
+  auto nb_players = player_names.size();
+  auto const *first = windows.get_sums(w) + k * nb_players;
+  return as_percentages(std::vector<int>(first, first + nb_players));
+}
+
+std::size_t GameStatistics::scratch_allocations() const {
+  return std::accumulate(thread_arenas.cbegin(), thread_arenas.cend(),
+                         possession_arena.nb_allocations(),
+                         [](std::size_t acc, auto const &arena) {
+                           return acc + arena.nb_allocations();
+                         });
+}
+
 void GameStatistics::accumulate_partial_statistics(
-    const game::details::BallPossession &ball_possession) {
-  for (auto const &[d, player_name] : ball_possession) {
-    if (player_name != details::BallPossession::none_player) {
-      accumulator[player_name] += 1;
+    const game::details::BallPossession &ball_possession, std::size_t first) {
+  if (!is_sampling) {
+    for (auto const &[d, player] : ball_possession) {
+      // A non-none player is always within the largest K
+      if (player != details::BallPossession::none_player) {
+        accumulate_possession(player, d);
+      }
+    }
+    return;
+  }
+
+  // Calibration periods count the exact possessions, the samples only being
+  // compared against them
+  auto const *weights =
+      sample_weights.data() + tile_ball_offsets[first / tile_size];
+  for (auto const &[d, player] : ball_possession) {
+    auto weight = *weights++;
+    if (player == details::BallPossession::none_player) {
+      continue;
+    }
+    if (calibration_left > 0) {
+      calibration_exact[player] += 1;
+      calibration_samples[player] += weight;
+      accumulate_possession(player, d);
+    } else if (weight > 0) {
+      accumulate_possession(player, d, weight);
     }
   }
 }
 
-void GameStatistics::compute_partial_statistics() {
-  partials.push_back(accumulated_stats());
-  for (auto const &[player_name, hits] : accumulator) {
-    game_accumulator[player_name] += hits;
+void GameStatistics::record_ball_events(
+    details::BallPossession const &ball_possession, Batch const &batch,
+    std::size_t first) {
+  auto const &events = *batch.data;
+  auto const *weights =
+      is_sampling && calibration_left == 0
+          ? sample_weights.data() + tile_ball_offsets[first / tile_size]
+          : nullptr;
+
+  // Possessions of a tile follow the order of its ball events
+  auto e = first;
+  for (auto const &[d, player] : ball_possession) {
+    while (!context.get_balls().is_ball(events[e].get_sid())) {
+      ++e;
+    }
+    auto ts = events[e++].get_timestamp();
+    auto weight = weights != nullptr ? *weights++ : 1;
+    if (weight == 0) {
+      continue;
+    }
+    record_ball_event(player == details::BallPossession::none_player
+                          ? PossessionTimeline::none_player
+                          : player,
+                      d, ts, weight);
+  }
+}
+
+void GameStatistics::record_ball_event(std::size_t player, double distance,
+                                       std::chrono::picoseconds ts,
+                                       int weight) {
+  auto meters = as_meters(distance);
+  if (!(meters <= maximum_distances.back())) {
+    player = PossessionTimeline::none_player;
+  }
+  if (timeline != nullptr) {
+    timeline->record(player, ts);
+  }
+  if (range_trees.empty() || player == PossessionTimeline::none_player) {
+    return;
+  }
+
+  // Counts of a slot are added to the trees once the slot is over
+  auto slot = std::min(range_slot(ts), range_trees.front().size() - 1);
+  if (slot != current_slot) {
+    flush_slot_counts();
+    current_slot = slot;
+  }
+  slot_counts[smallest_k(meters) * player_names.size() + player] += weight;
+}
+
+void GameStatistics::set_range_index(std::chrono::picoseconds resolution) {
+  range_resolution = resolution;
+  range_trees.clear();
+  slot_counts.clear();
+  current_slot = 0;
+  if (resolution.count() == 0) {
+    return;
+  }
+
+  auto const &match = context.get_timeline();
+  auto nb_slots = static_cast<std::size_t>(
+      (match.game_end - match.game_start) / resolution + 1);
+  range_trees.assign(maximum_distances.size() * player_names.size(),
+                     details::FenwickTree{nb_slots});
+  slot_counts.assign(range_trees.size(), 0);
+}
+
+std::unordered_map<std::string, double>
+GameStatistics::possession_between(std::chrono::picoseconds from,
+                                   std::chrono::picoseconds to,
+                                   std::size_t k) const {
+  if (range_trees.empty()) {
+    throw std::logic_error{"Possessions are not indexed by time"};
+  }
+
+  auto first = range_slot(from);
+  auto last = range_slot(to);
+  auto is_current_in = first <= current_slot && current_slot < last;
+  auto nb_players = player_names.size();
+  auto counts = std::vector<int>(nb_players, 0);
+  for (std::size_t j = 0; j <= k; ++j) {
+    for (std::size_t p = 0; p < nb_players; ++p) {
+      auto i = j * nb_players + p;
+      counts[p] += static_cast<int>(range_trees[i].range_sum(first, last)) +
+                   (is_current_in ? slot_counts[i] : 0);
+    }
+  }
+  return as_percentages(counts);
+}
+
+std::size_t GameStatistics::range_slot(std::chrono::picoseconds ts) const {
+  auto game_start = context.get_timeline().game_start;
+  if (ts <= game_start) {
+    return 0;
+  }
+  auto slot = static_cast<std::size_t>((ts - game_start) / range_resolution);
+  return std::min(slot, range_trees.front().size());
+}
+
+void GameStatistics::flush_slot_counts() {
+  for (std::size_t i = 0; i < slot_counts.size(); ++i) {
+    if (slot_counts[i] != 0) {
+      range_trees[i].add(current_slot, slot_counts[i]);
+      slot_counts[i] = 0;
+    }
+  }
+}
+
+void GameStatistics::set_sampling(BallSampling sampling) {
+  this->sampling = sampling;
+  is_sampling = sampling.every > 1 || sampling.interval.count() > 0;
+  since_sample = 0;
+  next_sample_ts = {};
+  sample_credit = 0;
+  is_last_period_approximate = false;
+  calibration_left = is_sampling ? sampling.calibration_periods : 0;
+  calibration_exact.assign(player_names.size(), 0);
+  calibration_samples.assign(player_names.size(), 0);
+  sampling_report = {};
+}
+
+void GameStatistics::sample_ball_events(Batch const &batch) {
+  auto const &events = *batch.data;
+  sample_weights.clear();
+  tile_ball_offsets.clear();
+
+  for (std::size_t e = 0; e < events.size(); ++e) {
+    if (e % tile_size == 0) {
+      tile_ball_offsets.push_back(sample_weights.size());
+    }
+    auto const &event = events[e];
+    if (!context.get_balls().is_ball(event.get_sid())) {
+      continue;
+    }
+
+    ++since_sample;
+    ++sampling_report.nb_ball_events;
+    auto ts = event.get_timestamp();
+    if (sampling_report.nb_ball_events == 1) {
+      // The first ball event stands for itself
+      first_ball_ts = ts;
+      latest_ball_ts = ts;
+      last_sample_ts = ts;
+      sample_credit = 1;
+    }
+    latest_ball_ts = std::max(latest_ball_ts, ts);
+    if (since_sample < sampling.every || ts < next_sample_ts) {
+      sample_weights.push_back(0);
+      continue;
+    }
+    sample_weights.push_back(sample_weight(ts));
+    since_sample = 0;
+    next_sample_ts = ts + sampling.interval;
+    ++sampling_report.nb_samples;
+  }
+}
+
+int GameStatistics::sample_weight(std::chrono::picoseconds ts) {
+  // A sample stands for the event time since the previous one, counted in mean
+  // intervals between ball events. Rounding errors are carried over to the
+  // next sample, so that the weights add up to the time elapsed.
+  auto nb_intervals = sampling_report.nb_ball_events - 1;
+  if (nb_intervals == 0 || latest_ball_ts == first_ball_ts) {
+    sample_credit = 0;
+    last_sample_ts = ts;
+    return static_cast<int>(since_sample);
+  }
+
+  using seconds = std::chrono::duration<double>;
+  auto mean_interval = seconds{latest_ball_ts - first_ball_ts} / nb_intervals;
+  auto elapsed = std::max(ts - last_sample_ts, std::chrono::picoseconds{0});
+  sample_credit += seconds{elapsed} / mean_interval;
+  auto weight = std::max(1, static_cast<int>(std::lround(sample_credit)));
+  sample_credit -= weight;
+  last_sample_ts = ts;
+  return weight;
+}
+
+void GameStatistics::update_sampling_error() {
+  auto exact_total = std::accumulate(calibration_exact.cbegin(),
+                                     calibration_exact.cend(), 0);
+  auto samples_total = std::accumulate(calibration_samples.cbegin(),
+                                       calibration_samples.cend(), 0);
+  if (exact_total == 0 || samples_total == 0) {
+    return;
+  }
+
+  auto max_error = 0.0;
+  auto sum_error = 0.0;
+  for (std::size_t p = 0; p < player_names.size(); ++p) {
+    auto exact = static_cast<double>(calibration_exact[p]) / exact_total;
+    auto approximate =
+        static_cast<double>(calibration_samples[p]) / samples_total;
+    auto error = std::abs(approximate - exact) * 100;
+    max_error = std::max(max_error, error);
+    sum_error += error;
+  }
+  sampling_report.max_error = max_error;
+  sampling_report.mean_error = sum_error / player_names.size();
+}
+
+void GameStatistics::save(std::ostream &os) const {
+  details::write_vector(os, maximum_distances);
+  details::write_vector(os, time_units);
+  details::write_raw(os, static_cast<std::uint64_t>(player_names.size()));
+  for (auto const &name : player_names) {
+    details::write_string(os, name);
+  }
+
+  details::write_vector(os, buckets);
+  details::write_vector(os, accumulators);
+  details::write_vector(os, game_accumulators);
+  details::write_vector(os, elapsed_periods);
+  details::write_raw(os, is_second_half);
+
+  for (auto const &config_partials : partials) {
+    details::write_vector(os, config_partials);
+  }
+
+  details::write_raw(os, since_sample);
+  details::write_raw(os, next_sample_ts);
+  details::write_raw(os, first_ball_ts);
+  details::write_raw(os, latest_ball_ts);
+  details::write_raw(os, last_sample_ts);
+  details::write_raw(os, sample_credit);
+  details::write_raw(os, is_last_period_approximate);
+  details::write_raw(os, calibration_left);
+  details::write_vector(os, calibration_exact);
+  details::write_vector(os, calibration_samples);
+  details::write_raw(os, sampling_report);
+
+  auto has_timeline = timeline != nullptr;
+  details::write_raw(os, has_timeline);
+  if (has_timeline) {
+    details::write_raw(os, timeline->save());
+  }
+
+  details::write_raw(os, range_resolution);
+  for (auto const &tree : range_trees) {
+    details::write_vector(os, tree.get_nodes());
+  }
+  details::write_vector(os, slot_counts);
+  details::write_raw(os, static_cast<std::uint64_t>(current_slot));
+
+  details::write_vector(os, window_lengths);
+  details::write_raw(os, window_step);
+  windows.save(os);
+  details::write_raw(os, elapsed_window_units);
+}
+
+void GameStatistics::restore(std::istream &is) {
+  auto mismatch = [] {
+    return std::runtime_error{
+        "Checkpoint statistics were computed for other configurations"};
+  };
+
+  auto saved_distances = std::vector<double>{};
+  auto saved_time_units = std::vector<int>{};
+  details::read_vector(is, saved_distances);
+  details::read_vector(is, saved_time_units);
+  if (saved_distances != maximum_distances || saved_time_units != time_units) {
+    throw mismatch();
+  }
+  auto nb_players = std::uint64_t{};
+  details::read_raw(is, nb_players);
+  if (nb_players != player_names.size()) {
+    throw mismatch();
+  }
+  for (auto const &name : player_names) {
+    auto saved_name = std::string{};
+    details::read_string(is, saved_name);
+    if (saved_name != name) {
+      throw mismatch();
+    }
+  }
+
+  details::read_vector(is, buckets);
+  details::read_vector(is, accumulators);
+  details::read_vector(is, game_accumulators);
+  details::read_vector(is, elapsed_periods);
+  details::read_raw(is, is_second_half);
+
+  for (auto &config_partials : partials) {
+    details::read_vector(is, config_partials);
+    if (config_partials.size() % player_names.size() != 0) {
+      throw mismatch();
+    }
+  }
+  for (auto &partial : last_partials) {
+    partial.clear();
+  }
+
+  details::read_raw(is, since_sample);
+  details::read_raw(is, next_sample_ts);
+  details::read_raw(is, first_ball_ts);
+  details::read_raw(is, latest_ball_ts);
+  details::read_raw(is, last_sample_ts);
+  details::read_raw(is, sample_credit);
+  details::read_raw(is, is_last_period_approximate);
+  details::read_raw(is, calibration_left);
+  details::read_vector(is, calibration_exact);
+  details::read_vector(is, calibration_samples);
+  details::read_raw(is, sampling_report);
+
+  auto has_timeline = false;
+  details::read_raw(is, has_timeline);
+  if (has_timeline) {
+    auto state = PossessionTimeline::State{};
+    details::read_raw(is, state);
+    if (timeline != nullptr) {
+      timeline->restore(state);
+    }
+  }
+
+  auto saved_resolution = std::chrono::picoseconds{};
+  details::read_raw(is, saved_resolution);
+  if (saved_resolution != range_resolution) {
+    throw mismatch();
+  }
+  for (auto &tree : range_trees) {
+    auto nb_nodes = tree.get_nodes().size();
+    details::read_vector(is, tree.get_nodes());
+    if (tree.get_nodes().size() != nb_nodes) {
+      throw mismatch();
+    }
+  }
+  details::read_vector(is, slot_counts);
+  if (slot_counts.size() != range_trees.size()) {
+    throw mismatch();
+  }
+  auto saved_slot = std::uint64_t{};
+  details::read_raw(is, saved_slot);
+  current_slot = static_cast<std::size_t>(saved_slot);
+
+  auto saved_lengths = std::vector<int>{};
+  auto saved_step = 0;
+  details::read_vector(is, saved_lengths);
+  details::read_raw(is, saved_step);
+  if (saved_lengths != window_lengths || saved_step != window_step) {
+    throw mismatch();
+  }
+  windows.restore(is);
+  details::read_raw(is, elapsed_window_units);
+  std::fill(periods_over.begin(), periods_over.end(), false);
+  window_over = false;
+}
+
+void GameStatistics::compute_partial_statistics(bool is_half_over) {
+  if (timeline != nullptr && is_half_over) {
+    timeline->cut();
+  }
+  is_last_period_approximate = is_sampling && calibration_left == 0;
+  if (calibration_left > 0) {
+    --calibration_left;
+    ++sampling_report.calibration_periods;
+    update_sampling_error();
+  } else if (is_sampling) {
+    ++sampling_report.approximate_periods;
+  }
+
+  auto nb_players = player_names.size();
+  auto nb_ks = maximum_distances.size();
+  auto nb_ts = time_units.size();
+
+  // Fold the base period into every T period and the whole game
+  for (std::size_t k = 0; k < nb_ks; ++k) {
+    for (std::size_t p = 0; p < nb_players; ++p) {
+      auto hits = 0;
+      for (std::size_t j = 0; j <= k; ++j) {
+        hits += buckets[j * nb_players + p];
+      }
+      game_accumulators[k * nb_players + p] += hits;
+      if (!window_counts.empty()) {
+        window_counts[k * nb_players + p] = hits;
+      }
+      for (std::size_t t = 0; t < nb_ts; ++t) {
+        accumulators[(t * nb_ks + k) * nb_players + p] += hits;
+      }
+    }
+  }
+  std::fill(buckets.begin(), buckets.end(), 0);
+
+  if (!window_counts.empty()) {
+    windows.push(window_counts.data());
+    elapsed_window_units += base_units;
+    if (is_half_over || elapsed_window_units >= window_step) {
+      elapsed_window_units = 0;
+      window_over = true;
+    }
+  }
+
+  for (std::size_t t = 0; t < nb_ts; ++t) {
+    elapsed_periods[t] += 1;
+    if (!is_half_over && elapsed_periods[t] * base_units < time_units[t]) {
+      continue;
+    }
+
+    for (std::size_t k = 0; k < nb_ks; ++k) {
+      append_partial(k, t);
+    }
+    auto first = accumulators.begin() + t * nb_ks * nb_players;
+    std::fill(first, first + nb_ks * nb_players, 0);
+    elapsed_periods[t] = 0;
+    periods_over[t] = true;
+  }
+}
+
+void GameStatistics::append_partial(std::size_t k, std::size_t t) {
+  auto config = k * time_units.size() + t;
+  auto counts = possessions(k, t);
+  auto total = std::accumulate(counts.cbegin(), counts.cend(), 0);
+
+  auto &history = partials[config];
+  for (auto count : counts) {
+    history.push_back(
+        total > 0 ? static_cast<float>(static_cast<double>(count) / total)
+                  : 0.0f);
+  }
+  last_partials[config] = as_percentages(counts);
+  if (!archives.empty()) {
+    archives[config]->append(history.data() + history.size() - counts.size());
   }
-  accumulator.clear();
 }
 } // namespace game
@@ -0,0 +1,128 @@
+#include "heat_maps.hpp"
+#include "event.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace {
+/**
+ * @return the index of the cell of @p value among @p nb_cells splitting
+ *         [@p lower, @p upper], the closest one if @p value is out of it.
+ */
+std::size_t axis_cell(int value, int lower, int upper, std::size_t nb_cells) {
+  if (value <= lower) {
+    return 0;
+  }
+  if (value >= upper) {
+    return nb_cells - 1;
+  }
+  auto offset = static_cast<std::uint64_t>(value - lower);
+  return static_cast<std::size_t>(offset * nb_cells /
+                                  static_cast<std::uint64_t>(upper - lower));
+}
+} // namespace
+
+HeatMaps::HeatMaps(HeatMapGrid grid, std::vector<int> time_units,
+                   int base_time_units, Context const &context,
+                   std::ostream &os)
+    : grid{grid}, nb_cells{grid.nb_x * grid.nb_y},
+      time_units{std::move(time_units)}, base_units{base_time_units}, os{&os},
+      player_names{context.get_player_names()} {
+  if (grid.nb_x == 0 || grid.nb_y == 0) {
+    throw std::invalid_argument{fmt::format(
+        "Invalid heat map grid {}x{}: each axis needs a cell at least",
+        grid.nb_x, grid.nb_y)};
+  }
+  auto nb_players = player_names.size();
+  auto nb_ts = this->time_units.size();
+  for (std::size_t p = 0; p < nb_players; ++p) {
+    for (auto sid : context.get_player_sids(player_names[p])) {
+      if (static_cast<std::size_t>(sid) >= sensor_players.size()) {
+        sensor_players.resize(sid + 1, -1);
+      }
+      sensor_players[sid] = static_cast<int>(p);
+    }
+  }
+
+  cells.resize(nb_players, 0);
+  last_ts.resize(nb_players, std::chrono::picoseconds::min());
+  game_times.resize(nb_players * nb_cells, 0);
+  period_starts.resize(nb_ts * nb_players * nb_cells, 0);
+  last_periods.resize(nb_ts * nb_players * nb_cells, 0);
+  elapsed_periods.resize(nb_ts, 0);
+  nb_periods.resize(nb_ts, 0);
+  *this->os << "T,period,player,x,y,seconds\n";
+}
+
+std::size_t HeatMaps::cell(int x, int y) const {
+  return axis_cell(x, field_lower_x, field_upper_x, grid.nb_x) * grid.nb_y +
+         axis_cell(y, field_lower_y, field_upper_y, grid.nb_y);
+}
+
+void HeatMaps::on_batch(Batch const &batch) {
+  for (auto const &event : *batch.data) {
+    auto sid = static_cast<std::size_t>(event.get_sid());
+    if (sid >= sensor_players.size() || sensor_players[sid] < 0) {
+      continue;
+    }
+    auto p = static_cast<std::size_t>(sensor_players[sid]);
+    auto ts = event.get_timestamp();
+    if (last_ts[p] != std::chrono::picoseconds::min()) {
+      auto interval = ts - last_ts[p];
+      if (interval.count() > 0 && interval <= max_interval) {
+        game_times[p * nb_cells + cells[p]] += interval.count();
+      }
+    }
+    cells[p] = cell(event.get_x(), event.get_y());
+    last_ts[p] = ts;
+  }
+}
+
+void HeatMaps::on_period_end(Batch const &batch) {
+  auto size = player_names.size() * nb_cells;
+  for (std::size_t t = 0; t < time_units.size(); ++t) {
+    elapsed_periods[t] += 1;
+    if (!batch.is_half_last_batch &&
+        elapsed_periods[t] * base_units < time_units[t]) {
+      continue;
+    }
+
+    // The period is what the game added to the copy taken at its start
+    auto *start = period_starts.data() + t * size;
+    auto *last = last_periods.data() + t * size;
+    for (std::size_t i = 0; i < size; ++i) {
+      last[i] = game_times[i] - start[i];
+    }
+    std::copy(game_times.cbegin(), game_times.cend(), start);
+    elapsed_periods[t] = 0;
+    write(time_units[t], ++nb_periods[t], last);
+  }
+
+  if (batch.is_half_last_batch) {
+    // The game break is not spent on the field
+    std::fill(last_ts.begin(), last_ts.end(), std::chrono::picoseconds::min());
+  }
+}
+
+void HeatMaps::on_game_end() {
+  write(0, 0, game_times.data());
+  os->flush();
+}
+
+void HeatMaps::write(int time_units, std::size_t period,
+                     std::int64_t const *times) {
+  for (std::size_t p = 0; p < player_names.size(); ++p) {
+    for (std::size_t c = 0; c < nb_cells; ++c) {
+      if (auto time = times[p * nb_cells + c]; time > 0) {
+        *os << fmt::format("{},{},{},{},{},{:.3f}\n", time_units, period,
+                           player_names[p], c / grid.nb_y, c % grid.nb_y,
+                           time * 1e-12);
+      }
+    }
+  }
+}
+} // namespace game
@@ -1,40 +1,252 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <omp.h>
 
 #include <boost/program_options.hpp>
 #include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "sharding.hpp"
 #include "soccer_monitoring.hpp"
+#include "thread_pinning.hpp"
 
 #include "fmt/format.h"
 
+/**
+ * The parsed command line.
+ */
 struct Arguments {
-  int time_units;
-  double maximum_distance;
-  std::filesystem::path game_data;
-  std::filesystem::path metadata;
-  int nb_threads;
-  std::size_t batch_size;
-  std::filesystem::path output;
+  game::MonitoringOptions options = {};
+  /// The matches to monitor in a single process, if any
+  std::vector<game::MatchFiles> matches = {};
+  /// Whether the stream is loaded into an EventStore before the monitoring.
+  /// The store is replayed by a single run, for every T and K at once.
+  bool in_memory = false;
+  /// The shard to compute, if this process is a shard worker
+  std::optional<game::Shard> shard_worker = {};
 };
 
+/**
+ * Parses a game clock range "MM:SS-MM:SS".
+ *
+ * @return the start and end of the range, or nothing if @p value is invalid
+ *         or the range is empty.
+ */
+std::optional<std::pair<std::chrono::seconds, std::chrono::seconds>>
+parse_game_clock_range(std::string const &value) {
+  auto ss = std::istringstream{value};
+  int from_minutes = 0, from_seconds = 0, to_minutes = 0, to_seconds = 0;
+  char colon1 = 0, dash = 0, colon2 = 0;
+  ss >> from_minutes >> colon1 >> from_seconds >> dash >> to_minutes >>
+      colon2 >> to_seconds;
+  auto is_read = static_cast<bool>(ss);
+  auto rest = std::string{};
+  ss >> rest;
+  if (!is_read || !rest.empty() || colon1 != ':' || dash != '-' ||
+      colon2 != ':' || from_minutes < 0 || to_minutes < 0 ||
+      from_seconds < 0 || from_seconds > 59 || to_seconds < 0 ||
+      to_seconds > 59) {
+    return std::nullopt;
+  }
+  auto from = std::chrono::minutes{from_minutes} +
+              std::chrono::seconds{from_seconds};
+  auto to =
+      std::chrono::minutes{to_minutes} + std::chrono::seconds{to_seconds};
+  if (from >= to) {
+    return std::nullopt;
+  }
+  return std::make_pair(from, to);
+}
+
+/**
+ * Parses a heat map grid "XxY".
+ *
+ * @return the grid, or nothing if @p value is invalid or an axis has no cell.
+ */
+std::optional<game::HeatMapGrid> parse_heat_map_grid(std::string const &value) {
+  auto ss = std::istringstream{value};
+  int nb_x = 0, nb_y = 0;
+  char times = 0;
+  ss >> nb_x >> times >> nb_y;
+  auto is_read = static_cast<bool>(ss);
+  auto rest = std::string{};
+  ss >> rest;
+  if (!is_read || !rest.empty() || times != 'x' || nb_x < 1 || nb_y < 1) {
+    return std::nullopt;
+  }
+  return game::HeatMapGrid{static_cast<std::size_t>(nb_x),
+                           static_cast<std::size_t>(nb_y)};
+}
+
+/**
+ * A command-line setting whose combinations with other settings are checked
+ * by find_conflict().
+ */
+struct Setting {
+  /// The setting as displayed, usually its flag
+  std::string_view name;
+  /// Whether the setting is used
+  bool is_used;
+  /// The names of the settings it cannot be combined with. A conflict needs
+  /// only be declared by one of the two settings.
+  std::vector<std::string_view> conflicts;
+};
+
+/**
+ * Finds the first used setting of @p settings that conflicts with another
+ * used setting.
+ *
+ * @return the message listing every setting it cannot be combined with, or
+ *         nothing if the used settings are compatible.
+ */
+std::optional<std::string> find_conflict(std::vector<Setting> const &settings) {
+  auto is_used = [&](std::string_view name) {
+    return std::any_of(settings.begin(), settings.end(), [&](auto const &s) {
+      return s.name == name && s.is_used;
+    });
+  };
+  for (auto const &setting : settings) {
+    if (!setting.is_used) {
+      continue;
+    }
+    // Conflicts are symmetric, whichever setting declares them
+    auto conflicts = setting.conflicts;
+    for (auto const &other : settings) {
+      auto const &names = other.conflicts;
+      if (std::find(names.begin(), names.end(), setting.name) != names.end()) {
+        conflicts.push_back(other.name);
+      }
+    }
+    if (std::none_of(conflicts.begin(), conflicts.end(), is_used)) {
+      continue;
+    }
+
+    auto message = std::string{setting.name} + " cannot be combined with ";
+    message[0] = static_cast<char>(std::toupper(message[0]));
+    for (std::size_t i = 0; i < conflicts.size(); ++i) {
+      if (i > 0) {
+        message += i + 1 == conflicts.size() ? " or " : ", ";
+      }
+      message += conflicts[i];
+    }
+    return message;
+  }
+  return std::nullopt;
+}
+
 Arguments parse_arguments(int argc, char *argv[]) {
   namespace po = boost::program_options;
   namespace fs = std::filesystem;
 
   po::options_description desc("DEBS 2013 - Soccer Monitoring tool");
   desc.add_options()("help,h", "Print this message")(
-      "time-units,T", po::value<int>(), "Frequency of statistics (in seconds)")(
-      "max-distance,K", po::value<double>(),
-      "Maximum distance for ball possession eligibility")(
+      "time-units,T", po::value<std::vector<int>>()->multitoken(),
+      "Frequency of statistics (in seconds). Several values can be given")(
+      "max-distance,K", po::value<std::vector<double>>()->multitoken(),
+      "Maximum distance for ball possession eligibility. Several values can "
+      "be given")(
       "stream,s", po::value<std::string>(), "Game stream file path")(
+      "match", po::value<std::vector<std::string>>()->composing(),
+      "A match monitored along others in this process, as "
+      "STREAM,METADATA[,OUTPUT]. Repeat for each match, instead of --stream, "
+      "--metadata and --output")(
       "metadata,m", po::value<std::string>(), "Metadata file path")(
       "threads,t", po::value<int>()->default_value(0), "Number of threads")(
-      "batch-size,B", po::value<int>()->default_value(1500),
+      "pin", po::value<std::string>()->default_value("none"),
+      "Bind threads to CPUs: none, compact, spread or a list of CPU ids "
+      "(e.g. 0,2,4-7)")(
+      "scheduler", po::value<std::string>()->default_value("openmp"),
+      "Scheduler of the per-player work: openmp or stealing. --match always "
+      "uses stealing")(
+      "batch-size,B", po::value<int>()->default_value(0),
       "Events batch size (default: auto)")(
+      "target-latency", po::value<double>(),
+      "Mean per-event latency (in milliseconds) the automatic batch size aims "
+      "at (default: maximize throughput)")(
+      "max-emission-delay", po::value<int>()->default_value(0),
+      "Maximum delay (in milliseconds) after a period end before its "
+      "statistics are displayed, if the stream stalls (default: wait for the "
+      "next event)")(
+      "sample-every", po::value<int>()->default_value(1),
+      "Approximate mode: evaluate one ball event out of N, each weighted by "
+      "the ball events it stands for")(
+      "sample-interval", po::value<double>(),
+      "Approximate mode: evaluate at most one ball event per interval of "
+      "event time (in milliseconds)")(
+      "calibration-periods", po::value<int>()->default_value(0),
+      "Approximate mode: number of periods also evaluated exactly to report "
+      "the approximation error")(
+      "checkpoint", po::value<std::string>(),
+      "Checkpoint file path, written every --checkpoint-periods periods")(
+      "checkpoint-periods", po::value<int>()->default_value(10),
+      "Number of periods between two checkpoints")(
+      "resume",
+      "Restore the --checkpoint file, if any, and resume the stream from it")(
+      "archive", po::value<std::string>(),
+      "Partial statistics archive path, suffixed by _K<K>_T<T> for each "
+      "configuration if there are several")(
+      "timeline", po::value<std::string>(),
+      "Possession timeline CSV path, one player,start,end line per segment of "
+      "ball events won by the same player")(
+      "window", po::value<std::vector<int>>()->multitoken(),
+      "Length (in seconds) of a sliding window whose statistics are displayed "
+      "every --window-step seconds. Several values can be given")(
+      "window-step", po::value<int>()->default_value(1),
+      "Number of seconds between two updates of the sliding windows")(
+      "between", po::value<std::vector<std::string>>()->composing(),
+      "Game clock range MM:SS-MM:SS whose possession statistics are "
+      "displayed after the game. Several ranges can be given")(
+      "range-resolution", po::value<double>()->default_value(100),
+      "Time resolution (in milliseconds) of the possessions indexed for "
+      "--between")(
+      "running",
+      "Display the distance covered by each player and the time spent in "
+      "each speed band along ball possession, over the periods of each T")(
+      "heat-maps", po::value<std::string>(),
+      "Heat maps CSV path, one T,period,player,x,y,seconds line per grid "
+      "cell a player spent time in, over the periods of each T and the whole "
+      "game (T and period 0)")(
+      "heat-map-grid", po::value<std::string>()->default_value("8x13"),
+      "Number of cells of the heat maps along x and y, as XxY")(
+      "in-memory",
+      "Load the stream into a compressed in-memory event store first, then "
+      "monitor the game from it. The store is replayed once: pass several "
+      "-T and -K values to evaluate several configurations")(
+      "shards", po::value<int>()->default_value(1),
+      "Split the stream into N time shards computed by worker processes")(
+      "shard-lead-in", po::value<double>()->default_value(2),
+      "Minimum unpaused game (in seconds) parsed by a shard worker before "
+      "its shard, for the player positions to be exact at the shard start")(
+      "shard-command", po::value<std::string>(),
+      "Command running a shard worker, e.g. \"ssh HOST PATH\" for remote "
+      "workers, followed by the worker arguments (default: this "
+      "executable)")(
+      "shard-worker", po::value<std::string>(),
+      "Internal: compute a shard for the coordinating process")(
       "output,o", po::value<std::string>(),
-      "Output file path (default: stdout)");
+      "Output file path (default: stdout)")(
+      "period-parallel",
+      "Compute whole periods concurrently instead of parallelizing each batch "
+      "(offline analysis)")(
+      "streaming",
+      "Process events one at a time on a single thread (low latency)")(
+      "incremental",
+      "Streaming mode only: evaluate every player only when the closest one "
+      "may have changed")(
+      "spatial-index",
+      "Streaming mode only: evaluate only the players of the grid cells "
+      "around the ball")(
+      "foot-level",
+      "Streaming mode only: give possession to the player wearing the sensor "
+      "closest to the ball instead of the closest player centroid");
 
   po::variables_map vm;
   po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -45,35 +257,68 @@ Arguments parse_arguments(int argc, char *argv[]) {
     std::exit(1);
   }
 
-  int time_units = 0;
+  auto time_units = std::vector<int>{};
   if (vm.count("time-units")) {
-    time_units = vm["time-units"].as<int>();
-    if (time_units < 1 || time_units > 60) {
-      fmt::print("Invalid value for --time-units: {}. Valid range: [1, 60]",
-                 time_units);
-      std::exit(1);
+    time_units = vm["time-units"].as<std::vector<int>>();
+    for (auto t : time_units) {
+      if (t < 1 || t > 60) {
+        fmt::print("Invalid value for --time-units: {}. Valid range: [1, 60]",
+                   t);
+        std::exit(1);
+      }
     }
   } else {
     std::cout << "Missing mandatory argument: --time-units\n" << desc;
     std::exit(1);
   }
 
-  double max_distance = 0.0;
+  auto max_distances = std::vector<double>{};
   if (vm.count("max-distance")) {
-    max_distance = vm["max-distance"].as<double>();
-    if (max_distance < 1.0 || max_distance > 5.0) {
-      fmt::print(
-          "Invalid value for --max-distance: {}. Valid range: [1.0, 5.0]",
-          max_distance);
-      std::exit(1);
+    max_distances = vm["max-distance"].as<std::vector<double>>();
+    for (auto k : max_distances) {
+      if (k < 1.0 || k > 5.0) {
+        fmt::print(
+            "Invalid value for --max-distance: {}. Valid range: [1.0, 5.0]",
+            k);
+        std::exit(1);
+      }
     }
   } else {
     std::cout << "Missing mandatory argument: --max-distance\n" << desc;
     std::exit(1);
   }
 
+  auto matches = std::vector<game::MatchFiles>{};
+  if (vm.count("match")) {
+    for (auto const &value : vm["match"].as<std::vector<std::string>>()) {
+      auto fields = std::vector<std::string>{};
+      auto field = std::string{};
+      auto ss = std::istringstream{value};
+      while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+      }
+      if (fields.size() < 2 || fields.size() > 3) {
+        fmt::print("Invalid value for --match: {}. Expected "
+                   "STREAM,METADATA[,OUTPUT]",
+                   value);
+        std::exit(1);
+      }
+      for (std::size_t i = 0; i < 2; ++i) {
+        if (!fs::is_regular_file(fields[i]) || fs::is_empty(fields[i])) {
+          fmt::print("Invalid value for --match. {} file not found.",
+                     fields[i]);
+          std::exit(1);
+        }
+      }
+      matches.push_back(
+          {fields[0], fields[1], fields.size() == 3 ? fields[2] : ""});
+    }
+  }
+
   auto game_data = fs::path{};
-  if (vm.count("stream")) {
+  if (!matches.empty()) {
+    // Each match has its own stream
+  } else if (vm.count("stream")) {
     game_data = fs::path{vm["stream"].as<std::string>()};
     if (!fs::is_regular_file(game_data) || fs::is_empty(game_data)) {
       fmt::print("Invalid value for --stream. {} file not found.",
@@ -86,7 +331,9 @@ Arguments parse_arguments(int argc, char *argv[]) {
   }
 
   auto metadata = fs::path{};
-  if (vm.count("metadata")) {
+  if (!matches.empty()) {
+    // Each match has its own metadata
+  } else if (vm.count("metadata")) {
     metadata = fs::path{vm["metadata"].as<std::string>()};
     if (!fs::is_regular_file(metadata) || fs::is_empty(metadata)) {
       fmt::print("Invalid value for --metadata. {} file not found.",
@@ -112,7 +359,8 @@ Arguments parse_arguments(int argc, char *argv[]) {
       nb_threads = omp_get_max_threads();
     }
 
-    if (nb_threads > omp_get_max_threads()) {
+    // Shard workers write their output to the standard output stream
+    if (nb_threads > omp_get_max_threads() && !vm.count("shard-worker")) {
       fmt::print("WARNING: You are setting a number of threads ({}) greater "
                  "than the number of logical threads of your machine ({}). "
                  "Performance will degrade.",
@@ -123,12 +371,38 @@ Arguments parse_arguments(int argc, char *argv[]) {
     std::exit(1);
   }
 
+  auto pinning = game::ThreadPinning{};
+  if (vm.count("pin")) {
+    try {
+      pinning = game::parse_thread_pinning(vm["pin"].as<std::string>());
+    } catch (std::invalid_argument const &) {
+      fmt::print("Invalid value for --pin: {}. Valid values: none, compact, "
+                 "spread or a list of CPU ids",
+                 vm["pin"].as<std::string>());
+      std::exit(1);
+    }
+  }
+
+  auto scheduler = game::Scheduler::openmp;
+  if (vm.count("scheduler")) {
+    auto value = vm["scheduler"].as<std::string>();
+    if (value == "stealing") {
+      scheduler = game::Scheduler::work_stealing;
+    } else if (value != "openmp") {
+      fmt::print("Invalid value for --scheduler: {}. Valid values: openmp, "
+                 "stealing",
+                 value);
+      std::exit(1);
+    }
+  }
+
   int tmp_batch_size = 0;
   std::size_t batch_size = 0;
   if (vm.count("batch-size")) {
     tmp_batch_size = vm["batch-size"].as<int>();
-    if (tmp_batch_size < 1) {
-      fmt::print("Invalid value for --batch-size: {}. Must be greater than 0",
+    if (tmp_batch_size < 0) {
+      fmt::print("Invalid value for --batch-size: {}. Must be greater than 0, "
+                 "or 0 for auto",
                  tmp_batch_size);
       std::exit(1);
     } else {
@@ -136,27 +410,298 @@ Arguments parse_arguments(int argc, char *argv[]) {
     }
   }
 
-  auto output = fs::path{};
+  auto target_latency = std::chrono::duration<double>{};
+  if (vm.count("target-latency")) {
+    auto milliseconds = vm["target-latency"].as<double>();
+    if (milliseconds <= 0) {
+      fmt::print("Invalid value for --target-latency: {}. Must be greater than "
+                 "0",
+                 milliseconds);
+      std::exit(1);
+    }
+    target_latency = std::chrono::duration<double, std::milli>{milliseconds};
+  }
+
+  auto max_emission_delay = std::chrono::milliseconds{};
+  if (vm.count("max-emission-delay")) {
+    auto milliseconds = vm["max-emission-delay"].as<int>();
+    if (milliseconds < 0) {
+      fmt::print("Invalid value for --max-emission-delay: {}. Must be greater "
+                 "or equal to 0",
+                 milliseconds);
+      std::exit(1);
+    }
+    max_emission_delay = std::chrono::milliseconds{milliseconds};
+  }
+
+  auto sampling = game::BallSampling{};
+  if (auto every = vm["sample-every"].as<int>(); every < 1) {
+    fmt::print("Invalid value for --sample-every: {}. Must be greater than 0",
+               every);
+    std::exit(1);
+  } else {
+    sampling.every = static_cast<std::size_t>(every);
+  }
+  if (vm.count("sample-interval")) {
+    auto milliseconds = vm["sample-interval"].as<double>();
+    if (milliseconds <= 0) {
+      fmt::print("Invalid value for --sample-interval: {}. Must be greater "
+                 "than 0",
+                 milliseconds);
+      std::exit(1);
+    }
+    sampling.interval = std::chrono::duration_cast<std::chrono::picoseconds>(
+        std::chrono::duration<double, std::milli>{milliseconds});
+  }
+  if (auto periods = vm["calibration-periods"].as<int>(); periods < 0) {
+    fmt::print("Invalid value for --calibration-periods: {}. Must be greater "
+               "or equal to 0",
+               periods);
+    std::exit(1);
+  } else {
+    sampling.calibration_periods = static_cast<std::size_t>(periods);
+  }
+
+  auto output = std::string{};
   if (vm.count("output")) {
     output = vm["output"].as<std::string>();
   }
 
-  return {time_units, max_distance, game_data, metadata,
-          nb_threads, batch_size,   output};
+  auto options = game::MonitoringOptions{};
+  options.time_units = time_units;
+  options.maximum_distances = max_distances;
+  options.game_data = game_data;
+  options.metadata = metadata;
+  options.nb_threads = nb_threads;
+  options.pinning = pinning;
+  options.scheduler = scheduler;
+  options.batch_size = batch_size;
+  options.target_latency = target_latency;
+  options.max_emission_delay = max_emission_delay;
+  options.output_path = output;
+  options.sampling = sampling;
+  if (vm.count("checkpoint")) {
+    options.checkpoint_path = vm["checkpoint"].as<std::string>();
+  }
+  if (auto periods = vm["checkpoint-periods"].as<int>(); periods < 1) {
+    fmt::print("Invalid value for --checkpoint-periods: {}. Must be greater "
+               "than 0",
+               periods);
+    std::exit(1);
+  } else {
+    options.checkpoint_periods = static_cast<std::size_t>(periods);
+  }
+  options.resume = vm.count("resume") > 0;
+  if (vm.count("archive")) {
+    options.archive_path = vm["archive"].as<std::string>();
+  }
+  if (vm.count("timeline")) {
+    options.timeline_path = vm["timeline"].as<std::string>();
+  }
+  if (auto step = vm["window-step"].as<int>(); step < 1) {
+    fmt::print("Invalid value for --window-step: {}. Must be greater than 0",
+               step);
+    std::exit(1);
+  } else {
+    options.window_step = step;
+  }
+  if (vm.count("window")) {
+    options.window_lengths = vm["window"].as<std::vector<int>>();
+    for (auto length : options.window_lengths) {
+      if (length < 1 || length % options.window_step != 0) {
+        fmt::print("Invalid value for --window: {}. Must be a positive "
+                   "multiple of --window-step",
+                   length);
+        std::exit(1);
+      }
+    }
+  }
+  if (vm.count("between")) {
+    for (auto const &value : vm["between"].as<std::vector<std::string>>()) {
+      auto range = parse_game_clock_range(value);
+      if (!range) {
+        fmt::print("Invalid value for --between: {}. Expected a non-empty "
+                   "range MM:SS-MM:SS",
+                   value);
+        std::exit(1);
+      }
+      options.range_queries.push_back(*range);
+    }
+  }
+  if (auto milliseconds = vm["range-resolution"].as<double>();
+      milliseconds <= 0) {
+    fmt::print("Invalid value for --range-resolution: {}. Must be greater "
+               "than 0",
+               milliseconds);
+    std::exit(1);
+  } else {
+    options.range_resolution =
+        std::chrono::duration_cast<std::chrono::picoseconds>(
+            std::chrono::duration<double, std::milli>{milliseconds});
+  }
+  if (options.resume && options.checkpoint_path.empty()) {
+    std::cout << "--resume requires --checkpoint\n" << desc;
+    std::exit(1);
+  }
+  options.period_parallel = vm.count("period-parallel") > 0;
+  options.streaming = vm.count("streaming") > 0;
+  options.incremental = vm.count("incremental") > 0;
+  if (options.incremental && !options.streaming) {
+    std::cout << "--incremental requires --streaming\n" << desc;
+    std::exit(1);
+  }
+  options.spatial_index = vm.count("spatial-index") > 0;
+  if (options.spatial_index && !options.streaming) {
+    std::cout << "--spatial-index requires --streaming\n" << desc;
+    std::exit(1);
+  }
+  options.foot_level = vm.count("foot-level") > 0;
+  if (options.foot_level && !options.streaming) {
+    std::cout << "--foot-level requires --streaming\n" << desc;
+    std::exit(1);
+  }
+  auto is_sampling = sampling.every > 1 || sampling.interval.count() > 0;
+  if (auto nb_shards = vm["shards"].as<int>(); nb_shards < 1) {
+    fmt::print("Invalid value for --shards: {}. Must be greater than 0",
+               nb_shards);
+    std::exit(1);
+  } else {
+    options.nb_shards = static_cast<std::size_t>(nb_shards);
+  }
+  if (auto seconds = vm["shard-lead-in"].as<double>(); seconds < 0) {
+    fmt::print("Invalid value for --shard-lead-in: {}. Must be greater or "
+               "equal to 0",
+               seconds);
+    std::exit(1);
+  } else {
+    options.shard_lead_in =
+        std::chrono::duration_cast<std::chrono::picoseconds>(
+            std::chrono::duration<double>{seconds});
+  }
+  if (vm.count("shard-command")) {
+    auto command = std::vector<std::string>{};
+    auto ss = std::istringstream{vm["shard-command"].as<std::string>()};
+    for (auto word = std::string{}; ss >> word;) {
+      command.push_back(word);
+    }
+    if (command.empty()) {
+      std::cout << "Invalid value for --shard-command: empty command\n"
+                << desc;
+      std::exit(1);
+    }
+    options.worker_command = command;
+  }
+  auto shard_worker = std::optional<game::Shard>{};
+  if (vm.count("shard-worker")) {
+    shard_worker = game::parse_shard(vm["shard-worker"].as<std::string>());
+    if (!shard_worker) {
+      fmt::print("Invalid value for --shard-worker: {}",
+                 vm["shard-worker"].as<std::string>());
+      std::exit(1);
+    }
+  }
+  options.running = vm.count("running") > 0;
+  if (vm.count("heat-maps")) {
+    options.heat_map_path = vm["heat-maps"].as<std::string>();
+  }
+  if (auto grid = parse_heat_map_grid(vm["heat-map-grid"].as<std::string>());
+      !grid) {
+    fmt::print("Invalid value for --heat-map-grid: {}. Expected XxY, with X "
+               "and Y greater than 0",
+               vm["heat-map-grid"].as<std::string>());
+    std::exit(1);
+  } else {
+    options.heat_map_grid = *grid;
+  }
+  auto in_memory = vm.count("in-memory") > 0;
+  // Matches always share a work-stealing pool
+  auto is_openmp_requested = !vm["scheduler"].defaulted() &&
+                             options.scheduler == game::Scheduler::openmp;
+  auto conflict = find_conflict({
+      {"--streaming",
+       options.streaming,
+       {"--period-parallel", "--match", "--shards", "--max-emission-delay"}},
+      {"--period-parallel", options.period_parallel, {"--match", "--shards"}},
+      {"--match",
+       !matches.empty(),
+       {"--stream", "--metadata", "--output", "--scheduler openmp",
+        "--checkpoint", "--archive", "--timeline", "--window", "--between",
+        "--shards", "--running", "--heat-maps", "--in-memory"}},
+      {"--stream", vm.count("stream") > 0, {}},
+      {"--metadata", vm.count("metadata") > 0, {}},
+      {"--output", vm.count("output") > 0, {}},
+      {"--scheduler openmp", is_openmp_requested, {}},
+      {"approximate mode",
+       is_sampling,
+       {"--streaming", "--period-parallel", "--shards"}},
+      {"--checkpoint",
+       !options.checkpoint_path.empty(),
+       {"--streaming", "--period-parallel", "--shards", "--in-memory"}},
+      {"--archive", !options.archive_path.empty(), {}},
+      {"--timeline",
+       !options.timeline_path.empty(),
+       {"--period-parallel", "--shards"}},
+      {"--window", !options.window_lengths.empty(), {}},
+      {"--between",
+       !options.range_queries.empty(),
+       {"--period-parallel", "--shards"}},
+      {"--max-emission-delay",
+       options.max_emission_delay.count() > 0,
+       {"--shards", "--in-memory"}},
+      {"--shards",
+       options.nb_shards > 1,
+       {"--running", "--heat-maps", "--in-memory"}},
+      {"--running",
+       options.running,
+       {"--streaming", "--period-parallel", "--in-memory", "--resume"}},
+      {"--heat-maps",
+       !options.heat_map_path.empty(),
+       {"--streaming", "--period-parallel", "--resume"}},
+      {"--in-memory", in_memory, {}},
+      {"--resume", options.resume, {}},
+      {"--foot-level",
+       options.foot_level,
+       {"--incremental", "--spatial-index"}},
+      {"--incremental", options.incremental, {}},
+      {"--spatial-index", options.spatial_index, {}},
+  });
+  if (conflict) {
+    std::cout << *conflict << "\n" << desc;
+    std::exit(1);
+  }
+  return {options, matches, in_memory, shard_worker};
+}
+
+/**
+ * Loads the stream of @p options into an EventStore and displays its size.
+ */
+game::EventStore load_event_store(game::MonitoringOptions const &options) {
+  auto context = game::Context::build_from(options.metadata);
+  auto start = std::chrono::steady_clock::now();
+  auto store = game::load_event_store(options.game_data.string(), context);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  auto stream_size = std::filesystem::file_size(options.game_data);
+  fmt::print("Event store: {} events in {:.1f} MB ({:.1f}% of the stream), "
+             "loaded in {:.3f} seconds\n",
+             store.size(), store.get_memory_size() / 1e6,
+             100.0 * store.get_memory_size() / stream_size, elapsed.count());
+  return store;
 }
 
 int main(int argc, char *argv[]) {
-  auto args = parse_arguments(argc, argv);
-
-  if (args.output.empty()) {
-    // Output to stdout
-    game::run_game_monitoring(args.time_units, args.maximum_distance,
-                              args.game_data, args.metadata, args.nb_threads,
-                              args.batch_size);
+  auto arguments = parse_arguments(argc, argv);
+  if (arguments.shard_worker) {
+    game::run_shard_worker(arguments.options, *arguments.shard_worker,
+                           std::cout);
+  } else if (arguments.in_memory) {
+    auto store = load_event_store(arguments.options);
+    arguments.options.event_store = &store;
+    game::run_game_monitoring(arguments.options);
+  } else if (arguments.matches.empty()) {
+    game::run_game_monitoring(arguments.options);
   } else {
-    // Output to file
-    game::run_game_monitoring(args.time_units, args.maximum_distance,
-                              args.game_data, args.metadata, args.nb_threads,
-                              args.batch_size, args.output.string());
+    game::run_matches(arguments.options, arguments.matches);
   }
 }
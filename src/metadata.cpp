@@ -103,7 +103,9 @@ bool BallMap::is_ball(int sensor_id) const {
 
 const std::regex ParseMetadata::ball_re = std::regex{"BALL,(\\d+),(\\d+)"};
 const std::regex ParseMetadata::player_re =
-    std::regex{R"(PLAYER,([AB]),([ \w]+),(\d+),(\d+),(\d+),(\d+))"};
+    std::regex{R"(PLAYER,([AB]),([ \w]+)((?:,\d+)+))"};
+const std::regex ParseMetadata::timeline_re =
+    std::regex{R"(TIMELINE,(\d+),(\d+),(\d+),(\d+),(\d+),(\d+))"};
 
 // ==-----------------------------------------------------------------------==
 //                        Functions definition
@@ -134,13 +136,21 @@ Metadata parse_metadata_string(std::string const &metadata) {
   auto positions = std::vector<Positions>();
   positions.emplace_back(BallPosition{});
   auto &ball_position = positions.back();
+  auto timeline = MatchTimeline{};
+  std::size_t nb_balls = 0;
 
   for (auto line = std::string{}; std::getline(ss, line);) {
     if (std::regex_match(line, match, ParseMetadata::ball_re)) {
       // Get sensor id for the ball and it to ball map if not already present
       auto ball_sid = std::stoi(match[ParseMetadata::ball_re_sid_idx].str());
       if (!balls.is_ball(ball_sid)) {
+        if (nb_balls == max_ball_sensors) {
+          throw std::length_error{fmt::format(
+              "Invalid metadata line \"{}\": at most {} balls are supported",
+              line, max_ball_sensors)};
+        }
         balls.add_ball(ball_sid);
+        ++nb_balls;
         std::visit([ball_sid](auto &&pos) { pos.add_sensor(ball_sid); },
                    ball_position);
       }
@@ -150,15 +160,21 @@ Metadata parse_metadata_string(std::string const &metadata) {
                                                                  : Team::B);
       auto name = match[ParseMetadata::player_re_name_idx].str();
 
-      // Parse sensor ids for player
+      // Parse sensor ids for player, 0 standing for an empty slot
       auto sids = std::vector<int>{};
-      for (std::size_t i = ParseMetadata::player_re_sid_start_idx;
-           i <= ParseMetadata::player_re_sid_end_idx; ++i) {
-        auto sid = std::stoi(match[i].str());
-        if (sid != 0) {
-          sids.push_back(sid);
+      auto sids_ss =
+          std::stringstream{match[ParseMetadata::player_re_sids_idx].str()};
+      for (auto sid = std::string{}; std::getline(sids_ss, sid, ',');) {
+        if (!sid.empty() && std::stoi(sid) != 0) {
+          sids.push_back(std::stoi(sid));
         }
       }
+      if (sids.size() > max_player_sensors) {
+        throw std::length_error{fmt::format(
+            "Invalid metadata line \"{}\": {} wears {} sensors, at most {} "
+            "are supported",
+            line, name, sids.size(), max_player_sensors)};
+      }
 
       // Fill maps
       teams.add_player(name, team);
@@ -168,11 +184,23 @@ Metadata parse_metadata_string(std::string const &metadata) {
         position.add_sensor(sid);
       }
       positions.emplace_back(std::move(position));
+    } else if (std::regex_match(line, match, ParseMetadata::timeline_re)) {
+      // Instants, in picoseconds, of the game start, the break start (actual
+      // and declared), the break end, the game end and the half duration
+      auto instant = [&match](std::size_t i) {
+        return std::chrono::picoseconds{std::stoll(match[i].str())};
+      };
+      timeline.game_start = instant(1);
+      timeline.break_start = instant(2);
+      timeline.official_break_start = instant(3);
+      timeline.break_end = instant(4);
+      timeline.game_end = instant(5);
+      timeline.half_duration = instant(6);
     } else {
       fmt::print(stderr, "Unable to parse line:\n  {}\n  Skipping...\n", line);
     }
   }
 
-  return {players, teams, balls, positions};
+  return {players, teams, balls, positions, timeline};
 }
 } // namespace game
\ No newline at end of file
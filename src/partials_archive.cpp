@@ -0,0 +1,161 @@
+#include "partials_archive.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace {
+using Layout = PartialsArchiveLayout;
+
+constexpr auto magic = std::array<char, 4>{'S', 'M', 'P', 'A'};
+
+struct Header {
+  std::array<char, 4> magic;
+  std::uint32_t version;
+  std::uint32_t nb_players;
+  std::int32_t time_units;
+  double maximum_distance;
+  std::uint64_t nb_periods;
+};
+static_assert(sizeof(Header) == Layout::header_size,
+              "The archive header must not be padded");
+
+std::size_t row_size(std::size_t nb_players) {
+  return nb_players * sizeof(float);
+}
+} // namespace
+
+PartialsArchiveWriter::PartialsArchiveWriter(
+    std::filesystem::path const &path,
+    std::vector<std::string> const &player_names, double maximum_distance,
+    int time_units)
+    : file{path, details::MappedFile::Mode::create,
+           Layout::rows_offset(player_names.size()) +
+               initial_periods * row_size(player_names.size())},
+      nb_players{player_names.size()} {
+  auto header = Header{magic,
+                       Layout::version,
+                       static_cast<std::uint32_t>(nb_players),
+                       time_units,
+                       maximum_distance,
+                       0};
+  std::memcpy(file.data(), &header, sizeof(header));
+
+  // Names are NUL padded, the file being zero-filled when created
+  auto *names = file.data() + Layout::header_size;
+  for (auto const &name : player_names) {
+    if (name.size() >= Layout::name_size) {
+      throw std::invalid_argument{
+          fmt::format("Player name {} is too long to be archived", name)};
+    }
+    std::memcpy(names, name.data(), name.size());
+    names += Layout::name_size;
+  }
+}
+
+PartialsArchiveWriter::PartialsArchiveWriter(
+    std::filesystem::path const &path,
+    std::vector<std::string> const &player_names, double maximum_distance,
+    int time_units, std::size_t nb_periods)
+    : file{path, details::MappedFile::Mode::update},
+      nb_players{player_names.size()}, nb_periods{nb_periods} {
+  auto header = Header{};
+  if (file.size() >= sizeof(header)) {
+    std::memcpy(&header, file.data(), sizeof(header));
+  }
+  auto is_valid =
+      file.size() >= Layout::rows_offset(nb_players) +
+                         nb_periods * row_size(nb_players) &&
+      header.magic == magic && header.version == Layout::version &&
+      header.nb_players == nb_players && header.time_units == time_units &&
+      header.maximum_distance == maximum_distance &&
+      header.nb_periods >= nb_periods;
+  auto const *names =
+      reinterpret_cast<char const *>(file.data() + Layout::header_size);
+  for (std::size_t i = 0; is_valid && i < nb_players; ++i) {
+    auto const *name = names + i * Layout::name_size;
+    auto const *name_end = std::find(name, name + Layout::name_size, '\0');
+    is_valid = player_names[i] == std::string{name, name_end};
+  }
+  if (!is_valid) {
+    throw std::runtime_error{fmt::format(
+        "{} is not an archive of these statistics to resume", path.string())};
+  }
+
+  auto count = static_cast<std::uint64_t>(nb_periods);
+  std::memcpy(file.data() + offsetof(Header, nb_periods), &count,
+              sizeof(count));
+}
+
+PartialsArchiveWriter::~PartialsArchiveWriter() {
+  try {
+    file.resize(Layout::rows_offset(nb_players) +
+                nb_periods * row_size(nb_players));
+  } catch (std::runtime_error const &) {
+    // The archive is still valid, only larger than needed
+  }
+}
+
+void PartialsArchiveWriter::append(float const *shares) {
+  auto offset =
+      Layout::rows_offset(nb_players) + nb_periods * row_size(nb_players);
+  if (offset + row_size(nb_players) > file.size()) {
+    file.resize(Layout::rows_offset(nb_players) +
+                2 * (nb_periods + 1) * row_size(nb_players));
+  }
+  std::memcpy(file.data() + offset, shares, row_size(nb_players));
+
+  // Publish the row only once written
+  auto count = static_cast<std::uint64_t>(++nb_periods);
+  std::memcpy(file.data() + offsetof(Header, nb_periods), &count,
+              sizeof(count));
+}
+
+PartialsArchive::PartialsArchive(std::filesystem::path const &path)
+    : file{path, details::MappedFile::Mode::read} {
+  auto header = Header{};
+  if (file.size() >= sizeof(header)) {
+    std::memcpy(&header, file.data(), sizeof(header));
+  }
+  if (file.size() < sizeof(header) || header.magic != magic ||
+      header.version != Layout::version ||
+      file.size() < Layout::rows_offset(header.nb_players)) {
+    throw std::runtime_error{
+        fmt::format("{} is not a partial statistics archive of this version",
+                    path.string())};
+  }
+
+  auto const *names =
+      reinterpret_cast<char const *>(file.data() + Layout::header_size);
+  for (std::size_t i = 0; i < header.nb_players; ++i) {
+    auto const *name = names + i * Layout::name_size;
+    player_names.emplace_back(
+        name, std::find(name, name + Layout::name_size, '\0'));
+  }
+  maximum_distance = header.maximum_distance;
+  time_units = header.time_units;
+
+  // Rows may be missing if the archive is being written
+  auto nb_rows = header.nb_players == 0
+                     ? std::size_t{0}
+                     : (file.size() - Layout::rows_offset(header.nb_players)) /
+                           row_size(header.nb_players);
+  nb_periods =
+      std::min(static_cast<std::size_t>(header.nb_periods), nb_rows);
+}
+
+float const *PartialsArchive::get_period(std::size_t period) const {
+  if (period >= nb_periods) {
+    throw std::out_of_range{fmt::format(
+        "Period {} is not archived, only {} are", period, nb_periods)};
+  }
+  auto offset = Layout::rows_offset(player_names.size()) +
+                period * row_size(player_names.size());
+  return reinterpret_cast<float const *>(file.data() + offset);
+}
+} // namespace game
@@ -13,36 +13,64 @@ namespace game {
 //                        PlayerPosition implementation
 // ==-----------------------------------------------------------------------==
 
+void PlayerPosition::add_sensor(int sid) {
+  if (nb_sensors == max_player_sensors) {
+    throw std::length_error{fmt::format(
+        "Cannot add sid {}: a player wears at most {} sensors", sid,
+        max_player_sensors)};
+  }
+  sids[nb_sensors] = sid;
+  xs[nb_sensors] = 0;
+  ys[nb_sensors] = 0;
+  zs[nb_sensors] = 0;
+  ++nb_sensors;
+  inv_nb_sensors = 1.0 / nb_sensors;
+}
+
 void PlayerPosition::update_sensor(int sid, std::tuple<int, int, int> vector) {
   auto [x, y, z] = vector;
   auto idx = sid_index(sid);
+
+  // Keep running sums up to date, replacing the old sensor coordinates
+  sum_x += x - xs[idx];
+  sum_y += y - ys[idx];
+  sum_z += z - zs[idx];
+
   xs[idx] = x;
   ys[idx] = y;
   zs[idx] = z;
 }
 
 std::size_t PlayerPosition::sid_index(int sid) const {
-  if (auto it = std::find(sids.cbegin(), sids.cend(), sid); it != sids.cend()) {
+  auto last = sids.cbegin() + nb_sensors;
+  if (auto it = std::find(sids.cbegin(), last, sid); it != last) {
     return std::distance(sids.cbegin(), it);
   } else {
     throw std::out_of_range{fmt::format("Unknown sid {}", sid)};
   }
 }
 
-std::tuple<double, double, double> PlayerPosition::vector() const {
-  auto x_bar = mean(xs.cbegin(), xs.cend());
-  auto y_bar = mean(ys.cbegin(), ys.cend());
-  auto z_bar = mean(zs.cbegin(), zs.cend());
-
-  return {x_bar, y_bar, z_bar};
-}
-
 // ==-----------------------------------------------------------------------==
 //                        BallPosition implementation
 // ==-----------------------------------------------------------------------==
 
+void BallPosition::add_sensor(int sid) {
+  if (nb_sensors == max_ball_sensors) {
+    throw std::length_error{
+        fmt::format("Cannot add sid {}: at most {} ball sensors are tracked",
+                    sid, max_ball_sensors)};
+  }
+  sids[nb_sensors] = sid;
+  xs[nb_sensors] = 0;
+  ys[nb_sensors] = 0;
+  zs[nb_sensors] = 0;
+
+  game_ball = nb_sensors++; // Set last add ball as the game one
+}
+
 std::size_t BallPosition::sid_index(int sid) const {
-  if (auto it = std::find(sids.cbegin(), sids.cend(), sid); it != sids.cend()) {
+  auto last = sids.cbegin() + nb_sensors;
+  if (auto it = std::find(sids.cbegin(), last, sid); it != last) {
     return std::distance(sids.cbegin(), it);
   } else {
     throw std::out_of_range{fmt::format("Unknown sid {}", sid)};
@@ -0,0 +1,41 @@
+#include "possession_timeline.hpp"
+
+#include <memory>
+#include <utility>
+
+namespace game {
+PossessionTimeline::PossessionTimeline(std::ostream &os,
+                                       std::vector<std::string> player_names)
+    : os{std::addressof(os)}, player_names{std::move(player_names)} {
+  *this->os << "player,start,end\n";
+}
+
+void PossessionTimeline::cut() {
+  if (!is_open) {
+    return;
+  }
+  if (current_player == none_player) {
+    *os << "None";
+  } else {
+    *os << player_names[current_player];
+  }
+  *os << ',' << start.count() << ',' << end.count() << '\n';
+  is_open = false;
+  ++nb_segments;
+}
+
+PossessionTimeline::State PossessionTimeline::save() {
+  os->flush();
+  return {static_cast<std::int64_t>(os->tellp()), nb_segments, current_player,
+          start, end, is_open};
+}
+
+void PossessionTimeline::restore(State const &state) {
+  os->seekp(state.offset);
+  nb_segments = state.nb_segments;
+  current_player = state.current_player;
+  start = state.start;
+  end = state.end;
+  is_open = state.is_open;
+}
+} // namespace game
@@ -0,0 +1,153 @@
+#include "running_statistics.hpp"
+#include "details/visualizer_impl.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace {
+/// @return @p kmh kilometers per hour, in micrometers per second.
+constexpr double as_speed(double kmh) { return kmh * 1e6 / 3.6; }
+} // namespace
+
+RunningStatistics::RunningStatistics(std::vector<int> time_units,
+                                     int base_time_units,
+                                     Context const &context, std::ostream &os)
+    : time_units{std::move(time_units)}, base_units{base_time_units},
+      teams{context.get_teams()}, os{&os},
+      player_names{context.get_player_names()} {
+  auto nb_players = player_names.size();
+  auto nb_ts = this->time_units.size();
+  for (std::size_t p = 0; p < nb_players; ++p) {
+    for (auto sid : context.get_player_sids(player_names[p])) {
+      if (static_cast<std::size_t>(sid) >= sensor_players.size()) {
+        sensor_players.resize(sid + 1, -1);
+      }
+      sensor_players[sid] = static_cast<int>(p);
+    }
+  }
+  drawing_order.resize(nb_players);
+  for (std::size_t p = 0; p < nb_players; ++p) {
+    drawing_order[p] = p;
+  }
+  auto cmp = details::PartialsCmp{teams};
+  std::sort(drawing_order.begin(), drawing_order.end(),
+            [&](std::size_t p1, std::size_t p2) {
+              return cmp(player_names[p1], player_names[p2]);
+            });
+
+  speeds.resize(nb_players, 0);
+  last_ts.resize(nb_players, std::chrono::picoseconds::min());
+  counters.resize((2 + 2 * nb_ts) * nb_players);
+  elapsed_periods.resize(nb_ts, 0);
+  nb_periods.resize(nb_ts, 0);
+  periods_over.resize(nb_ts, false);
+}
+
+std::size_t RunningStatistics::speed_band(int speed) {
+  std::size_t band = 0;
+  while (band < band_limits.size() && speed >= as_speed(band_limits[band])) {
+    ++band;
+  }
+  return band;
+}
+
+void RunningStatistics::on_batch(Batch const &batch) {
+  for (auto const &event : *batch.data) {
+    auto sid = static_cast<std::size_t>(event.get_sid());
+    if (sid >= sensor_players.size() || sensor_players[sid] < 0) {
+      continue;
+    }
+    auto p = static_cast<std::size_t>(sensor_players[sid]);
+    auto ts = event.get_timestamp();
+    if (last_ts[p] != std::chrono::picoseconds::min()) {
+      auto interval = ts - last_ts[p];
+      if (interval.count() > 0 && interval <= max_interval) {
+        // The base period counters are the first slot
+        auto &player = counters[p];
+        std::chrono::duration<double> seconds = interval;
+        player.distance += speeds[p] * 1e-6 * seconds.count();
+        player.band_times[speed_band(speeds[p])] += interval;
+      }
+    }
+    speeds[p] = event.get_speed();
+    last_ts[p] = ts;
+  }
+}
+
+void RunningStatistics::on_period_end(Batch const &batch) {
+  auto nb_players = player_names.size();
+  auto nb_ts = time_units.size();
+  auto fold = [](Counters &into, Counters const &from) {
+    into.distance += from.distance;
+    for (std::size_t b = 0; b < nb_bands; ++b) {
+      into.band_times[b] += from.band_times[b];
+    }
+  };
+
+  // Fold the base period into every T period and the whole game
+  auto *base = counters.data();
+  auto *game = counters.data() + (1 + 2 * nb_ts) * nb_players;
+  for (std::size_t p = 0; p < nb_players; ++p) {
+    for (std::size_t t = 0; t < nb_ts; ++t) {
+      fold(counters[(1 + t) * nb_players + p], base[p]);
+    }
+    fold(game[p], base[p]);
+  }
+  std::fill(base, base + nb_players, Counters{});
+
+  for (std::size_t t = 0; t < nb_ts; ++t) {
+    elapsed_periods[t] += 1;
+    periods_over[t] = batch.is_half_last_batch ||
+                      elapsed_periods[t] * base_units >= time_units[t];
+    if (!periods_over[t]) {
+      continue;
+    }
+    auto current = counters.begin() + (1 + t) * nb_players;
+    std::copy(current, current + nb_players,
+              counters.begin() + (1 + nb_ts + t) * nb_players);
+    std::fill(current, current + nb_players, Counters{});
+    elapsed_periods[t] = 0;
+    ++nb_periods[t];
+    draw(fmt::format("Running statistics, T = {} s, period {}", time_units[t],
+                     nb_periods[t]),
+         1 + nb_ts + t);
+  }
+
+  if (batch.is_half_last_batch) {
+    // The game break is not run
+    std::fill(last_ts.begin(), last_ts.end(), std::chrono::picoseconds::min());
+  }
+}
+
+void RunningStatistics::on_game_end() {
+  *os << "--------- Game End. Final Running Statistics ----------\n\n";
+  draw("Running statistics, whole game", 1 + 2 * time_units.size());
+}
+
+void RunningStatistics::draw(std::string const &label, std::size_t slot) {
+  auto separator = std::string(80, '-');
+  *os << label << '\n' << separator << '\n';
+  *os << fmt::format("| {:<20}{:<5}{:>9}", "Player", "Team", "Dist (m)");
+  for (auto const *name : band_names) {
+    *os << fmt::format("{:>7}", name);
+  }
+  *os << " |\n" << separator << '\n';
+
+  auto const *players = counters.data() + slot * player_names.size();
+  for (auto p : drawing_order) {
+    auto const &name = player_names[p];
+    *os << fmt::format("| {:<20}{:<5}{:>9.1f}", name,
+                       teams[name] == Team::A ? "A" : "B",
+                       players[p].distance);
+    for (auto time : players[p].band_times) {
+      std::chrono::duration<double> seconds = time;
+      *os << fmt::format("{:>7.1f}", seconds.count());
+    }
+    *os << " |\n";
+  }
+  *os << separator << "\n\n";
+}
+} // namespace game
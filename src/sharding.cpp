@@ -0,0 +1,308 @@
+#include "sharding.hpp"
+#include "batch_size_controller.hpp"
+#include "details/binary_io.hpp"
+#include "details/mapped_file.hpp"
+#include "event_fetcher.hpp"
+#include "game_statistics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <omp.h>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace {
+/// Identifies the output of shard workers
+constexpr auto magic = std::array<char, 4>{'S', 'M', 'S', 'H'};
+/// Bumped on every change of the output layout
+constexpr std::uint32_t version = 1;
+/// Tags the records of the output: a period, or the end of the output
+constexpr std::uint8_t period_record = 1;
+constexpr std::uint8_t end_record = 0;
+
+/**
+ * @return field @p index of a comma-separated line, or an empty view if the
+ *         line has fewer fields.
+ */
+std::string_view field(std::string_view line, std::size_t index) {
+  for (; index > 0; --index) {
+    auto comma = line.find(',');
+    if (comma == std::string_view::npos) {
+      return {};
+    }
+    line.remove_prefix(comma + 1);
+  }
+  return line.substr(0, line.find(','));
+}
+
+/**
+ * @return the number written in @p text, or nothing if it is not only a
+ *         number.
+ */
+template <typename T> std::optional<T> parse_number(std::string_view text) {
+  auto value = T{};
+  auto last = text.data() + text.size();
+  auto [end, error] = std::from_chars(text.data(), last, value);
+  if (error != std::errc{} || end != last || text.empty()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+/**
+ * @param pauses The game pauses, as [interruption, resume) intervals in game
+ *        order
+ * @return the instant @p lead_in of unpaused game before @p instant.
+ */
+std::chrono::picoseconds lead_in_start(
+    std::chrono::picoseconds instant, std::chrono::picoseconds lead_in,
+    std::vector<std::pair<std::chrono::picoseconds,
+                          std::chrono::picoseconds>> const &pauses) {
+  auto start = instant;
+  for (auto pause = pauses.rbegin(); pause != pauses.rend(); ++pause) {
+    if (pause->first >= start) {
+      continue;
+    }
+    auto unpaused = start - std::min(pause->second, start);
+    if (unpaused >= lead_in) {
+      break;
+    }
+    lead_in -= unpaused;
+    start = pause->first;
+  }
+  return start - lead_in;
+}
+} // namespace
+
+std::vector<Shard> plan_shards(std::filesystem::path const &game_data,
+                               Context const &context, int time_units,
+                               std::size_t nb_shards,
+                               std::chrono::picoseconds lead_in) {
+  using std::chrono::picoseconds;
+
+  // Periods start as in EventFetcher::parse_batch(): an in-game event at least
+  // a period after the current period start starts the next one, and a break
+  // event starts the second half. The stream may be parsed from the event
+  // starting a period if the events opening the previous one were batched.
+  struct PeriodStart {
+    picoseconds start;
+    /// The event starting the period
+    picoseconds ts;
+    std::uint64_t offset;
+    /// The period start and pause right before that event
+    picoseconds previous_start;
+    bool is_paused;
+    bool is_bucket_empty;
+  };
+  auto const &timeline = context.get_timeline();
+  auto period = std::chrono::duration_cast<picoseconds>(
+      std::chrono::seconds(time_units));
+  auto period_start = timeline.game_start;
+  auto is_paused = false;
+  auto is_bucket_empty = true;
+  auto starts = std::vector<PeriodStart>{{timeline.game_start,
+                                          picoseconds::min(), 0,
+                                          timeline.game_start, false, true}};
+  auto pauses = std::vector<std::pair<picoseconds, picoseconds>>{};
+
+  auto file = details::MappedFile{game_data, details::MappedFile::Mode::read};
+  auto const *data = reinterpret_cast<char const *>(file.data());
+  for (std::size_t offset = 0; offset < file.size();) {
+    auto const *line_end = static_cast<char const *>(
+        std::memchr(data + offset, '\n', file.size() - offset));
+    auto length = line_end != nullptr
+                      ? static_cast<std::size_t>(line_end - (data + offset))
+                      : file.size() - offset;
+    auto line = std::string_view{data + offset, length};
+    auto line_offset = offset;
+    offset += length + 1;
+
+    auto type = field(line, Dataset::event_type_idx);
+    if (type == "GI") {
+      auto event_id =
+          parse_number<int>(field(line, Dataset::gi_event_id_idx)).value_or(0);
+      auto ts = parse_number<std::int64_t>(
+          field(line, Dataset::gi_timestamp_idx));
+      if (!ts) {
+        continue;
+      }
+      if ((event_id == Dataset::first_half_interruption_id ||
+           event_id == Dataset::second_half_interruption_id) &&
+          !is_paused) {
+        is_paused = true;
+        pauses.emplace_back(picoseconds{*ts}, picoseconds::max());
+      } else if ((event_id == Dataset::first_half_resume_id ||
+                  event_id == Dataset::second_half_resume_id) &&
+                 is_paused) {
+        is_paused = false;
+        pauses.back().second = picoseconds{*ts};
+      }
+      continue;
+    }
+
+    auto sid = parse_number<int>(field(line, Dataset::se_sid_idx));
+    auto ts =
+        parse_number<std::int64_t>(field(line, Dataset::se_timestamp_idx));
+    if (type != "SE" || !sid || !ts ||
+        !(context.get_balls().is_ball(*sid) ||
+          context.get_players().is_player(*sid))) {
+      continue;
+    }
+    auto timestamp = picoseconds{*ts};
+    auto is_in_game =
+        (timeline.game_start <= timestamp &&
+         timestamp <= timeline.break_start) ||
+        (timeline.break_end <= timestamp && timestamp <= timeline.game_end);
+    if (is_in_game && timestamp - period_start >= period) {
+      starts.push_back({period_start + period, timestamp, line_offset,
+                        period_start, is_paused, is_bucket_empty});
+      period_start += period;
+      if (!is_paused) {
+        // The event is deferred to the next batch
+        is_bucket_empty = false;
+      }
+    } else if (is_in_game && !is_paused) {
+      is_bucket_empty = true;
+    } else if (timeline.break_start < timestamp &&
+               timestamp < timeline.break_end &&
+               period_start != timeline.break_end) {
+      starts.push_back({timeline.break_end, timestamp, line_offset,
+                        period_start, is_paused, is_bucket_empty});
+      period_start = timeline.break_end;
+    }
+  }
+
+  // Shards split the periods of the stream evenly
+  nb_shards = std::clamp<std::size_t>(nb_shards, 1, starts.size());
+  auto shards = std::vector<Shard>{};
+  for (std::size_t i = 0; i < nb_shards; ++i) {
+    auto first = i * starts.size() / nb_shards;
+    auto shard = Shard{};
+    shard.begin = starts[first].start;
+    shard.end = i + 1 < nb_shards
+                    ? starts[(i + 1) * starts.size() / nb_shards].start
+                    : picoseconds::max();
+
+    // The first shard starts with the stream
+    auto lead_start = i == 0 ? picoseconds::min()
+                             : lead_in_start(starts[first].ts, lead_in, pauses);
+    auto j = first;
+    while (j > 0 && (starts[j].ts > lead_start || !starts[j].is_bucket_empty)) {
+      --j;
+    }
+    shard.offset = starts[j].offset;
+    shard.period_start = starts[j].previous_start;
+    shard.is_paused = starts[j].is_paused;
+    shards.push_back(shard);
+  }
+  return shards;
+}
+
+std::string to_string(Shard const &shard) {
+  return fmt::format("{},{},{},{},{}", shard.begin.count(), shard.end.count(),
+                     shard.offset, shard.period_start.count(),
+                     shard.is_paused ? 1 : 0);
+}
+
+std::optional<Shard> parse_shard(std::string const &value) {
+  auto begin = parse_number<std::int64_t>(field(value, 0));
+  auto end = parse_number<std::int64_t>(field(value, 1));
+  auto offset = parse_number<std::uint64_t>(field(value, 2));
+  auto period_start = parse_number<std::int64_t>(field(value, 3));
+  auto is_paused = parse_number<int>(field(value, 4));
+  if (!begin || !end || !offset || !period_start || !is_paused ||
+      *is_paused < 0 || *is_paused > 1 || !field(value, 5).empty()) {
+    return std::nullopt;
+  }
+  return Shard{std::chrono::picoseconds{*begin}, std::chrono::picoseconds{*end},
+               *offset, std::chrono::picoseconds{*period_start},
+               *is_paused == 1};
+}
+
+void run_shard_worker(MonitoringOptions const &options, Shard const &shard,
+                      std::ostream &os) {
+  auto context = Context::build_from(options.metadata);
+  auto stats = GameStatistics{options.maximum_distances, options.time_units,
+                              context};
+  auto batch_size = options.batch_size == 0
+                        ? BatchSizeController::initial_batch_size
+                        : options.batch_size;
+  auto fetcher = EventFetcher{options.game_data.string(), file_stream{},
+                              stats.base_time_units(), batch_size, context};
+  fetcher.seek(shard.offset, shard.period_start, shard.is_paused);
+  omp_set_num_threads(options.nb_threads);
+
+  details::write_raw(os, magic);
+  details::write_raw(os, version);
+  auto period = std::chrono::seconds(stats.base_time_units());
+  while (!fetcher.is_game_over() && fetcher.get_period_start() < shard.end) {
+    auto period_start = fetcher.get_period_start();
+    auto batch = fetcher.parse_batch();
+    // A batch belongs to the period it is in once parsed, which is not the one
+    // it started in if the game break began while it was empty
+    if (!batch.is_period_last_batch) {
+      period_start = fetcher.get_period_start();
+    } else if (!batch.is_half_last_batch) {
+      period_start = fetcher.get_period_start() - period;
+    }
+    if (period_start < shard.begin || period_start >= shard.end) {
+      // Lead-in batches only move the players
+      continue;
+    }
+
+    // Periods are closed by the coordinator
+    auto is_period_last = batch.is_period_last_batch;
+    batch.is_period_last_batch = false;
+    stats.accumulate_stats(batch);
+    if (is_period_last) {
+      details::write_raw(os, period_record);
+      details::write_raw(os, batch.initial_ts);
+      details::write_raw(os, batch.final_ts);
+      details::write_raw(os, batch.is_half_last_batch);
+      details::write_vector(os, stats.take_possessions());
+    }
+  }
+  details::write_raw(os, end_record);
+  os.flush();
+}
+
+std::vector<ShardPeriod> read_shard_periods(std::istream &is) {
+  auto stream_magic = decltype(magic){};
+  auto stream_version = std::uint32_t{};
+  details::read_raw(is, stream_magic);
+  details::read_raw(is, stream_version);
+  if (stream_magic != magic || stream_version != version) {
+    throw std::runtime_error{
+        "Not the output of a shard worker of this version"};
+  }
+
+  auto periods = std::vector<ShardPeriod>{};
+  while (true) {
+    auto record = std::uint8_t{};
+    details::read_raw(is, record);
+    if (record == end_record) {
+      return periods;
+    }
+    if (record != period_record) {
+      throw std::runtime_error{
+          fmt::format("Unknown shard worker record {}", record)};
+    }
+
+    auto &shard_period = periods.emplace_back();
+    auto &last = shard_period.last;
+    last.is_period_last_batch = true;
+    details::read_raw(is, last.initial_ts);
+    details::read_raw(is, last.final_ts);
+    details::read_raw(is, last.is_half_last_batch);
+    details::read_vector(is, shard_period.possessions);
+  }
+}
+} // namespace game
@@ -1,10 +1,34 @@
 #include "soccer_monitoring.hpp"
+#include "batch_operator.hpp"
+#include "batch_size_controller.hpp"
+#include "checkpoint.hpp"
 #include "context.hpp"
+#include "details/child_processes.hpp"
+#include "details/work_stealing_pool.hpp"
 #include "event_fetcher.hpp"
 #include "game_statistics.hpp"
+#include "heat_maps.hpp"
+#include "possession_timeline.hpp"
+#include "running_statistics.hpp"
+#include "sharding.hpp"
+#include "streaming_possession.hpp"
+#include "thread_pinning.hpp"
 #include "visualizer.hpp"
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <omp.h>
+#include <optional>
+#include <pthread.h>
+#include <sstream>
+#include <thread>
+#include <utility>
 #include <soccer_monitoring.hpp>
 
 namespace game {
@@ -12,12 +36,14 @@ void run_game_monitoring(int time_units, double maximum_distance,
                          std::filesystem::path const &game_data,
                          std::filesystem::path const &metadata, int nb_threads,
                          std::size_t batch_size) {
-  auto context = game::Context::build_from(metadata);
-  auto visualizer =
-      game::Visualizer{context.get_players(), context.get_teams(), time_units};
-
-  details::run_game_monitoring(time_units, maximum_distance, game_data,
-                               nb_threads, batch_size, context, visualizer);
+  auto options = MonitoringOptions{};
+  options.time_units = {time_units};
+  options.maximum_distances = {maximum_distance};
+  options.game_data = game_data;
+  options.metadata = metadata;
+  options.nb_threads = nb_threads;
+  options.batch_size = batch_size;
+  run_game_monitoring(options);
 }
 
 void run_game_monitoring(int time_units, double maximum_distance,
@@ -25,45 +51,815 @@ void run_game_monitoring(int time_units, double maximum_distance,
                          std::filesystem::path const &metadata, int nb_threads,
                          std::size_t batch_size,
                          std::string const &output_path) {
-  auto context = game::Context::build_from(metadata);
-  auto visualizer = game::Visualizer{context.get_players(), context.get_teams(),
-                                     time_units, output_path};
+  auto options = MonitoringOptions{};
+  options.time_units = {time_units};
+  options.maximum_distances = {maximum_distance};
+  options.game_data = game_data;
+  options.metadata = metadata;
+  options.nb_threads = nb_threads;
+  options.batch_size = batch_size;
+  options.output_path = output_path;
+  run_game_monitoring(options);
+}
+
+void run_game_monitoring(MonitoringOptions const &options) {
+  auto context = game::Context::build_from(options.metadata);
 
-  details::run_game_monitoring(time_units, maximum_distance, game_data,
-                               nb_threads, batch_size, context, visualizer);
+  if (options.output_path.empty()) {
+    details::run_game_monitoring(options, context, std::cout);
+  } else {
+    auto output = std::ofstream{options.output_path};
+    details::run_game_monitoring(options, context, output);
+  }
 }
 
 namespace details {
-void run_game_monitoring(int time_units, double maximum_distance,
-                         std::filesystem::path const &game_data, int nb_threads,
-                         std::size_t batch_size, Context &context,
-                         Visualizer &visualizer) {
-  auto fetcher = game::EventFetcher{game_data.string(), game::file_stream{},
-                                    time_units, batch_size, context};
-  auto stats = game::GameStatistics{maximum_distance, context};
-  omp_set_num_threads(nb_threads);
-
-  visualizer.draw();
-  auto t1 = std::chrono::steady_clock::now();
+namespace {
+using Visualizers = std::vector<std::unique_ptr<Visualizer>>;
+
+/**
+ * The batches of a period, copied out of the EventFetcher so that they can be
+ * computed while the following periods are fetched.
+ */
+struct Period {
+  std::vector<std::pair<Snapshot, std::vector<PositionEvent>>> segments = {};
+  /// The period last batch, without data
+  Batch last = {};
+};
+
+/**
+ * Prints the time spent since @p t1 on the last period and draws the partial
+ * statistics of every (K, T) configuration whose period is over.
+ */
+void draw_periods_over(GameStatistics const &stats, Visualizers &visualizers,
+                       std::chrono::picoseconds last_ts,
+                       std::chrono::steady_clock::time_point &t1) {
+  auto base_time_units = stats.base_time_units();
+  auto t2 = std::chrono::steady_clock::now();
+  std::chrono::duration<double> diff = t2 - t1;
+  fmt::print("Processed {} seconds of the stream (~ {} events) in {:.3f} "
+             "seconds\n",
+             base_time_units, base_time_units * 15000, diff.count());
+  t1 = t2;
+
+  auto nb_ts = stats.get_time_units().size();
+  for (std::size_t k = 0; k < stats.get_maximum_distances().size(); ++k) {
+    for (std::size_t t = 0; t < nb_ts; ++t) {
+      if (stats.is_period_over(t)) {
+        auto const &partials = stats.last_partial(k, t);
+        visualizers[k * nb_ts + t]->set_approximate(stats.is_approximate());
+        visualizers[k * nb_ts + t]->draw_stats(partials, false, last_ts);
+      }
+    }
+  }
+
+  if (stats.is_window_over()) {
+    auto nb_ks = stats.get_maximum_distances().size();
+    auto first = visualizers.size() - stats.get_window_lengths().size() * nb_ks;
+    for (std::size_t w = 0; w < stats.get_window_lengths().size(); ++w) {
+      for (std::size_t k = 0; k < nb_ks; ++k) {
+        auto &visualizer = visualizers[first + w * nb_ks + k];
+        visualizer->set_approximate(stats.is_approximate());
+        visualizer->draw_stats(stats.window_stats(w, k), false, last_ts);
+      }
+    }
+  }
+}
+
+/**
+ * Creates and draws one Visualizer per (K, T) configuration, indexed by
+ * k * #T + t, then one per (window, K), indexed by #K * #T + w * #K + k.
+ * Tables are labelled only if there is more than one of them.
+ */
+Visualizers make_visualizers(GameStatistics const &stats,
+                             Context const &context, std::ostream &os) {
+  auto visualizers = Visualizers{};
+  auto const &ks = stats.get_maximum_distances();
+  auto const &ts = stats.get_time_units();
+  auto const &windows = stats.get_window_lengths();
+  auto is_labelled = ks.size() * (ts.size() + windows.size()) > 1;
+  for (auto k : ks) {
+    for (auto t : ts) {
+      auto label =
+          is_labelled ? fmt::format("K = {} m, T = {} s", k, t) : std::string{};
+      visualizers.push_back(std::make_unique<Visualizer>(
+          context.get_players(), context.get_teams(), t, os, label));
+      visualizers.back()->set_timeline(context.get_timeline());
+    }
+  }
+  for (auto w : windows) {
+    for (auto k : ks) {
+      auto label = ks.size() > 1
+                       ? fmt::format("K = {} m, last {} s", k, w)
+                       : fmt::format("Last {} s", w);
+      visualizers.push_back(std::make_unique<Visualizer>(
+          context.get_players(), context.get_teams(), stats.get_window_step(),
+          os, label));
+      visualizers.back()->set_timeline(context.get_timeline());
+    }
+  }
+
+  for (auto &visualizer : visualizers) {
+    visualizer->draw();
+  }
+  return visualizers;
+}
+
+/**
+ * Draws the whole game statistics of every (K, T) configuration.
+ */
+void draw_final_stats(GameStatistics const &stats, Visualizers &visualizers) {
+  auto nb_ts = stats.get_time_units().size();
+  for (std::size_t k = 0; k < stats.get_maximum_distances().size(); ++k) {
+    auto game_stats = stats.game_stats(k);
+    for (std::size_t t = 0; t < nb_ts; ++t) {
+      visualizers[k * nb_ts + t]->set_approximate(stats.is_approximate());
+      visualizers[k * nb_ts + t]->draw_final_stats(game_stats);
+    }
+  }
+}
+
+/**
+ * @param cpus The CPU of each OpenMP thread, as returned by pin_threads()
+ * @return a hook binding each worker of a WorkStealingPool to the CPU of the
+ *         OpenMP thread of the same index, or none if threads are not pinned.
+ */
+WorkStealingPool::StartHook pin_workers(std::vector<int> const &cpus) {
+  if (cpus.empty()) {
+    return {};
+  }
+  return [cpus](std::thread &thread, std::size_t worker) {
+    pin_thread(thread.native_handle(), {cpus[worker % cpus.size()]});
+  };
+}
+
+/**
+ * @param cpus The CPU of each OpenMP thread, as returned by pin_threads()
+ * @return a hook binding a stream reader thread to the CPUs of the OpenMP
+ *         threads, or none if threads are not pinned.
+ */
+LineReader::StartHook pin_reader(std::vector<int> const &cpus) {
+  if (cpus.empty()) {
+    return {};
+  }
+  return [cpus](std::thread &thread) {
+    pin_thread(thread.native_handle(), cpus);
+  };
+}
+
+/**
+ * Ball possession as a BatchOperator: computes each batch with a
+ * GameStatistics and draws the statistics of every (K, T) configuration as
+ * periods and the game are over.
+ */
+class PossessionOperator : public BatchOperator {
+public:
+  PossessionOperator(GameStatistics &stats, Visualizers &visualizers)
+      : stats{stats}, visualizers{visualizers} {}
+
+  void on_batch(Batch const &batch) override { stats.accumulate_stats(batch); }
+  void on_period_end(Batch const &batch) override {
+    draw_periods_over(stats, visualizers, batch.final_ts, t1);
+  }
+  void on_game_end() override { draw_final_stats(stats, visualizers); }
+
+private:
+  GameStatistics &stats;
+  Visualizers &visualizers;
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+};
+
+/**
+ * Draws the possession statistics of each game clock range of every K, from
+ * the range index of @p stats. Tables are labelled with the range, and with K
+ * if there is more than one.
+ */
+void draw_range_queries(
+    GameStatistics const &stats, Context const &context, std::ostream &os,
+    std::vector<std::pair<std::chrono::seconds, std::chrono::seconds>> const
+        &queries) {
+  auto const &timeline = context.get_timeline();
+  auto to_timestamp = [&timeline](std::chrono::seconds clock) {
+    return clock < timeline.half_duration
+               ? timeline.game_start + clock
+               : timeline.break_end + clock - timeline.half_duration;
+  };
+  auto to_string = [](std::chrono::seconds clock) {
+    return fmt::format("{:02d}:{:02d}", clock.count() / 60,
+                       clock.count() % 60);
+  };
+
+  auto const &ks = stats.get_maximum_distances();
+  for (auto const &[from, to] : queries) {
+    for (std::size_t k = 0; k < ks.size(); ++k) {
+      auto label = fmt::format("Possession from {} to {}", to_string(from),
+                               to_string(to));
+      if (ks.size() > 1) {
+        label += fmt::format(", K = {} m", ks[k]);
+      }
+      auto visualizer =
+          Visualizer{context.get_players(), context.get_teams(),
+                     stats.get_time_units().front(), os, label};
+      visualizer.set_timeline(timeline);
+      visualizer.set_approximate(stats.is_approximate());
+      auto to_ts = to_timestamp(to);
+      visualizer.draw_stats(
+          stats.possession_between(to_timestamp(from), to_ts, k), false,
+          to_ts);
+    }
+  }
+}
+
+/**
+ * Computes each batch in turn with every operator of @p pipeline, ball
+ * possession parallelizing its computation across players. If the batch size
+ * is automatic, a BatchSizeController resizes the batches
+ * from the time spent fetching and computing each of them. If a checkpoint
+ * path is set, a checkpoint is written every checkpoint_periods base periods.
+ */
+void run_batch_parallel(EventFetcher &fetcher, GameStatistics &stats,
+                        OperatorPipeline &pipeline, Context const &context,
+                        MonitoringOptions const &options) {
+  auto controller = std::optional<BatchSizeController>{};
+  if (options.batch_size == 0) {
+    controller.emplace(options.target_latency, fetcher.get_batch_size());
+  }
+
+  auto fetch_start = std::chrono::steady_clock::now();
+  std::size_t nb_periods = 0;
   for (auto const &batch : fetcher) {
-    // Check if batch returned because time_units seconds are elapsed
-    stats.accumulate_stats(batch);
+    auto compute_start = std::chrono::steady_clock::now();
+
+    // Operators end their period if time_units seconds are elapsed
+    pipeline.on_batch(batch);
+
+    // The batch closing the game at EOF leaves nothing to resume
+    if (batch.is_period_last_batch && !options.checkpoint_path.empty() &&
+        !fetcher.is_game_over() &&
+        ++nb_periods % options.checkpoint_periods == 0) {
+      save_checkpoint(options.checkpoint_path, context, fetcher, stats);
+    }
+
+    if (controller) {
+      auto compute_end = std::chrono::steady_clock::now();
+      fetcher.set_batch_size(controller->observe(batch.data->size(),
+                                                 compute_start - fetch_start,
+                                                 compute_end - compute_start));
+      fetch_start = compute_end;
+    }
+  }
+}
+
+/**
+ * Processes the stream one event at a time on the calling thread, counting
+ * each possession as soon as its ball event is parsed.
+ */
+void run_streaming(EventFetcher &fetcher, GameStatistics &stats,
+                   Visualizers &visualizers, Context &context,
+                   MonitoringOptions const &options) {
+  auto streaming = StreamingPossession{stats, context};
+  streaming.set_incremental(options.incremental);
+  streaming.set_spatial_index(options.spatial_index);
+  streaming.set_foot_level(options.foot_level);
+  std::size_t nb_changes = 0;
+  streaming.set_possession_callback(
+      [&nb_changes](std::size_t, std::chrono::picoseconds) { ++nb_changes; });
+
+  auto t1 = std::chrono::steady_clock::now();
+  while (auto stream_event = fetcher.parse_stream_event()) {
+    if (streaming.process(*stream_event)) {
+      draw_periods_over(stats, visualizers, stream_event->period_final_ts, t1);
+    }
+  }
+  streaming.finish();
+  draw_periods_over(stats, visualizers, fetcher.get_stream_final_ts(), t1);
+
+  fmt::print("Ball possession changed {} times\n", nb_changes);
+  if (options.incremental) {
+    fmt::print("Incremental evaluation: {} ball events evaluated, {} skipped\n",
+               streaming.get_nb_evaluated(), streaming.get_nb_skipped());
+  }
+}
+
+/**
+ * Computes whole periods concurrently, one per task. Each thread owns a
+ * GameStatistics computing the possessions of the periods it is handed. These
+ * are then accumulated in game order, through a sequence buffer holding the
+ * periods computed ahead of the next one to display. Once more than
+ * 2 * #threads periods are pending, the submitting thread waits for them at a
+ * taskwait, computing some of them itself rather than blocking.
+ */
+void run_period_parallel(EventFetcher &fetcher, GameStatistics &stats,
+                         Visualizers &visualizers, Context &context) {
+  auto nb_threads = static_cast<std::size_t>(omp_get_max_threads());
+  auto max_pending = 2 * nb_threads;
+  auto thread_stats = std::vector<std::unique_ptr<GameStatistics>>(nb_threads);
+
+  auto sequence_buffer =
+      std::map<std::size_t, std::pair<std::vector<int>, Batch>>{};
+  auto mutex = std::mutex{};
+  std::size_t nb_submitted = 0;
+  std::size_t nb_accumulated = 0;
+  auto t1 = std::chrono::steady_clock::now();
+
+  // Accumulate, in game order, the periods computed so far
+  auto accumulate_in_order = [&]() {
+    auto lock = std::unique_lock{mutex};
+    for (auto next = sequence_buffer.find(nb_accumulated);
+         next != sequence_buffer.end();
+         next = sequence_buffer.find(nb_accumulated)) {
+      auto [possessions, last] = std::move(next->second);
+      sequence_buffer.erase(next);
+      lock.unlock();
+      stats.accumulate_possessions(possessions, last);
+      draw_periods_over(stats, visualizers, last.final_ts, t1);
+      lock.lock();
+      ++nb_accumulated;
+    }
+  };
+
+#pragma omp parallel
+#pragma omp single
+  {
+    auto period = std::make_shared<Period>();
+    for (auto const &batch : fetcher) {
+      period->segments.emplace_back(batch.snapshot, *batch.data);
+      if (!batch.is_period_last_batch) {
+        continue;
+      }
+      period->last = batch;
+      period->last.data = nullptr;
+      period->last.snapshot = {};
+      auto seq = nb_submitted++;
+
+#pragma omp task firstprivate(period, seq)
+      {
+        auto &local = thread_stats[omp_get_thread_num()];
+        if (!local) {
+          local = std::make_unique<GameStatistics>(
+              stats.get_maximum_distances(), stats.get_time_units(), context);
+        }
+        for (auto &[snapshot, data] : period->segments) {
+          local->accumulate_stats(Batch{data, false, std::move(snapshot),
+                                        period->last.initial_ts,
+                                        period->last.final_ts});
+        }
+        auto possessions = local->take_possessions();
+        auto lock = std::lock_guard{mutex};
+        sequence_buffer.emplace(
+            seq, std::make_pair(std::move(possessions), period->last));
+      }
+
+      period = std::make_shared<Period>();
+      accumulate_in_order();
+      if (nb_submitted - nb_accumulated > max_pending) {
+#pragma omp taskwait
+        accumulate_in_order();
+      }
+    }
+
+#pragma omp taskwait
+    accumulate_in_order();
+  }
+}
+
+/**
+ * Splits the stream into time shards computed by worker processes, one per
+ * shard, and accumulates the possessions of their periods in game order. The
+ * periods of a shard are accumulated once its worker and those of the previous
+ * shards are over.
+ */
+void run_sharded(GameStatistics &stats, Visualizers &visualizers,
+                 Context const &context, MonitoringOptions const &options) {
+  auto index_start = std::chrono::steady_clock::now();
+  auto shards = plan_shards(options.game_data, context, stats.base_time_units(),
+                            options.nb_shards, options.shard_lead_in);
+  std::chrono::duration<double> index_time =
+      std::chrono::steady_clock::now() - index_start;
+  fmt::print("Stream split into {} shards in {:.3f} seconds\n",
+             shards.size(), index_time.count());
+
+  // Workers compute the base periods, for every K, and share the threads
+  auto batch_size = options.batch_size == 0
+                        ? BatchSizeController::initial_batch_size
+                        : options.batch_size;
+  auto nb_threads =
+      std::max(1, options.nb_threads / static_cast<int>(shards.size()));
+  auto commands = std::vector<std::vector<std::string>>{};
+  for (auto const &shard : shards) {
+    auto &command = commands.emplace_back(
+        options.worker_command.empty()
+            ? std::vector<std::string>{"/proc/self/exe"}
+            : options.worker_command);
+    command.insert(command.end(), {"--stream", options.game_data.string(),
+                                   "--metadata", options.metadata.string(),
+                                   "--max-distance"});
+    for (auto k : stats.get_maximum_distances()) {
+      command.push_back(fmt::format("{}", k));
+    }
+    command.insert(command.end(),
+                   {"--time-units", std::to_string(stats.base_time_units()),
+                    "--threads", std::to_string(nb_threads), "--batch-size",
+                    std::to_string(batch_size), "--shard-worker",
+                    to_string(shard)});
+  }
+
+  auto outputs = std::map<std::size_t, std::string>{};
+  std::size_t nb_accumulated = 0;
+  auto t1 = std::chrono::steady_clock::now();
+  run_child_processes(commands, [&](std::size_t shard, std::string output) {
+    outputs.emplace(shard, std::move(output));
+    for (auto next = outputs.find(nb_accumulated); next != outputs.end();
+         next = outputs.find(nb_accumulated)) {
+      auto is = std::istringstream{std::move(next->second)};
+      outputs.erase(next);
+      for (auto const &period : read_shard_periods(is)) {
+        stats.accumulate_possessions(period.possessions, period.last);
+        draw_periods_over(stats, visualizers, period.last.final_ts, t1);
+      }
+      ++nb_accumulated;
+    }
+  });
+}
+
+/**
+ * A batch copied out of the EventFetcher of a match, so that the fetcher can
+ * parse the next one while it waits to be computed.
+ */
+struct QueuedBatch {
+  std::vector<PositionEvent> events = {};
+  /// The batch, whose data is events
+  Batch batch = {};
+  /// The time spent parsing the batch
+  std::chrono::steady_clock::duration fetch_time = {};
+};
+
+/**
+ * A match monitored by run_matches(). Its batches are fetched by a dedicated
+ * reader thread into a bounded queue, and computed by a dedicated compute
+ * thread. The tables of a match without output file are buffered, and then
+ * displayed by flush_tables().
+ */
+struct Match {
+  /// The maximum number of batches read ahead
+  static constexpr std::size_t capacity = 4;
+
+  /// The label of the match on the standard output stream
+  std::string label;
+  Context context;
+  std::ofstream file = {};
+  std::ostringstream tables = {};
+  std::ostream *os = &tables;
+  GameStatistics stats;
+  EventFetcher fetcher;
+  Visualizers visualizers = {};
+  std::chrono::steady_clock::time_point t1 = {};
+  /// Resizes the batches if the batch size is automatic
+  std::optional<BatchSizeController> controller = {};
+
+  std::mutex mutex = {};
+  std::condition_variable batch_ready = {};
+  std::condition_variable space_ready = {};
+  /// Guarded by mutex
+  std::deque<QueuedBatch> queue = {};
+  bool is_read = false;
+  bool is_cancelled = false;
+  std::size_t batch_size = 0;
+  std::exception_ptr error = {};
+
+  std::thread reader = {};
+  std::thread computer = {};
+  std::size_t nb_events = 0;
+  std::chrono::duration<double> compute_time = {};
+  std::chrono::duration<double> elapsed = {};
+
+  Match(std::size_t index, MatchFiles const &files,
+        MonitoringOptions const &options, std::size_t batch_size)
+      : label{fmt::format("Match {} ({})", index, files.game_data.string())},
+        context{Context::build_from(files.metadata)},
+        stats{options.maximum_distances, options.time_units, context},
+        fetcher{files.game_data.string(), file_stream{},
+                stats.base_time_units(), batch_size, context},
+        batch_size{batch_size} {
+    if (!files.output_path.empty()) {
+      file.open(files.output_path);
+      os = &file;
+    }
+    if (options.batch_size == 0) {
+      controller.emplace(options.target_latency, batch_size);
+    }
+  }
+};
 
-    if (batch.is_period_last_batch) {
-      auto const &partials = stats.last_partial();
+/**
+ * Reads every batch of @p match into its queue, waiting while the queue is
+ * full, and resizes the batches as told by the compute thread. The calling
+ * thread is first bound to @p cpus, if any.
+ */
+void read_match(Match &match, std::vector<int> const &cpus) {
+  try {
+    pin_thread(pthread_self(), cpus);
+    auto fetch_start = std::chrono::steady_clock::now();
+    for (auto const &batch : match.fetcher) {
+      auto queued = QueuedBatch{*batch.data, batch,
+                                std::chrono::steady_clock::now() - fetch_start};
+      auto batch_size = std::size_t{0};
+      {
+        auto lock = std::unique_lock{match.mutex};
+        match.space_ready.wait(lock, [&] {
+          return match.queue.size() < Match::capacity || match.is_cancelled;
+        });
+        if (match.is_cancelled) {
+          break;
+        }
+        match.queue.push_back(std::move(queued));
+        // Point the batch to its own copy of the data
+        match.queue.back().batch.data = &match.queue.back().events;
+        batch_size = match.batch_size;
+      }
+      match.batch_ready.notify_one();
+      match.fetcher.set_batch_size(batch_size);
+      fetch_start = std::chrono::steady_clock::now();
+    }
+  } catch (...) {
+    auto lock = std::lock_guard{match.mutex};
+    match.error = std::current_exception();
+  }
+
+  {
+    auto lock = std::lock_guard{match.mutex};
+    match.is_read = true;
+  }
+  match.batch_ready.notify_one();
+}
+
+/**
+ * Displays the tables buffered by @p match on the standard output stream,
+ * under the label of the match. @p output_mutex keeps the tables of concurrent
+ * matches apart.
+ */
+void flush_tables(Match &match, std::mutex &output_mutex) {
+  auto tables = match.tables.str();
+  if (tables.empty()) {
+    return;
+  }
+  match.tables.str({});
+  auto lock = std::lock_guard{output_mutex};
+  std::cout << match.label << ":\n" << tables << std::flush;
+}
+
+/**
+ * Computes every batch of @p match as it is queued, then draws its final
+ * statistics. The calling thread is first bound to @p cpus, if any.
+ */
+void compute_match(Match &match, std::vector<int> const &cpus,
+                   std::mutex &output_mutex,
+                   std::chrono::steady_clock::time_point start) {
+  try {
+    pin_thread(pthread_self(), cpus);
+    while (true) {
+      auto lock = std::unique_lock{match.mutex};
+      match.batch_ready.wait(
+          lock, [&] { return !match.queue.empty() || match.is_read; });
+      if (match.queue.empty()) {
+        break;
+      }
+      auto queued = std::move(match.queue.front());
+      match.queue.pop_front();
+      lock.unlock();
+      match.space_ready.notify_one();
+      queued.batch.data = &queued.events;
 
-      auto t2 = std::chrono::steady_clock::now();
-      std::chrono::duration<double> diff = t2 - t1;
-      fmt::print("Processed {} seconds of the stream (~ {} events) in {:.3f} "
-                 "seconds\n",
-                 time_units, time_units * 15000, diff.count());
-      t1 = t2;
-      visualizer.draw_stats(partials, false, batch.final_ts);
+      auto compute_start = std::chrono::steady_clock::now();
+      match.stats.accumulate_stats(queued.batch);
+      auto compute_end = std::chrono::steady_clock::now();
+      match.compute_time += compute_end - compute_start;
+      match.nb_events += queued.events.size();
+      if (queued.batch.is_period_last_batch) {
+        draw_periods_over(match.stats, match.visualizers,
+                          queued.batch.final_ts, match.t1);
+        flush_tables(match, output_mutex);
+      }
+
+      if (match.controller) {
+        auto batch_size = match.controller->observe(
+            queued.events.size(), queued.fetch_time,
+            compute_end - compute_start);
+        auto lock = std::lock_guard{match.mutex};
+        match.batch_size = batch_size;
+      }
+    }
+  } catch (...) {
+    {
+      auto lock = std::lock_guard{match.mutex};
+      if (!match.error) {
+        match.error = std::current_exception();
+      }
+      match.is_cancelled = true;
     }
+    match.space_ready.notify_one();
   }
 
-  auto game_stats = stats.game_stats();
-  visualizer.draw_final_stats(game_stats);
+  match.elapsed = std::chrono::steady_clock::now() - start;
+  auto lock = std::lock_guard{match.mutex};
+  if (!match.error) {
+    draw_final_stats(match.stats, match.visualizers);
+    flush_tables(match, output_mutex);
+  }
+}
+} // namespace
+
+void run_game_monitoring(MonitoringOptions const &options, Context &context,
+                         std::ostream &os) {
+  auto stats = game::GameStatistics{options.maximum_distances,
+                                    options.time_units, context};
+  auto is_sharded = options.nb_shards > 1;
+  if (!options.streaming && !options.period_parallel && !is_sharded) {
+    stats.set_sampling(options.sampling);
+  }
+  if (!options.range_queries.empty() && !options.period_parallel &&
+      !is_sharded) {
+    stats.set_range_index(options.range_resolution);
+  }
+  stats.set_sliding_windows(options.window_lengths, options.window_step);
+  auto batch_size = options.batch_size == 0
+                        ? BatchSizeController::initial_batch_size
+                        : options.batch_size;
+  auto fetcher =
+      options.event_store != nullptr
+          ? game::EventFetcher{*options.event_store, stats.base_time_units(),
+                               batch_size, context}
+          : game::EventFetcher{options.game_data.string(), game::file_stream{},
+                               stats.base_time_units(), batch_size, context};
+  auto is_resumed = options.resume && options.event_store == nullptr &&
+                    std::filesystem::exists(options.checkpoint_path);
+
+  // A resumed timeline is appended to from the offset checkpointed
+  auto timeline_file = std::ofstream{};
+  auto timeline = std::optional<PossessionTimeline>{};
+  if (!options.timeline_path.empty() && !options.period_parallel &&
+      !is_sharded) {
+    if (is_resumed && std::filesystem::exists(options.timeline_path)) {
+      timeline_file.open(options.timeline_path, std::ios::in | std::ios::out);
+    } else {
+      timeline_file.open(options.timeline_path);
+    }
+    timeline.emplace(timeline_file, stats.get_player_names());
+    stats.set_timeline(&*timeline);
+  }
+  if (is_resumed) {
+    restore_checkpoint(options.checkpoint_path, context, fetcher, stats);
+    fmt::print("Resumed from checkpoint {}\n",
+               options.checkpoint_path.string());
+    if (timeline) {
+      // Drop the segments written after the checkpoint
+      timeline_file.flush();
+      auto offset = static_cast<std::streamoff>(timeline_file.tellp());
+      std::filesystem::resize_file(options.timeline_path, offset);
+    }
+  }
+  if (!options.archive_path.empty()) {
+    stats.set_archive(options.archive_path, is_resumed);
+  }
+  omp_set_num_threads(options.nb_threads);
+  auto cpus = pin_threads(options.pinning, omp_get_max_threads());
+  if (!cpus.empty()) {
+    fmt::print("Threads bound to CPUs {}\n", fmt::join(cpus, ", "));
+  }
+  if (options.max_emission_delay.count() > 0 && !options.streaming) {
+    fetcher.set_emission_delay(options.max_emission_delay, pin_reader(cpus));
+  }
+
+  auto visualizers = make_visualizers(stats, context, os);
+  auto possession = PossessionOperator{stats, visualizers};
+  auto pipeline = OperatorPipeline{};
+  pipeline.add(possession);
+  auto running = std::optional<RunningStatistics>{};
+  auto heat_map_file = std::ofstream{};
+  auto heat_maps = std::optional<HeatMaps>{};
+  if (!options.streaming && !options.period_parallel && !is_sharded) {
+    if (options.running && options.event_store == nullptr) {
+      fetcher.set_speed_parsing(true);
+      running.emplace(stats.get_time_units(), stats.base_time_units(),
+                      context, os);
+      pipeline.add(*running);
+    }
+    if (!options.heat_map_path.empty()) {
+      heat_map_file.open(options.heat_map_path);
+      heat_maps.emplace(options.heat_map_grid, stats.get_time_units(),
+                        stats.base_time_units(), context, heat_map_file);
+      pipeline.add(*heat_maps);
+    }
+    for (auto *op : options.operators) {
+      pipeline.add(*op);
+    }
+  }
+
+  if (is_sharded) {
+    run_sharded(stats, visualizers, context, options);
+  } else if (options.streaming) {
+    run_streaming(fetcher, stats, visualizers, context, options);
+  } else if (options.period_parallel) {
+    run_period_parallel(fetcher, stats, visualizers, context);
+  } else if (options.scheduler == Scheduler::work_stealing) {
+    auto nb_workers = static_cast<std::size_t>(omp_get_max_threads());
+    auto pool = WorkStealingPool{nb_workers, pin_workers(cpus)};
+    stats.set_worker_pool(&pool);
+    run_batch_parallel(fetcher, stats, pipeline, context, options);
+    stats.set_worker_pool(nullptr);
+
+    std::chrono::duration<double> idle_time = pool.idle_time();
+    fmt::print("Work stealing: {} steals, {:.3f} seconds idle over {} "
+               "workers\n",
+               pool.nb_steals(), idle_time.count(), pool.nb_workers());
+  } else {
+    run_batch_parallel(fetcher, stats, pipeline, context, options);
+  }
+
+  if (auto const &report = stats.get_sampling_report();
+      report.nb_ball_events > 0) {
+    fmt::print("Approximate mode: {} of {} ball events evaluated, {} base "
+               "periods counted from samples only\n",
+               report.nb_samples, report.nb_ball_events,
+               report.approximate_periods);
+    if (report.calibration_periods > 0) {
+      fmt::print("Calibration over {} periods: possession share error of "
+                 "{:.3f} points at most, {:.3f} points on average\n",
+                 report.calibration_periods, report.max_error,
+                 report.mean_error);
+    }
+  }
+
+  if (timeline) {
+    timeline->cut();
+    fmt::print("Possession timeline: {} segments\n",
+               timeline->get_nb_segments());
+  }
+
+  pipeline.on_game_end();
+  if (!options.range_queries.empty() && !options.period_parallel &&
+      !is_sharded) {
+    draw_range_queries(stats, context, os, options.range_queries);
+  }
 }
 } // namespace details
-} // namespace game
\ No newline at end of file
+
+void run_matches(MonitoringOptions const &options,
+                 std::vector<MatchFiles> const &files) {
+  using namespace details;
+
+  auto batch_size = options.batch_size == 0
+                        ? BatchSizeController::initial_batch_size
+                        : options.batch_size;
+  omp_set_num_threads(options.nb_threads);
+  auto cpus = pin_threads(options.pinning, omp_get_max_threads());
+  if (!cpus.empty()) {
+    fmt::print("Threads bound to CPUs {}\n", fmt::join(cpus, ", "));
+  }
+  auto pool = WorkStealingPool{static_cast<std::size_t>(omp_get_max_threads()),
+                               pin_workers(cpus)};
+
+  auto matches = std::vector<std::unique_ptr<Match>>{};
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    auto &match = *matches.emplace_back(
+        std::make_unique<Match>(i, files[i], options, batch_size));
+    match.stats.set_worker_pool(&pool);
+    match.stats.set_sampling(options.sampling);
+    match.visualizers = make_visualizers(match.stats, match.context, *match.os);
+    if (options.max_emission_delay.count() > 0) {
+      match.fetcher.set_emission_delay(options.max_emission_delay,
+                                       pin_reader(cpus));
+    }
+  }
+
+  // Each match computes its batches as they are read, submitting them to the
+  // worker pool shared by the matches, so that a slow match does not delay
+  // the others
+  auto output_mutex = std::mutex{};
+  auto start = std::chrono::steady_clock::now();
+  for (auto &match : matches) {
+    match->t1 = start;
+    match->reader = std::thread{read_match, std::ref(*match), std::cref(cpus)};
+    match->computer =
+        std::thread{compute_match, std::ref(*match), std::cref(cpus),
+                    std::ref(output_mutex), start};
+  }
+  for (auto &match : matches) {
+    match->reader.join();
+    match->computer.join();
+  }
+
+  for (auto const &match : matches) {
+    fmt::print("{}: {} events in {:.3f} seconds ({:.0f} events/s), "
+               "{:.3f} seconds of computation\n",
+               match->label, match->nb_events, match->elapsed.count(),
+               match->nb_events / match->elapsed.count(),
+               match->compute_time.count());
+  }
+  for (auto const &match : matches) {
+    if (match->error) {
+      std::rethrow_exception(match->error);
+    }
+  }
+}
+} // namespace game
@@ -0,0 +1,238 @@
+#include "streaming_possession.hpp"
+#include "distance.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace game {
+StreamingPossession::StreamingPossession(GameStatistics &stats,
+                                         Context const &context)
+    : stats{stats} {
+  ball = std::get<BallPosition>(context.get_ball_position());
+  auto ball_sids = ball.get_sids();
+
+  auto player_names = context.get_player_names();
+  auto max_sid = ball_sids.empty()
+                     ? 0
+                     : *std::max_element(ball_sids.cbegin(), ball_sids.cend());
+  for (auto const &name : player_names) {
+    auto const &sids = context.get_player_sids(name);
+    max_sid = std::max(max_sid, *std::max_element(sids.cbegin(), sids.cend()));
+  }
+
+  entities.resize(max_sid + 1, no_entity);
+  sensor_slots.resize(max_sid + 1);
+  for (auto sid : ball_sids) {
+    entities[sid] = ball_entity;
+  }
+  for (std::size_t i = 0; i < player_names.size(); ++i) {
+    auto const &sids = context.get_player_sids(player_names[i]);
+    players.push_back(std::get<PlayerPosition>(context.get_position(sids[0])));
+    for (auto sid : sids) {
+      entities[sid] = static_cast<int>(i);
+      auto [x, y, z] = players.back().get_sensor(sid);
+      sensor_slots[sid] = sensor_players.size();
+      sensor_xs.push_back(x);
+      sensor_ys.push_back(y);
+      sensor_zs.push_back(z);
+      sensor_players.push_back(i);
+    }
+  }
+  squared_distances.resize(sensor_players.size());
+}
+
+bool StreamingPossession::process(StreamEvent const &stream_event) {
+  auto const &event = stream_event.event;
+  last_ts = event.get_timestamp();
+
+  if (stream_event.is_period_over) {
+    stats.close_period(last_ts, stream_event.is_half_over);
+  }
+
+  auto sid = event.get_sid();
+  auto entity = static_cast<std::size_t>(sid) < entities.size()
+                    ? entities[sid]
+                    : no_entity;
+  auto coordinates = std::make_tuple(event.get_x(), event.get_y(),
+                                     event.get_z());
+  if (!stream_event.is_position_update) {
+    return stream_event.is_period_over;
+  }
+  if (entity >= 0) {
+    update_player(entity, sid, coordinates);
+  } else if (entity == ball_entity) {
+    ball.update_sensor(sid, coordinates);
+    if (stream_event.is_in_play) {
+      update_possession(last_ts);
+    }
+  }
+  return stream_event.is_period_over;
+}
+
+void StreamingPossession::finish() { stats.close_period(last_ts, true); }
+
+void StreamingPossession::update_possession(std::chrono::picoseconds ts) {
+  if (is_foot_level) {
+    update_possession_by_sensor(ts);
+    return;
+  }
+  auto ball_vector = ball.vector();
+
+  if (is_incremental && winner != none_player) {
+    // Every other player is at least runner_up_distance - ball movement -
+    // player movement away from the ball. If the winner is still closer, the
+    // outcome of a full evaluation is the winner at its current distance.
+    auto winner_distance =
+        distance::euclidean(ball_vector, players[winner].vector());
+    auto ball_movement = distance::euclidean(ball_vector, evaluated_ball);
+    auto bound = runner_up_distance - ball_movement - max_player_movement;
+    if (winner_distance + margin_tolerance < bound) {
+      ++nb_skipped;
+      count_possession(winner, winner_distance, ts);
+      return;
+    }
+  }
+
+  auto [closest, min_distance, second_distance] = closest_players(ball_vector);
+  ++nb_evaluated;
+
+  if (is_incremental) {
+    winner = closest;
+    runner_up_distance = second_distance;
+    evaluated_ball = ball_vector;
+    for (std::size_t i = 0; i < players.size(); ++i) {
+      evaluated_players[i] = players[i].vector();
+    }
+    max_player_movement = 0;
+  }
+
+  count_possession(closest, min_distance, ts);
+}
+
+void StreamingPossession::update_possession_by_sensor(
+    std::chrono::picoseconds ts) {
+  auto [bx, by, bz] = ball.vector();
+  auto nb_sensors = sensor_players.size();
+  auto const *xs = sensor_xs.data();
+  auto const *ys = sensor_ys.data();
+  auto const *zs = sensor_zs.data();
+  auto *distances = squared_distances.data();
+
+#pragma omp simd
+  for (std::size_t i = 0; i < nb_sensors; ++i) {
+    auto dx = xs[i] - bx;
+    auto dy = ys[i] - by;
+    auto dz = zs[i] - bz;
+    distances[i] = dx * dx + dy * dy + dz * dz;
+  }
+
+  // Sensors are laid out player by player: ties go to the lowest player index
+  auto closest = none_player;
+  auto min_distance = GameStatistics::infinite_distance;
+  for (std::size_t i = 0; i < nb_sensors; ++i) {
+    if (distances[i] < min_distance) {
+      min_distance = distances[i];
+      closest = i;
+    }
+  }
+  ++nb_evaluated;
+
+  if (closest == none_player) {
+    count_possession(none_player, min_distance, ts);
+  } else {
+    count_possession(sensor_players[closest], std::sqrt(min_distance), ts);
+  }
+}
+
+std::tuple<std::size_t, double, double> StreamingPossession::closest_players(
+    std::tuple<double, double, double> const &ball_vector) const {
+  auto closest = none_player;
+  auto min_distance = GameStatistics::infinite_distance;
+  auto second_distance = GameStatistics::infinite_distance;
+  auto evaluate = [&](std::size_t i) {
+    auto distance = distance::euclidean(ball_vector, players[i].vector());
+    // Ties go to the lowest index, whatever the order players are visited in
+    if (distance < min_distance ||
+        (distance == min_distance && i < closest)) {
+      second_distance = min_distance;
+      min_distance = distance;
+      closest = i;
+    } else if (distance < second_distance) {
+      second_distance = distance;
+    }
+  };
+
+  if (!grid) {
+    for (std::size_t i = 0; i < players.size(); ++i) {
+      evaluate(i);
+    }
+    return {closest, min_distance, second_distance};
+  }
+
+  auto [x, y, z] = ball_vector;
+  grid->for_each_near(x, y, evaluate);
+  // Players outside of the 3x3 cells are at least a cell size away
+  second_distance = std::min(second_distance, grid->get_cell_size());
+  return {closest, min_distance, second_distance};
+}
+
+void StreamingPossession::update_player(std::size_t player, int sid,
+                                        std::tuple<int, int, int> coordinates) {
+  players[player].update_sensor(sid, coordinates);
+  auto slot = sensor_slots[sid];
+  sensor_xs[slot] = std::get<0>(coordinates);
+  sensor_ys[slot] = std::get<1>(coordinates);
+  sensor_zs[slot] = std::get<2>(coordinates);
+  if (grid) {
+    auto [x, y, z] = players[player].vector();
+    grid->update(player, x, y);
+  }
+
+  // The winner distance is computed anew on each ball event, only the others
+  // bound the outcome
+  if (is_incremental && winner != none_player && player != winner) {
+    auto movement = distance::euclidean(players[player].vector(),
+                                        evaluated_players[player]);
+    max_player_movement = std::max(max_player_movement, movement);
+  }
+}
+
+void StreamingPossession::count_possession(std::size_t closest,
+                                           double distance,
+                                           std::chrono::picoseconds ts) {
+  if (closest != none_player &&
+      !stats.accumulate_possession(closest, distance)) {
+    closest = none_player;
+  }
+  stats.record_ball_event(
+      closest == none_player ? PossessionTimeline::none_player : closest,
+      distance, ts);
+
+  if (closest != possessor) {
+    possessor = closest;
+    if (on_possession_change) {
+      on_possession_change(possessor, ts);
+    }
+  }
+}
+
+void StreamingPossession::set_incremental(bool is_incremental) {
+  this->is_incremental = is_incremental;
+  evaluated_players.resize(players.size());
+  winner = none_player;
+}
+
+void StreamingPossession::set_spatial_index(bool is_indexed) {
+  if (!is_indexed) {
+    grid.reset();
+    return;
+  }
+
+  auto max_distance = stats.get_maximum_distances().back() * 1000;
+  grid.emplace(max_distance + cell_tolerance, players.size());
+  for (std::size_t i = 0; i < players.size(); ++i) {
+    auto [x, y, z] = players[i].vector();
+    grid->update(i, x, y);
+  }
+}
+} // namespace game
@@ -0,0 +1,188 @@
+#include "thread_pinning.hpp"
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <fstream>
+#include <map>
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <tuple>
+
+#include "fmt/format.h"
+
+namespace game {
+namespace {
+/**
+ * Reads an integer topology attribute of a CPU from sysfs.
+ *
+ * @return the attribute value, or @p fallback if it cannot be read.
+ */
+int read_topology(int cpu, std::string const &attribute, int fallback) {
+  auto path = fmt::format("/sys/devices/system/cpu/cpu{}/topology/{}", cpu,
+                          attribute);
+  auto is = std::ifstream{path};
+  auto value = fallback;
+  if (!(is >> value)) {
+    return fallback;
+  }
+  return value;
+}
+} // namespace
+
+ThreadPinning parse_thread_pinning(std::string const &value) {
+  if (value == "none") {
+    return {PinPolicy::none, {}};
+  } else if (value == "compact") {
+    return {PinPolicy::compact, {}};
+  } else if (value == "spread") {
+    return {PinPolicy::spread, {}};
+  }
+
+  // A list of CPU ids and ranges of CPU ids, e.g. 0,2,4-7
+  auto pinning = ThreadPinning{PinPolicy::list, {}};
+  auto tokens = std::vector<std::string>{};
+  boost::split(tokens, value, boost::is_any_of(","));
+  try {
+    for (auto const &token : tokens) {
+      auto bounds = std::vector<std::string>{};
+      boost::split(bounds, token, boost::is_any_of("-"));
+      auto first = std::stoi(bounds.front());
+      auto last = std::stoi(bounds.back());
+      if (bounds.size() > 2 || first < 0 || last < first) {
+        throw std::invalid_argument{token};
+      }
+      for (auto cpu = first; cpu <= last; ++cpu) {
+        pinning.cpus.push_back(cpu);
+      }
+    }
+  } catch (std::logic_error const &) {
+    throw std::invalid_argument{
+        fmt::format("Invalid thread pinning \"{}\"", value)};
+  }
+  return pinning;
+}
+
+std::vector<Cpu> available_cpus() {
+  auto set = cpu_set_t{};
+  CPU_ZERO(&set);
+  auto cpus = std::vector<Cpu>{};
+
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int id = 0; id < CPU_SETSIZE; ++id) {
+      if (CPU_ISSET(id, &set)) {
+        cpus.push_back({id, read_topology(id, "physical_package_id", 0),
+                        read_topology(id, "core_id", id)});
+      }
+    }
+  } else {
+    for (int id = 0; id < omp_get_num_procs(); ++id) {
+      cpus.push_back({id, 0, id});
+    }
+  }
+  return cpus;
+}
+
+std::vector<int> assign_cpus(ThreadPinning const &pinning,
+                             std::vector<Cpu> const &cpus, int nb_threads) {
+  auto order = std::vector<int>{};
+
+  switch (pinning.policy) {
+  case PinPolicy::none:
+    return {};
+  case PinPolicy::list:
+    order = pinning.cpus;
+    break;
+  case PinPolicy::compact: {
+    // Sockets one after the other, hyper-threads of a core next to each other
+    auto sorted = cpus;
+    std::sort(sorted.begin(), sorted.end(), [](auto const &a, auto const &b) {
+      return std::tie(a.package, a.core, a.id) <
+             std::tie(b.package, b.core, b.id);
+    });
+    for (auto const &cpu : sorted) {
+      order.push_back(cpu.id);
+    }
+    break;
+  }
+  case PinPolicy::spread: {
+    // In each socket, the first hyper-thread of every core comes before the
+    // second one. Sockets are then interleaved.
+    auto sockets = std::map<int, std::vector<std::tuple<int, int, int>>>{};
+    auto siblings = std::map<std::pair<int, int>, int>{};
+    for (auto const &cpu : cpus) {
+      auto sibling = siblings[{cpu.package, cpu.core}]++;
+      sockets[cpu.package].emplace_back(sibling, cpu.core, cpu.id);
+    }
+    std::size_t largest = 0;
+    for (auto &[package, socket_cpus] : sockets) {
+      std::sort(socket_cpus.begin(), socket_cpus.end());
+      largest = std::max(largest, socket_cpus.size());
+    }
+    for (std::size_t i = 0; i < largest; ++i) {
+      for (auto const &[package, socket_cpus] : sockets) {
+        if (i < socket_cpus.size()) {
+          order.push_back(std::get<2>(socket_cpus[i]));
+        }
+      }
+    }
+    break;
+  }
+  }
+
+  if (order.empty()) {
+    return {};
+  }
+  auto assignment = std::vector<int>(nb_threads);
+  for (int thread = 0; thread < nb_threads; ++thread) {
+    assignment[thread] = order[thread % order.size()];
+  }
+  return assignment;
+}
+
+std::vector<int> pin_threads(ThreadPinning const &pinning, int nb_threads) {
+  auto assignment = assign_cpus(pinning, available_cpus(), nb_threads);
+  if (assignment.empty()) {
+    return {};
+  }
+
+  auto failures = 0;
+#pragma omp parallel num_threads(nb_threads) reduction(+ : failures)
+  {
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    CPU_SET(assignment[omp_get_thread_num()], &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      ++failures;
+    }
+  }
+
+  if (failures > 0) {
+    throw std::runtime_error{
+        fmt::format("Could not bind {} of {} threads to their CPU", failures,
+                    nb_threads)};
+  }
+  return assignment;
+}
+
+void pin_thread(std::thread::native_handle_type thread,
+                std::vector<int> const &cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+
+  auto set = cpu_set_t{};
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      throw std::runtime_error{fmt::format("Invalid CPU id {}", cpu)};
+    }
+    CPU_SET(cpu, &set);
+  }
+  if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0) {
+    throw std::runtime_error{fmt::format("Could not bind a thread to CPUs {}",
+                                         fmt::join(cpus, ","))};
+  }
+}
+} // namespace game
@@ -20,6 +20,16 @@ Visualizer::Visualizer(PlayerMap const &players, TeamMap const &teams,
       partials{std::map<std::string, double, details::PartialsCmp>(
           details::PartialsCmp{teams})} {
   os = new std::ofstream(output_path);
+  owns_stream = true;
+  init_partials(teams);
+}
+
+Visualizer::Visualizer(PlayerMap const &players, TeamMap const &teams,
+                       int time_units, std::ostream &os, std::string label)
+    : os{&os}, label{std::move(label)}, players{players}, teams{teams},
+      partials{std::map<std::string, double, details::PartialsCmp>(
+          details::PartialsCmp{teams})},
+      time_units{time_units} {
   init_partials(teams);
 }
 
@@ -67,19 +77,18 @@ void Visualizer::init_partials(TeamMap const &teams) {
 void Visualizer::update_game_time(std::chrono::picoseconds last_ts) {
   namespace chrono = std::chrono;
   // Increment game time
-  if (last_ts >= game_start) {
+  if (last_ts >= timeline.game_start) {
     // Add epsilon to round the numbers off
     last_ts += chrono::milliseconds(1);
-    if (last_ts <= break_start) {
-      game_time = chrono::duration_cast<chrono::seconds>(last_ts - game_start);
-    } else if (break_start < last_ts && last_ts < break_end) {
-      game_time = chrono::duration_cast<chrono::seconds>(official_break_start -
-                                                         game_start);
+    if (last_ts <= timeline.break_start) {
+      game_time =
+          chrono::duration_cast<chrono::seconds>(last_ts - timeline.game_start);
+    } else if (timeline.break_start < last_ts && last_ts < timeline.break_end) {
+      game_time = chrono::duration_cast<chrono::seconds>(
+          timeline.official_break_start - timeline.game_start);
     } else {
-      auto first_half_duration = chrono::duration_cast<chrono::seconds>(
-          official_break_start - game_start);
       game_time = chrono::duration_cast<chrono::seconds>(
-          expected_half_duration + last_ts - break_end);
+          timeline.half_duration + last_ts - timeline.break_end);
     }
   } else {
     game_time = game_time + chrono::seconds(time_units);
@@ -87,6 +96,12 @@ void Visualizer::update_game_time(std::chrono::picoseconds last_ts) {
 }
 
 void Visualizer::draw() {
+  if (!label.empty()) {
+    *os << label << '\n';
+  }
+  if (is_approximate) {
+    *os << "Approximate: computed from sampled ball events\n";
+  }
   draw_separator();
   draw_teams_header();
   draw_teams_entry();
@@ -169,7 +184,7 @@ void Visualizer::draw_teams_header() {
 }
 
 Visualizer::~Visualizer() {
-  if (os != &std::cout) {
+  if (owns_stream) {
     delete os;
   }
 }
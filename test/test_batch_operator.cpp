@@ -0,0 +1,114 @@
+#include "catch.hpp"
+
+#include "batch_operator.hpp"
+#include "context.hpp"
+#include "soccer_monitoring.hpp"
+#include "test_dataset.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+ * Counts what it is fed, logging the calls of each hook to a log shared with
+ * other operators.
+ */
+class CountingOperator : public game::BatchOperator {
+public:
+  CountingOperator(char name, std::string &log) : name{name}, log{log} {}
+
+  void on_batch(game::Batch const &batch) override {
+    nb_events += batch.data->size();
+    log += name;
+  }
+  void on_period_end(game::Batch const &batch) override {
+    ++nb_periods;
+    nb_half_ends += batch.is_half_last_batch ? 1 : 0;
+    log += '|';
+  }
+  void on_game_end() override {
+    ++nb_game_ends;
+    log += '.';
+  }
+
+  std::size_t nb_events = 0;
+  std::size_t nb_periods = 0;
+  std::size_t nb_half_ends = 0;
+  std::size_t nb_game_ends = 0;
+
+private:
+  char name;
+  std::string &log;
+};
+} // namespace
+
+TEST_CASE("Operators are fed every batch in a single pass") {
+  namespace fs = std::filesystem;
+
+  auto game_data = fs::temp_directory_path() / "test_batch_operator_stream";
+  auto metadata_path =
+      fs::temp_directory_path() / "test_batch_operator_metadata";
+  std::ofstream{game_data} << game_data_start_10_50;
+  std::ofstream{metadata_path} << metadata;
+
+  auto options = game::MonitoringOptions{};
+  options.time_units = {1};
+  options.maximum_distances = {3};
+  options.game_data = game_data;
+  options.metadata = metadata_path;
+  options.nb_threads = 1;
+  options.batch_size = 4;
+  auto monitor = [](game::MonitoringOptions const &options) {
+    auto context = game::Context::build_from(options.metadata);
+    auto os = std::ostringstream{};
+    game::details::run_game_monitoring(options, context, os);
+    return os.str();
+  };
+  auto possession_only = monitor(options);
+
+  auto log = std::string{};
+  auto first = CountingOperator{'a', log};
+  auto second = CountingOperator{'b', log};
+  options.operators = {&first, &second};
+
+  SECTION("Operators run along possession, in turn") {
+    REQUIRE(monitor(options) == possession_only);
+    REQUIRE(first.nb_events > 0);
+    REQUIRE(first.nb_events == second.nb_events);
+    REQUIRE(first.nb_periods > 0);
+    REQUIRE(first.nb_periods == second.nb_periods);
+    REQUIRE(first.nb_half_ends == 1);
+    REQUIRE(first.nb_game_ends == 1);
+    REQUIRE(second.nb_game_ends == 1);
+    REQUIRE(log.rfind("ab", 0) == 0);
+    REQUIRE(log.find("ab||") != std::string::npos);
+    REQUIRE(log.substr(log.size() - 2) == "..");
+  }
+
+  SECTION("Operators are not fed in streaming mode") {
+    options.streaming = true;
+    monitor(options);
+    REQUIRE(first.nb_events == 0);
+    REQUIRE(log.empty());
+  }
+
+  SECTION("Operators are fed by a pipeline") {
+    auto pipeline = game::OperatorPipeline{};
+    pipeline.add(first);
+    REQUIRE(pipeline.size() == 1);
+    auto data = std::vector<game::PositionEvent>(3);
+    pipeline.on_batch(game::Batch{data, false, {}, {}, {}});
+    pipeline.on_batch(game::Batch{data, true, {}, {}, {}, true});
+    pipeline.on_game_end();
+    REQUIRE(first.nb_events == 6);
+    REQUIRE(first.nb_periods == 1);
+    REQUIRE(first.nb_half_ends == 1);
+    REQUIRE(log == "aa|.");
+  }
+  fs::remove(game_data);
+  fs::remove(metadata_path);
+}
@@ -1,5 +1,10 @@
+#include "event.hpp"
+
+#include <chrono>
 #include <string>
 
+#include "fmt/format.h"
+
 using namespace std::literals;
 
 const auto metadata = "BALL,1,4\n"
@@ -189,4 +194,43 @@ const auto game_data_start_10_50 =
     "147,9998,-69\n"
     "SE,63,10753298684541989,36986,5572,177,1064446,1365881,8021,-5405,"
     "2536,"
-    "6696,6996,2491\n"s;
\ No newline at end of file
+    "6696,6996,2491\n"s;
+
+/**
+ * Over 8 seconds from game start, Nick Gertje and Leon Krapf swap sides at the
+ * start of every second, the ball staying 2 m away from the side of Nick
+ * Gertje in even seconds. The game is paused from 3.5 to 5.5 seconds, so that
+ * the players do not move over seconds 4 and 5.
+ */
+inline std::string swapping_sides_dataset() {
+  using namespace std::chrono_literals;
+
+  auto at = [](std::chrono::picoseconds ts) {
+    return (game::game_start + ts).count();
+  };
+  auto event = [&at](int sid, std::chrono::picoseconds ts, int x) {
+    return fmt::format("SE,{},{},{},0,0,0,0,0,0,0,0,0,0\n", sid, at(ts), x);
+  };
+  auto dataset = std::string{};
+  for (int second = 0; second < 8; ++second) {
+    auto ts = std::chrono::picoseconds{second * 1s};
+    for (auto sid : {13, 14, 97, 98}) {
+      dataset += event(sid, ts + 100ms, second % 2 == 0 ? 10000 : 40000);
+    }
+    for (auto sid : {61, 62, 99, 100}) {
+      dataset += event(sid, ts + 100ms, second % 2 == 0 ? 40000 : 10000);
+    }
+    for (int i = 2; i < 10; ++i) {
+      if (second == 3 && i == 5) {
+        dataset += fmt::format("GI,2010,Game Interruption Begin,0,{},1,empty\n",
+                               at(ts + 500ms));
+      } else if (second == 5 && i == 5) {
+        dataset += fmt::format(
+            "GI,2011,Game Interruption End,00:00:02.000,{},1,empty\n",
+            at(ts + 500ms));
+      }
+      dataset += event(4, ts + i * 100ms, 12000);
+    }
+  }
+  return dataset;
+}
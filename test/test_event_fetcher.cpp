@@ -1,15 +1,25 @@
+#include "batch_size_controller.hpp"
 #include "catch.hpp"
 #include "context.hpp"
 #include "event.hpp"
 #include "event_fetcher.hpp"
+#include "event_store.hpp"
 #include "metadata.hpp"
 #include "stream_types.hpp"
 #include "test_dataset.hpp"
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <game_statistics.hpp>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <variant>
+#include <unistd.h>
+#include <vector>
 #include <visualizer.hpp>
 
 TEST_CASE("Test Event Fetcher", "[event_fetcher]") {
@@ -116,6 +126,208 @@ TEST_CASE("Test Event Fetcher", "[event_fetcher]") {
       }
     }
   }
+
+  SECTION("Test batch size change") {
+    int time_units = 90 * 60;
+
+    auto context = game::Context::build_from(metadata);
+    auto fetcher = game::EventFetcher{
+        game_data_start_10_50, game::string_stream{}, time_units, 2, context};
+
+    // The 5 events before the first game interruption are split into a batch
+    // of the initial size, then a batch of the new size
+    REQUIRE(fetcher.parse_batch().data->size() == 2);
+    fetcher.set_batch_size(3);
+    REQUIRE(fetcher.get_batch_size() == 3);
+    REQUIRE(fetcher.parse_batch().data->size() == 3);
+  }
+
+  SECTION("Each match follows its own timeline") {
+    int time_units = 90 * 60;
+
+    auto context = game::Context::build_from(metadata);
+    auto fetcher = game::EventFetcher{
+        game_data_start_10_50, game::string_stream{}, time_units, 10, context};
+    auto first_ts = fetcher.parse_batch().data->front().get_timestamp();
+
+    // A match starting right after the first in-game event drops it
+    auto late_context = game::Context::build_from(metadata);
+    auto timeline = late_context.get_timeline();
+    timeline.game_start = first_ts + std::chrono::picoseconds{1};
+    late_context.set_timeline(timeline);
+    auto late_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, 10, late_context};
+    auto late_batch = late_fetcher.parse_batch();
+    REQUIRE(!late_batch.data->empty());
+    REQUIRE(late_batch.data->front().get_timestamp() > first_ts);
+  }
+}
+
+TEST_CASE("Periods are closed by timer when the stream stalls",
+          "[event_fetcher]") {
+  namespace fs = std::filesystem;
+  using namespace std::chrono_literals;
+
+  auto fifo = fs::temp_directory_path() /
+              fmt::format("soccer_monitoring_stall_{}", ::getpid());
+  REQUIRE(::mkfifo(fifo.c_str(), 0600) == 0);
+
+  // A ball event right before the end of the first 1 second period, then a
+  // stall, then an event of the next period
+  auto ball_event = [](std::chrono::picoseconds ts) {
+    return fmt::format("SE,4,{},0,0,0,0,0,0,0,0,0,0,0\n",
+                       (game::game_start + ts).count());
+  };
+  auto writer = std::thread{[&] {
+    auto os = std::ofstream{fifo};
+    os << ball_event(990ms) << std::flush;
+    std::this_thread::sleep_for(500ms);
+    os << ball_event(1500ms) << std::flush;
+  }};
+
+  auto context = game::Context::build_from(metadata);
+  auto fetcher =
+      game::EventFetcher{fifo.string(), game::file_stream{}, 1, 10, context};
+  fetcher.set_emission_delay(50ms);
+
+  auto start = std::chrono::steady_clock::now();
+  auto first = fetcher.parse_batch();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(first.is_period_last_batch);
+  REQUIRE(first.data->size() == 1);
+  REQUIRE(elapsed < 400ms);
+
+  // The next period is not over yet when the stream ends
+  auto second = fetcher.parse_batch();
+  REQUIRE(second.data->size() == 1);
+  REQUIRE(second.data->front().get_timestamp() == game::game_start + 1500ms);
+
+  writer.join();
+  fs::remove(fifo);
+}
+
+TEST_CASE("Batch size controller", "[event_fetcher]") {
+  using seconds = game::BatchSizeController::seconds;
+  auto const us = seconds{1e-6};
+
+  // Feeds the controller with batches of the size it asks for
+  auto run = [](auto &controller, int nb_batches, auto fetch, auto compute) {
+    for (int i = 0; i < nb_batches; ++i) {
+      auto n = static_cast<double>(controller.get_batch_size());
+      controller.observe(controller.get_batch_size(), fetch(n), compute(n));
+    }
+  };
+
+  SECTION("Throughput is maximized") {
+    // A fixed cost per batch favours the largest batches
+    auto controller = game::BatchSizeController{};
+    run(
+        controller, 400, [&](double n) { return n * us; },
+        [&](double n) { return 1000 * us + n * us; });
+    REQUIRE(controller.get_batch_size() >=
+            game::BatchSizeController::max_batch_size / 2);
+  }
+
+  SECTION("Target latency is met and followed on load changes") {
+    auto controller = game::BatchSizeController{seconds{4e-3}};
+
+    // Mean latency is n * 2us
+    run(
+        controller, 100, [&](double n) { return 2 * n * us; },
+        [&](double n) { return n * us; });
+    REQUIRE(controller.get_batch_size() == Approx(2000).epsilon(0.01));
+    REQUIRE(controller.get_latency().count() == Approx(4e-3).epsilon(0.01));
+
+    // Computation gets twice as slow
+    run(
+        controller, 100, [&](double n) { return 2 * n * us; },
+        [&](double n) { return 3 * n * us; });
+    REQUIRE(controller.get_batch_size() == Approx(1000).epsilon(0.01));
+  }
+}
+
+TEST_CASE("Event store replays the stream", "[event_fetcher]") {
+  using namespace std::chrono_literals;
+
+  SECTION("Events read back as appended") {
+    auto events = std::vector<game::EventStore::Event>{};
+    auto ts = game::game_start;
+    for (int i = 0; i < 10000; ++i) {
+      ts += std::chrono::picoseconds{(i % 7 == 3 ? -5 : 61) * 1000000};
+      if (i % 1000 == 500) {
+        events.emplace_back(game::InterruptionEvent{ts});
+      } else if (i % 1000 == 700) {
+        events.emplace_back(game::ResumeEvent{ts});
+      } else {
+        events.emplace_back(game::PositionEvent{
+            4 + i % 40, ts, 20000 - i * 3, -30000 + i % 900, i % 2 - 1});
+      }
+    }
+    auto store = game::EventStore{};
+    for (auto const &event : events) {
+      store.append(event);
+    }
+    REQUIRE(store.size() == events.size());
+    REQUIRE(store.get_memory_size() <
+            events.size() * sizeof(game::PositionEvent) / 2);
+
+    auto reader = store.read();
+    auto event = game::EventStore::Event{};
+    for (auto const &expected : events) {
+      REQUIRE(reader.next(event));
+      REQUIRE(event.index() == expected.index());
+      if (auto const *position = std::get_if<game::PositionEvent>(&event)) {
+        auto const &expected_position = std::get<game::PositionEvent>(expected);
+        REQUIRE(position->get_sid() == expected_position.get_sid());
+        REQUIRE(position->get_timestamp() ==
+                expected_position.get_timestamp());
+        REQUIRE(position->get_vector() == expected_position.get_vector());
+      }
+    }
+    REQUIRE_FALSE(reader.next(event));
+  }
+
+  SECTION("Replayed batches match parsed batches") {
+    // The game is paused over a part of the stream
+    auto dataset = std::string{};
+    auto is = std::istringstream{game_data_start_10_50};
+    auto line = std::string{};
+    for (int i = 0; std::getline(is, line); ++i) {
+      if (i == 20) {
+        dataset += "GI,2010,Game Interruption Begin,10:00:00.000,0,0\n";
+      } else if (i == 30) {
+        dataset += "GI,2011,Game Interruption End,10:00:00.000,0,0\n";
+      }
+      dataset += line + '\n';
+    }
+
+    auto context = game::Context::build_from(metadata);
+    auto fetcher =
+        game::EventFetcher{dataset, game::string_stream{}, 1, 7, context};
+    auto store = game::EventStore{};
+    fetcher.set_event_store(&store);
+    auto parsed = std::vector<std::vector<game::PositionEvent>>{};
+    for (auto const &batch : fetcher) {
+      parsed.push_back(*batch.data);
+    }
+
+    auto replay_context = game::Context::build_from(metadata);
+    auto replay_fetcher = game::EventFetcher{store, 1, 7, replay_context};
+    std::size_t nb_batches = 0;
+    for (auto const &batch : replay_fetcher) {
+      REQUIRE(nb_batches < parsed.size());
+      auto const &expected = parsed[nb_batches++];
+      REQUIRE(batch.data->size() == expected.size());
+      for (std::size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE((*batch.data)[i].get_sid() == expected[i].get_sid());
+        REQUIRE((*batch.data)[i].get_timestamp() ==
+                expected[i].get_timestamp());
+      }
+    }
+    REQUIRE(nb_batches == parsed.size());
+    REQUIRE(nb_batches > 2);
+  }
 }
 
 // TEST_CASE("Fetchers with different time units make the same batches") {
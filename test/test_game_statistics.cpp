@@ -1,22 +1,40 @@
 #include "catch.hpp"
 
+#include "checkpoint.hpp"
+#include "details/fenwick_tree.hpp"
 #include "details/game_statistics_impl.hpp"
+#include "details/work_stealing_pool.hpp"
+#include "distance.hpp"
 #include "event_fetcher.hpp"
 #include "game_statistics.hpp"
 #include "metadata.hpp"
+#include "possession_timeline.hpp"
+#include "streaming_possession.hpp"
 #include "test_dataset.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <iomanip>
 #include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "fmt/format.h"
 
 game::details::DistanceResults
-build_distance_results(std::string const &name,
+build_distance_results(std::size_t player, std::vector<double> &storage,
                        std::vector<double> &&distances) {
-  auto results = game::details::DistanceResults{name};
+  storage.resize(distances.size());
+  auto results = game::details::DistanceResults{player, storage.data()};
   for (auto d : distances) {
     results.push_back(d);
   }
@@ -25,8 +43,9 @@ build_distance_results(std::string const &name,
 }
 
 void print_possession(game::details::BallPossession &possession) {
-  for (const auto &[distance, name] : possession) {
-    fmt::print("{} is the closest player (distance: {})\n", name, distance);
+  for (const auto &[distance, player] : possession) {
+    fmt::print("Player {} is the closest player (distance: {})\n", player,
+               distance);
   }
 }
 
@@ -50,16 +69,126 @@ void print_partial_stats(game::GameStatistics const &stats,
 }
 
 TEST_CASE("Test ball possession iterator") {
+  auto storage_1 = std::vector<double>{};
+  auto storage_2 = std::vector<double>{};
   auto distance_1 = build_distance_results(
-      "Player 1", {1, 1, 2, 3, game::GameStatistics::infinite_distance});
+      1, storage_1, {1, 1, 2, 3, game::GameStatistics::infinite_distance});
   auto distance_2 = build_distance_results(
-      "Player 2", {3, 2, 1, 1, game::GameStatistics::infinite_distance});
+      2, storage_2, {3, 2, 1, 1, game::GameStatistics::infinite_distance});
 
-  auto possession = game::details::BallPossession{};
+  auto arena = game::details::ScratchArena{};
+  auto possession = game::details::BallPossession{arena, 5};
   possession.reduce(distance_1);
   print_possession(possession);
   possession.reduce(distance_2);
   print_possession(possession);
+
+  auto expected = std::vector<std::size_t>{
+      1, 1, 2, 2, game::details::BallPossession::none_player};
+  auto closest = std::vector<std::size_t>{};
+  for (const auto &[distance, player] : possession) {
+    closest.push_back(player);
+  }
+  REQUIRE(closest == expected);
+}
+
+TEST_CASE("Scratch arena reuses its memory after reset") {
+  auto arena = game::details::ScratchArena{};
+
+  // First round: requests overflow the initial block several times
+  for (std::size_t n = 1; n <= 1000; n *= 10) {
+    arena.allocate<double>(n);
+    arena.allocate<std::size_t>(n);
+  }
+  arena.reset();
+  auto warm_up_allocations = arena.nb_allocations();
+  REQUIRE(warm_up_allocations > 0);
+
+  // Same requests are now served by the coalesced block
+  for (int round = 0; round < 3; ++round) {
+    for (std::size_t n = 1; n <= 1000; n *= 10) {
+      auto *d = arena.allocate<double>(n);
+      auto *s = arena.allocate<std::size_t>(n);
+      d[n - 1] = 1.0;
+      s[n - 1] = 1;
+    }
+    arena.reset();
+  }
+  REQUIRE(arena.nb_allocations() == warm_up_allocations);
+}
+
+TEST_CASE("Work-stealing pool runs every task once") {
+  auto pool = game::details::WorkStealingPool{4};
+  std::size_t nb_chains = 5;
+  std::size_t chain_length = 40;
+  auto runs = std::vector<std::atomic<int>>(nb_chains * chain_length);
+
+  // Each task pushes the next one of its chain
+  auto initial = std::vector<std::size_t>{0, 1, 2, 3, 4};
+  for (int round = 0; round < 3; ++round) {
+    pool.run(initial, runs.size(), [&](std::size_t task, std::size_t worker) {
+      ++runs[task];
+      if (task + nb_chains < runs.size()) {
+        pool.push(worker, task + nb_chains);
+      }
+    });
+  }
+
+  for (auto const &count : runs) {
+    REQUIRE(count == 3);
+  }
+}
+
+TEST_CASE("Work-stealing pool runs concurrent jobs") {
+  auto pool = game::details::WorkStealingPool{3};
+  std::size_t nb_chains = 4;
+  std::size_t chain_length = 50;
+  auto runs = std::vector<std::vector<std::atomic<int>>>(2);
+  for (auto &job_runs : runs) {
+    job_runs = std::vector<std::atomic<int>>(nb_chains * chain_length);
+  }
+
+  // Each thread runs its own job, whose tasks push the next one of their chain
+  auto run = [&](std::size_t job) {
+    auto initial = std::vector<std::size_t>{0, 1, 2, 3};
+    auto &job_runs = runs[job];
+    pool.run(initial, job_runs.size(), [&](std::size_t task, std::size_t w) {
+      ++job_runs[task];
+      if (task + nb_chains < job_runs.size()) {
+        pool.push(w, task + nb_chains);
+      }
+    });
+  };
+  auto other = std::thread{run, 1};
+  run(0);
+  other.join();
+
+  for (auto const &job_runs : runs) {
+    for (auto const &count : job_runs) {
+      REQUIRE(count == 1);
+    }
+  }
+}
+
+TEST_CASE("Fenwick tree sums ranges of counts") {
+  std::size_t size = 37;
+  auto tree = game::details::FenwickTree{size};
+  auto counts = std::vector<std::int64_t>(size, 0);
+  for (std::size_t i = 0; i < 200; ++i) {
+    auto index = (i * 7 + i / 5) % size;
+    auto value = static_cast<std::int64_t>(i % 11) - 3;
+    tree.add(index, value);
+    counts[index] += value;
+  }
+
+  REQUIRE(tree.size() == size);
+  for (std::size_t first = 0; first <= size; ++first) {
+    for (std::size_t last = first; last <= size; ++last) {
+      auto expected = std::accumulate(counts.cbegin() + first,
+                                      counts.cbegin() + last, std::int64_t{0});
+      REQUIRE(tree.range_sum(first, last) == expected);
+    }
+  }
 }
 
 TEST_CASE("Test accumulate_stats computation") {
@@ -81,4 +210,658 @@ TEST_CASE("Test accumulate_stats computation") {
       fmt::print("\n");
     }
   }
-}
\ No newline at end of file
+
+  SECTION("Tiled processing matches whole-batch processing") {
+    std::size_t batch_size = 10;
+    int time_units = 90 * 60;
+    auto tiled_context = game::Context::build_from(metadata);
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, context};
+    auto tiled_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, tiled_context};
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+    auto tiled_stats = game::GameStatistics{
+        game::GameStatistics::infinite_distance, tiled_context};
+    tiled_stats.set_tile_size(3);
+
+    auto it = fetcher.begin();
+    auto tiled_it = tiled_fetcher.begin();
+    for (; it != fetcher.end(); ++it, ++tiled_it) {
+      stats.accumulate_stats(*it);
+      tiled_stats.accumulate_stats(*tiled_it);
+      REQUIRE(stats.accumulated_stats() == tiled_stats.accumulated_stats());
+    }
+    REQUIRE(tiled_it == tiled_fetcher.end());
+  }
+
+  SECTION("Many K in one pass match one pass per K") {
+    std::size_t batch_size = 10;
+    int time_units = 90 * 60;
+    auto ks = std::vector<double>{2.0, game::GameStatistics::infinite_distance};
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, context};
+    auto stats = game::GameStatistics{ks, {time_units}, context};
+    REQUIRE(stats.base_time_units() == time_units);
+
+    auto single_contexts = std::vector<game::Context>{};
+    auto single_fetchers = std::vector<game::EventFetcher>{};
+    auto single_stats = std::vector<game::GameStatistics>{};
+    single_contexts.reserve(ks.size());
+    single_fetchers.reserve(ks.size());
+    single_stats.reserve(ks.size());
+    for (auto k : ks) {
+      auto &c =
+          single_contexts.emplace_back(game::Context::build_from(metadata));
+      single_fetchers.emplace_back(game_data_start_10_50, game::string_stream{},
+                                   time_units, batch_size, c);
+      single_stats.emplace_back(k, c);
+    }
+
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+      for (std::size_t k = 0; k < ks.size(); ++k) {
+        single_stats[k].accumulate_stats(single_fetchers[k].parse_batch());
+        REQUIRE(stats.accumulated_stats(k) ==
+                single_stats[k].accumulated_stats());
+      }
+    }
+    for (std::size_t k = 0; k < ks.size(); ++k) {
+      REQUIRE(stats.game_stats(k) == single_stats[k].game_stats());
+    }
+  }
+
+  SECTION("Periods of several T are closed independently") {
+    auto stats = game::GameStatistics{{1.0}, {6, 4}, context};
+    REQUIRE(stats.get_time_units() == std::vector<int>{4, 6});
+    REQUIRE(stats.base_time_units() == 2);
+
+    auto no_events = std::vector<game::PositionEvent>{};
+    auto snapshot = context.take_snapshot();
+    auto period_end = game::Batch{no_events, true, snapshot, game::game_start,
+                                  game::game_start};
+    auto closed = std::vector<std::pair<bool, bool>>{};
+    for (int i = 0; i < 6; ++i) {
+      stats.accumulate_stats(period_end);
+      closed.emplace_back(stats.is_period_over(0), stats.is_period_over(1));
+    }
+    REQUIRE(closed == std::vector<std::pair<bool, bool>>{{false, false},
+                                                         {true, false},
+                                                         {false, true},
+                                                         {true, false},
+                                                         {false, false},
+                                                         {true, true}});
+  }
+
+  SECTION("Possessions computed apart accumulate to the same statistics") {
+    std::size_t batch_size = 10;
+    int time_units = 90 * 60;
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, context};
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+    auto worker_stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+    auto merged_stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+
+      auto segment = batch;
+      segment.is_period_last_batch = false;
+      worker_stats.accumulate_stats(segment);
+      merged_stats.accumulate_possessions(worker_stats.take_possessions(),
+                                          batch);
+      REQUIRE(stats.accumulated_stats() == merged_stats.accumulated_stats());
+    }
+    REQUIRE(stats.game_stats() == merged_stats.game_stats());
+  }
+
+  SECTION("Work-stealing scheduler matches OpenMP") {
+    std::size_t batch_size = 10;
+    int time_units = 90 * 60;
+    auto stealing_context = game::Context::build_from(metadata);
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, context};
+    auto stealing_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, stealing_context};
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+    auto stealing_stats = game::GameStatistics{
+        game::GameStatistics::infinite_distance, stealing_context};
+    auto pool = game::details::WorkStealingPool{3};
+    stealing_stats.set_worker_pool(&pool);
+    // More tiles per batch than in flight, so that scans wait for a slot
+    stealing_stats.set_tile_size(2);
+
+    auto it = fetcher.begin();
+    auto stealing_it = stealing_fetcher.begin();
+    for (; it != fetcher.end(); ++it, ++stealing_it) {
+      stats.accumulate_stats(*it);
+      stealing_stats.accumulate_stats(*stealing_it);
+      REQUIRE(stats.accumulated_stats() == stealing_stats.accumulated_stats());
+    }
+    REQUIRE(stats.game_stats() == stealing_stats.game_stats());
+  }
+
+  SECTION("Sampled ball events stand for the event time skipped") {
+    std::size_t batch_size = 10;
+    int time_units = 1;
+    auto sampled_context = game::Context::build_from(metadata);
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, context};
+    auto sampled_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, sampled_context};
+    auto calibrated_context = game::Context::build_from(metadata);
+    auto calibrated_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, calibrated_context};
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+    auto sampled_stats = game::GameStatistics{
+        game::GameStatistics::infinite_distance, sampled_context};
+    sampled_stats.set_tile_size(4);
+    sampled_stats.set_sampling({3, {}, 0});
+    auto calibrated_stats = game::GameStatistics{
+        game::GameStatistics::infinite_distance, calibrated_context};
+    calibrated_stats.set_tile_size(4);
+    calibrated_stats.set_sampling({3, {}, 1000});
+
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+    }
+    auto nb_periods = std::size_t{0};
+    for (auto const &batch : sampled_fetcher) {
+      sampled_stats.accumulate_stats(batch);
+      nb_periods += batch.is_period_last_batch ? 1 : 0;
+      if (batch.is_period_last_batch) {
+        REQUIRE(sampled_stats.is_approximate());
+      }
+    }
+    for (auto const &batch : calibrated_fetcher) {
+      calibrated_stats.accumulate_stats(batch);
+      REQUIRE(!calibrated_stats.is_approximate());
+    }
+
+    auto const &report = calibrated_stats.get_sampling_report();
+    REQUIRE(report.nb_ball_events > 0);
+    REQUIRE(report.nb_samples == report.nb_ball_events / 3);
+    REQUIRE(report.calibration_periods == nb_periods);
+    REQUIRE(report.approximate_periods == 0);
+    REQUIRE(sampled_stats.get_sampling_report().approximate_periods ==
+            nb_periods);
+
+    // Calibration periods count the exact possessions
+    auto exact = stats.game_stats();
+    REQUIRE(calibrated_stats.game_stats() == exact);
+
+    // The error reported is that of the samples against the exact possessions
+    // over the whole game, calibrated throughout
+    auto approximate = sampled_stats.game_stats();
+    auto max_error = 0.0;
+    for (auto const &[name, share] : exact) {
+      auto it = approximate.find(name);
+      auto approximate_share = it == approximate.end() ? 0.0 : it->second;
+      max_error = std::max(max_error, std::abs(approximate_share - share));
+    }
+    REQUIRE(report.max_error == Approx(max_error * 100));
+  }
+
+  SECTION("Resuming from a checkpoint matches an uninterrupted run") {
+    std::size_t batch_size = 10;
+    int time_units = 1;
+    auto path = std::filesystem::temp_directory_path() /
+                "test_game_statistics.checkpoint";
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, context};
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+    }
+
+    // Stop after two batches, as a crash would, before the game is over
+    auto stopped_context = game::Context::build_from(metadata);
+    auto stopped_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, stopped_context};
+    auto stopped_stats = game::GameStatistics{
+        game::GameStatistics::infinite_distance, stopped_context};
+    for (int i = 0; i < 2; ++i) {
+      stopped_stats.accumulate_stats(stopped_fetcher.parse_batch());
+    }
+    REQUIRE(!stopped_fetcher.is_game_over());
+    game::save_checkpoint(path, stopped_context, stopped_fetcher,
+                          stopped_stats);
+
+    auto resumed_context = game::Context::build_from(metadata);
+    auto resumed_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, resumed_context};
+    auto resumed_stats = game::GameStatistics{
+        game::GameStatistics::infinite_distance, resumed_context};
+    game::restore_checkpoint(path, resumed_context, resumed_fetcher,
+                             resumed_stats);
+    std::filesystem::remove(path);
+    auto nb_resumed_batches = 0;
+    for (auto const &batch : resumed_fetcher) {
+      resumed_stats.accumulate_stats(batch);
+      ++nb_resumed_batches;
+    }
+    REQUIRE(nb_resumed_batches > 1);
+
+    REQUIRE(stats.game_stats() == resumed_stats.game_stats());
+  }
+
+  SECTION("Streaming one event at a time matches batches") {
+    int time_units = 1;
+    auto streaming_context = game::Context::build_from(metadata);
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, 100000, context};
+    auto streaming_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, 100000, streaming_context};
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+    auto streaming_stats = game::GameStatistics{
+        game::GameStatistics::infinite_distance, streaming_context};
+
+    auto streaming =
+        game::StreamingPossession{streaming_stats, streaming_context};
+    auto last_change = game::StreamingPossession::none_player;
+    streaming.set_possession_callback(
+        [&](std::size_t player, std::chrono::picoseconds) {
+          last_change = player;
+        });
+
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+    }
+    while (auto stream_event = streaming_fetcher.parse_stream_event()) {
+      streaming.process(*stream_event);
+    }
+    streaming.finish();
+
+    REQUIRE(stats.game_stats() == streaming_stats.game_stats());
+    REQUIRE(stats.last_partial() == streaming_stats.last_partial());
+    REQUIRE(last_change == streaming.get_possessor());
+  }
+
+  SECTION("Possession timeline coalesces ball events won in a row") {
+    int time_units = 1;
+    auto streaming_context = game::Context::build_from(metadata);
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, 10, context};
+    auto streaming_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, 10, streaming_context};
+    auto stats = game::GameStatistics{2.0, context};
+    stats.set_tile_size(3);
+    auto streaming_stats = game::GameStatistics{2.0, streaming_context};
+    auto streaming =
+        game::StreamingPossession{streaming_stats, streaming_context};
+
+    auto os = std::ostringstream{};
+    auto timeline = game::PossessionTimeline{os, stats.get_player_names()};
+    stats.set_timeline(&timeline);
+    auto streaming_os = std::ostringstream{};
+    auto streaming_timeline =
+        game::PossessionTimeline{streaming_os, stats.get_player_names()};
+    streaming_stats.set_timeline(&streaming_timeline);
+
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+    }
+    std::size_t nb_ball_events = 0;
+    while (auto stream_event = streaming_fetcher.parse_stream_event()) {
+      streaming.process(*stream_event);
+      auto sid = stream_event->event.get_sid();
+      nb_ball_events += stream_event->is_in_play &&
+                        streaming_context.get_balls().is_ball(sid);
+    }
+    streaming.finish();
+
+    REQUIRE(os.str() == streaming_os.str());
+    REQUIRE(timeline.get_nb_segments() > 1);
+    REQUIRE(timeline.get_nb_segments() < nb_ball_events);
+
+    // Segments follow one another, each one won by another player
+    auto is = std::istringstream{os.str()};
+    auto line = std::string{};
+    std::getline(is, line);
+    REQUIRE(line == "player,start,end");
+    auto previous_player = std::string{};
+    auto previous_end = 0LL;
+    for (std::size_t i = 0; i < timeline.get_nb_segments(); ++i) {
+      auto player = std::string{};
+      auto start = 0LL;
+      auto end = 0LL;
+      REQUIRE(std::getline(is, player, ','));
+      is >> start;
+      is.ignore();
+      is >> end;
+      is.ignore();
+      REQUIRE(player != previous_player);
+      REQUIRE(previous_end < start);
+      REQUIRE(start <= end);
+      previous_player = player;
+      previous_end = end;
+    }
+  }
+
+  SECTION("Foot-level evaluation gives possession to the closest sensor") {
+    auto fetcher = game::EventFetcher{game_data_start_10_50,
+                                      game::string_stream{}, 1, 1, context};
+    auto stats = game::GameStatistics{{3.0}, {1}, context};
+    auto streaming = game::StreamingPossession{stats, context};
+    streaming.set_foot_level(true);
+
+    // Brute force over every sensor, kept apart from the streaming engine
+    auto ball = std::get<game::BallPosition>(context.get_ball_position());
+    auto ball_sids = ball.get_sids();
+    auto player_names = context.get_player_names();
+    auto sensors = std::map<int, std::tuple<double, double, double>>{};
+    auto owners = std::map<int, std::size_t>{};
+    for (std::size_t i = 0; i < player_names.size(); ++i) {
+      for (auto sid : context.get_player_sids(player_names[i])) {
+        auto player = std::get<game::PlayerPosition>(context.get_position(sid));
+        auto [x, y, z] = player.get_sensor(sid);
+        sensors[sid] = {x, y, z};
+        owners[sid] = i;
+      }
+    }
+
+    std::size_t nb_checked = 0;
+    while (auto stream_event = fetcher.parse_stream_event()) {
+      streaming.process(*stream_event);
+      if (!stream_event->is_position_update) {
+        continue;
+      }
+      auto const &event = stream_event->event;
+      auto sid = event.get_sid();
+      auto coordinates =
+          std::make_tuple(event.get_x(), event.get_y(), event.get_z());
+      if (auto it = sensors.find(sid); it != sensors.end()) {
+        auto [x, y, z] = coordinates;
+        it->second = {x, y, z};
+        continue;
+      }
+      if (std::find(ball_sids.cbegin(), ball_sids.cend(), sid) ==
+          ball_sids.cend()) {
+        continue;
+      }
+      ball.update_sensor(sid, coordinates);
+      if (!stream_event->is_in_play) {
+        continue;
+      }
+
+      auto expected = game::StreamingPossession::none_player;
+      auto min_distance = game::GameStatistics::infinite_distance;
+      for (auto const &[sensor, position] : sensors) {
+        auto distance = game::distance::euclidean(ball.vector(), position);
+        if (distance < min_distance ||
+            (distance == min_distance && owners[sensor] < expected)) {
+          min_distance = distance;
+          expected = owners[sensor];
+        }
+      }
+      if (!(min_distance / 1000 <= 3.0)) {
+        expected = game::StreamingPossession::none_player;
+      }
+      REQUIRE(streaming.get_possessor() == expected);
+      ++nb_checked;
+    }
+    REQUIRE(nb_checked > 0);
+  }
+
+  SECTION("Foot-level evaluation is no slower than centroid evaluation") {
+    using namespace std::chrono_literals;
+
+    // Two seconds at the sensor rates of the stream: 2000 Hz for the ball and
+    // 200 Hz for each player sensor, at random field positions
+    auto ball_sids =
+        std::get<game::BallPosition>(context.get_ball_position()).get_sids();
+    auto player_sids = std::vector<int>{};
+    for (auto const &name : context.get_player_names()) {
+      auto const &sids = context.get_player_sids(name);
+      player_sids.insert(player_sids.end(), sids.cbegin(), sids.cend());
+    }
+    auto random = std::mt19937{42};
+    auto x = std::uniform_int_distribution{0, 52477};
+    auto y = std::uniform_int_distribution{-33960, 33965};
+    auto dataset = std::string{};
+    for (int ms = 0; ms < 2000; ++ms) {
+      auto ts = (game::game_start + ms * 1ms).count();
+      for (auto sid : {ball_sids[0], ball_sids[0]}) {
+        dataset += fmt::format("SE,{},{},{},{},0,0,0,0,0,0,0,0,0\n", sid, ts,
+                               x(random), y(random));
+      }
+      for (std::size_t i = ms % 5; i < player_sids.size(); i += 5) {
+        dataset += fmt::format("SE,{},{},{},{},0,0,0,0,0,0,0,0,0\n",
+                               player_sids[i], ts, x(random), y(random));
+      }
+    }
+    auto fetcher =
+        game::EventFetcher{dataset, game::string_stream{}, 1, 1, context};
+    auto stream_events = std::vector<game::StreamEvent>{};
+    while (auto stream_event = fetcher.parse_stream_event()) {
+      stream_events.push_back(*stream_event);
+    }
+
+    // The fastest of several replays of each mode, interleaved so that both
+    // see the same load
+    auto best = std::array<std::chrono::steady_clock::duration, 2>{
+        std::chrono::hours{1}, std::chrono::hours{1}};
+    for (int replay = 0; replay < 10; ++replay) {
+      for (auto is_foot_level : {false, true}) {
+        auto stats = game::GameStatistics{{3.0}, {1}, context};
+        auto streaming = game::StreamingPossession{stats, context};
+        streaming.set_foot_level(is_foot_level);
+        auto start = std::chrono::steady_clock::now();
+        for (auto const &stream_event : stream_events) {
+          streaming.process(stream_event);
+        }
+        streaming.finish();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        best[is_foot_level] = std::min(best[is_foot_level], elapsed);
+      }
+    }
+    REQUIRE(best[true] <= best[false]);
+  }
+
+  SECTION("Incremental evaluation matches full evaluation") {
+    auto incremental_context = game::Context::build_from(metadata);
+    auto fetcher = game::EventFetcher{game_data_start_10_50,
+                                      game::string_stream{}, 1, 1, context};
+    auto incremental_fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{}, 1, 1,
+                           incremental_context};
+    auto stats = game::GameStatistics{{1.0, 3.0}, {1}, context};
+    auto incremental_stats =
+        game::GameStatistics{{1.0, 3.0}, {1}, incremental_context};
+
+    auto streaming = game::StreamingPossession{stats, context};
+    auto incremental =
+        game::StreamingPossession{incremental_stats, incremental_context};
+    incremental.set_incremental(true);
+
+    while (auto stream_event = fetcher.parse_stream_event()) {
+      streaming.process(*stream_event);
+      incremental.process(*incremental_fetcher.parse_stream_event());
+      REQUIRE(streaming.get_possessor() == incremental.get_possessor());
+    }
+    streaming.finish();
+    incremental.finish();
+
+    for (std::size_t k = 0; k < 2; ++k) {
+      REQUIRE(stats.game_stats(k) == incremental_stats.game_stats(k));
+    }
+    REQUIRE(incremental.get_nb_evaluated() + incremental.get_nb_skipped() ==
+            streaming.get_nb_evaluated());
+  }
+
+  SECTION("Spatial index matches brute force") {
+    for (auto is_incremental : {false, true}) {
+      auto brute_context = game::Context::build_from(metadata);
+      auto indexed_context = game::Context::build_from(metadata);
+      auto fetcher = game::EventFetcher{game_data_start_10_50,
+                                        game::string_stream{}, 1, 1,
+                                        brute_context};
+      auto indexed_fetcher = game::EventFetcher{
+          game_data_start_10_50, game::string_stream{}, 1, 1, indexed_context};
+      auto stats = game::GameStatistics{{1.0, 3.0}, {1}, brute_context};
+      auto indexed_stats =
+          game::GameStatistics{{1.0, 3.0}, {1}, indexed_context};
+
+      auto streaming = game::StreamingPossession{stats, brute_context};
+      auto indexed = game::StreamingPossession{indexed_stats, indexed_context};
+      indexed.set_spatial_index(true);
+      indexed.set_incremental(is_incremental);
+
+      while (auto stream_event = fetcher.parse_stream_event()) {
+        streaming.process(*stream_event);
+        indexed.process(*indexed_fetcher.parse_stream_event());
+        REQUIRE(streaming.get_possessor() == indexed.get_possessor());
+      }
+      streaming.finish();
+      indexed.finish();
+
+      for (std::size_t k = 0; k < 2; ++k) {
+        REQUIRE(stats.game_stats(k) == indexed_stats.game_stats(k));
+      }
+    }
+  }
+
+  SECTION("Steady state performs no scratch allocations") {
+    std::size_t batch_size = 10;
+    int time_units = 90 * 60;
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+
+    auto warm_up = game::EventFetcher{game_data_start_10_50,
+                                      game::string_stream{}, time_units,
+                                      batch_size, context};
+    for (auto const &batch : warm_up) {
+      stats.accumulate_stats(batch);
+    }
+    auto warm_up_allocations = stats.scratch_allocations();
+
+    auto fetcher =
+        game::EventFetcher{game_data_start_10_50, game::string_stream{},
+                           time_units, batch_size, context};
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+    }
+    REQUIRE(stats.scratch_allocations() == warm_up_allocations);
+  }
+}
+
+/**
+ * Over 3 seconds from game start, the ball is at Nick Gertje in the first and
+ * the last ones and at Leon Krapf in the second one, 3 ball events a second.
+ */
+std::string alternating_possession_dataset() {
+  using namespace std::chrono_literals;
+
+  auto event = [](int sid, std::chrono::picoseconds ts, int x) {
+    return fmt::format("SE,{},{},{},0,0,0,0,0,0,0,0,0,0\n", sid,
+                       (game::game_start + ts).count(), x);
+  };
+  auto dataset = std::string{};
+  for (int second = 0; second < 3; ++second) {
+    auto ts = std::chrono::picoseconds{second * 1s + 100ms};
+    for (auto sid : {13, 14, 97, 98}) {
+      dataset += event(sid, ts, 10000);
+    }
+    for (auto sid : {61, 62, 99, 100}) {
+      dataset += event(sid, ts, 40000);
+    }
+    for (int i = 1; i <= 3; ++i) {
+      dataset += event(4, ts + i * 100ms, second == 1 ? 40000 : 10000);
+    }
+  }
+  return dataset;
+}
+
+TEST_CASE("Possession between two instants") {
+  using namespace std::chrono_literals;
+
+  auto context = game::Context::build_from(metadata);
+  auto fetcher = game::EventFetcher{alternating_possession_dataset(),
+                                    game::string_stream{}, 1, 4, context};
+  auto stats =
+      game::GameStatistics{game::GameStatistics::infinite_distance, context};
+  REQUIRE_THROWS_AS(stats.possession_between(game::game_start,
+                                             game::game_start + 1s),
+                    std::logic_error);
+  stats.set_range_index(100ms);
+  for (auto const &batch : fetcher) {
+    stats.accumulate_stats(batch);
+  }
+
+  auto between = [&stats](std::chrono::picoseconds from,
+                          std::chrono::picoseconds to) {
+    return stats.possession_between(game::game_start + from,
+                                    game::game_start + to);
+  };
+  REQUIRE(between(0s, 3s) == stats.game_stats());
+  REQUIRE(between(0s, 2s) == std::unordered_map<std::string, double>{
+                                 {"Nick Gertje", 0.5}, {"Leon Krapf", 0.5}});
+  REQUIRE(between(1s, 2s) ==
+          std::unordered_map<std::string, double>{{"Leon Krapf", 1.0}});
+  REQUIRE(between(2300ms, 3s) ==
+          std::unordered_map<std::string, double>{{"Nick Gertje", 1.0}});
+  REQUIRE(between(1s, 1200ms).empty());
+}
+
+TEST_CASE("Sliding windows follow the last seconds") {
+  using Shares = std::unordered_map<std::string, double>;
+
+  auto context = game::Context::build_from(metadata);
+  auto stats = game::GameStatistics{
+      {game::GameStatistics::infinite_distance}, {60}, context};
+  REQUIRE_THROWS_AS(stats.set_sliding_windows({3}, 2), std::invalid_argument);
+  stats.set_sliding_windows({2, 1});
+  REQUIRE(stats.base_time_units() == 1);
+  REQUIRE(stats.get_window_lengths() == std::vector<int>{1, 2});
+
+  auto fetcher = game::EventFetcher{alternating_possession_dataset(),
+                                    game::string_stream{},
+                                    stats.base_time_units(), 100, context};
+  auto expected = std::vector<std::pair<Shares, Shares>>{
+      {{{"Nick Gertje", 1.0}}, {{"Nick Gertje", 1.0}}},
+      {{{"Leon Krapf", 1.0}}, {{"Nick Gertje", 0.5}, {"Leon Krapf", 0.5}}},
+      {{{"Nick Gertje", 1.0}}, {{"Nick Gertje", 0.5}, {"Leon Krapf", 0.5}}}};
+  std::size_t nb_slides = 0;
+  for (auto const &batch : fetcher) {
+    stats.accumulate_stats(batch);
+    if (stats.is_window_over()) {
+      REQUIRE(nb_slides < expected.size());
+      REQUIRE(stats.window_stats(0) == expected[nb_slides].first);
+      REQUIRE(stats.window_stats(1) == expected[nb_slides].second);
+      ++nb_slides;
+    }
+  }
+  REQUIRE(nb_slides == expected.size());
+  REQUIRE(stats.get_nb_partials() == 1);
+}
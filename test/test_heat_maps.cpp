@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include "batch_operator.hpp"
+#include "context.hpp"
+#include "event.hpp"
+#include "event_fetcher.hpp"
+#include "heat_maps.hpp"
+#include "test_dataset.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "fmt/format.h"
+
+namespace {
+/**
+ * Over 2 seconds from game start, a sensor of Nick Gertje sends an event every
+ * 10 ms, from a corner of the field over the first second and from the
+ * opposite one over the second second.
+ */
+std::string crossing_dataset() {
+  using namespace std::chrono_literals;
+
+  auto dataset = std::string{};
+  for (int i = 0; i < 200; ++i) {
+    auto ts = game::game_start + i * 10ms;
+    dataset += fmt::format("SE,13,{},{},{},0,0,0,0,0,0,0,0,0\n", ts.count(),
+                           i < 100 ? 1000 : 50000, i < 100 ? -30000 : 30000);
+  }
+  return dataset;
+}
+} // namespace
+
+TEST_CASE("Heat maps of the players") {
+  using namespace std::chrono_literals;
+
+  auto context = game::Context::build_from(metadata);
+  auto os = std::ostringstream{};
+
+  SECTION("Positions fall into the cells of the grid") {
+    auto heat_maps = game::HeatMaps{{8, 13}, {1}, 1, context, os};
+    REQUIRE(heat_maps.cell(game::field_lower_x, game::field_lower_y) == 0);
+    REQUIRE(heat_maps.cell(game::field_upper_x, game::field_upper_y) ==
+            8 * 13 - 1);
+    REQUIRE(heat_maps.cell(game::field_upper_x + 1000, 0) == 7 * 13 + 6);
+    REQUIRE(heat_maps.cell(-1000, game::field_lower_y - 1000) == 0);
+    REQUIRE(heat_maps.cell(40000, game::field_lower_y) == 6 * 13);
+    REQUIRE(os.str() == "T,period,player,x,y,seconds\n");
+
+    REQUIRE_THROWS_AS((game::HeatMaps{{0, 13}, {1}, 1, context, os}),
+                      std::invalid_argument);
+  }
+
+  SECTION("Time in each cell is accumulated over the periods of each T") {
+    auto fetcher = game::EventFetcher{crossing_dataset(),
+                                      game::string_stream{}, 1, 16, context};
+    auto heat_maps = game::HeatMaps{{8, 13}, {1, 2}, 1, context, os};
+    auto pipeline = game::OperatorPipeline{};
+    pipeline.add(heat_maps);
+
+    auto const &names = heat_maps.get_player_names();
+    auto nick = static_cast<std::size_t>(
+        std::find(names.cbegin(), names.cend(), "Nick Gertje") -
+        names.cbegin());
+    auto first = nick * 8 * 13;
+    auto last = first + 8 * 13 - 1;
+
+    std::size_t nb_periods = 0;
+    for (auto const &batch : fetcher) {
+      pipeline.on_batch(batch);
+      if (!batch.is_period_last_batch) {
+        continue;
+      }
+      auto const *period = heat_maps.last_period(0);
+      if (nb_periods == 0) {
+        REQUIRE(std::chrono::picoseconds{period[first]} == 990ms);
+        REQUIRE(period[last] == 0);
+      } else {
+        // The interval to the event opening the period counts in it
+        REQUIRE(std::chrono::picoseconds{period[first]} == 10ms);
+        REQUIRE(std::chrono::picoseconds{period[last]} == 990ms);
+      }
+      ++nb_periods;
+    }
+    pipeline.on_game_end();
+    REQUIRE(nb_periods == 2);
+
+    auto const *game = heat_maps.game_heat_maps();
+    REQUIRE(std::chrono::picoseconds{game[first]} == 1s);
+    REQUIRE(std::chrono::picoseconds{game[last]} == 990ms);
+    REQUIRE(std::count_if(game, game + names.size() * 8 * 13,
+                          [](auto time) { return time != 0; }) == 2);
+    REQUIRE(std::equal(game, game + names.size() * 8 * 13,
+                       heat_maps.last_period(1)));
+
+    auto output = os.str();
+    REQUIRE(output.find("1,1,Nick Gertje,0,0,0.990\n") != std::string::npos);
+    REQUIRE(output.find("1,2,Nick Gertje,7,12,0.990\n") != std::string::npos);
+    REQUIRE(output.find("2,1,Nick Gertje,0,0,1.000\n") != std::string::npos);
+    REQUIRE(output.find("0,0,Nick Gertje,0,0,1.000\n") != std::string::npos);
+  }
+}
@@ -3,6 +3,10 @@
 #include "test_dataset.hpp"
 
 #include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
 
 TEST_CASE("PlayerMap correctly stores metadata", "[metadata]") {
   using namespace std::literals;
@@ -151,4 +155,58 @@ TEST_CASE("Parse metadata") {
 
   REQUIRE(players[75] == langhans);
   REQUIRE(players[44] == langhans);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Parse the match timeline", "[metadata]") {
+  auto meta = game::parse_metadata_string(metadata);
+  REQUIRE(meta.timeline.game_start == game::game_start);
+  REQUIRE(meta.timeline.game_end == game::game_end);
+
+  auto timeline = std::string{"TIMELINE,100,200,210,300,400,105\n"};
+  auto timed = game::parse_metadata_string(metadata + timeline);
+  REQUIRE(timed.timeline.game_start.count() == 100);
+  REQUIRE(timed.timeline.break_start.count() == 200);
+  REQUIRE(timed.timeline.official_break_start.count() == 210);
+  REQUIRE(timed.timeline.break_end.count() == 300);
+  REQUIRE(timed.timeline.game_end.count() == 400);
+  REQUIRE(timed.timeline.half_duration.count() == 105);
+}
+
+TEST_CASE("PlayerPosition tracks the centroid of its sensors", "[metadata]") {
+  auto position = game::PlayerPosition{};
+  for (auto sid : {13, 14, 97, 98}) {
+    position.add_sensor(sid);
+  }
+  REQUIRE_THROWS_AS(position.add_sensor(1), std::length_error);
+  auto sids = position.get_sids();
+  REQUIRE(std::vector<int>(sids.begin(), sids.end()) ==
+          std::vector<int>{13, 14, 97, 98});
+
+  position.update_sensor(13, {100, 200, 0});
+  position.update_sensor(14, {300, -200, 40});
+  position.update_sensor(97, {-100, 400, 80});
+  position.update_sensor(98, {100, 0, 0});
+  REQUIRE(position.vector() == std::make_tuple(100.0, 100.0, 30.0));
+
+  // Moving a sensor replaces its old coordinates in the centroid
+  position.update_sensor(13, {500, 600, 0});
+  REQUIRE(position.vector() == std::make_tuple(200.0, 200.0, 30.0));
+
+  REQUIRE(std::is_trivially_copyable_v<game::Positions>);
+}
+
+TEST_CASE("Sensor counts are checked against the inline storage",
+          "[metadata]") {
+  auto five_sensors = std::string{"PLAYER,A,Nick Gertje,13,14,97,98,99\n"};
+  REQUIRE_THROWS_AS(game::parse_metadata_string(metadata + five_sensors),
+                    std::length_error);
+
+  auto balls = std::string{};
+  for (int sid = 200; sid < 200 + static_cast<int>(game::max_ball_sensors);
+       ++sid) {
+    balls += fmt::format("BALL,1,{}\n", sid);
+  }
+  REQUIRE_NOTHROW(game::parse_metadata_string(balls));
+  REQUIRE_THROWS_AS(game::parse_metadata_string(balls + "BALL,1,300\n"),
+                    std::length_error);
+}
@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include "event_fetcher.hpp"
+#include "game_statistics.hpp"
+#include "partials_archive.hpp"
+#include "test_dataset.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fmt/format.h"
+
+TEST_CASE("Partial statistics archive") {
+  auto path =
+      std::filesystem::temp_directory_path() / "test_partials_archive.bin";
+
+  SECTION("Periods read back as appended") {
+    auto names = std::vector<std::string>{"Nick Gertje", "Leon Krapf"};
+    auto nb_periods = game::PartialsArchiveWriter::initial_periods * 3 + 1;
+    {
+      auto writer = game::PartialsArchiveWriter{path, names, 3.0, 60};
+      for (std::size_t p = 0; p < nb_periods; ++p) {
+        auto shares = std::vector<float>{p * 0.5f, 1.0f};
+        writer.append(shares.data());
+      }
+      REQUIRE(writer.get_nb_periods() == nb_periods);
+
+      // Appended periods are visible while the archive is written
+      auto archive = game::PartialsArchive{path};
+      REQUIRE(archive.get_nb_periods() == nb_periods);
+    }
+
+    auto archive = game::PartialsArchive{path};
+    REQUIRE(std::filesystem::file_size(path) ==
+            game::PartialsArchiveLayout::rows_offset(names.size()) +
+                nb_periods * names.size() * sizeof(float));
+    REQUIRE(archive.get_player_names() == names);
+    REQUIRE(archive.get_maximum_distance() == 3.0);
+    REQUIRE(archive.get_time_units() == 60);
+    REQUIRE(archive.get_nb_periods() == nb_periods);
+    for (auto p : {std::size_t{0}, std::size_t{7}, nb_periods - 1}) {
+      REQUIRE(archive.get_period(p)[0] == p * 0.5f);
+      REQUIRE(archive.get_period(p)[1] == 1.0f);
+    }
+    REQUIRE_THROWS_AS(archive.get_period(nb_periods), std::out_of_range);
+  }
+
+  SECTION("Game statistics archive their partial statistics") {
+    using namespace std::chrono_literals;
+
+    // Over 3 periods of 1 second, the ball is at Nick Gertje in the even ones
+    // and at Leon Krapf in the odd ones
+    auto event = [](int sid, std::chrono::picoseconds ts, int x) {
+      return fmt::format("SE,{},{},{},0,0,0,0,0,0,0,0,0,0\n", sid,
+                         (game::game_start + ts).count(), x);
+    };
+    auto dataset = std::string{};
+    for (int period = 0; period < 3; ++period) {
+      auto ts = std::chrono::picoseconds{period * 1s + 100ms};
+      for (auto sid : {13, 14, 97, 98}) {
+        dataset += event(sid, ts, 10000);
+      }
+      for (auto sid : {61, 62, 99, 100}) {
+        dataset += event(sid, ts, 40000);
+      }
+      for (int i = 1; i <= 3; ++i) {
+        dataset += event(4, ts + i * 100ms, period % 2 == 0 ? 10000 : 40000);
+      }
+    }
+
+    auto context = game::Context::build_from(metadata);
+    auto fetcher =
+        game::EventFetcher{dataset, game::string_stream{}, 1, 100, context};
+    auto stats =
+        game::GameStatistics{game::GameStatistics::infinite_distance, context};
+
+    // Periods over before the archive is set are archived as well
+    auto batch = fetcher.parse_batch();
+    stats.accumulate_stats(batch);
+    REQUIRE(batch.is_period_last_batch);
+    stats.set_archive(path);
+    for (auto const &batch : fetcher) {
+      stats.accumulate_stats(batch);
+    }
+    REQUIRE(stats.get_nb_partials() == 3);
+
+    auto const &names = stats.get_player_names();
+    auto nick = std::find(names.cbegin(), names.cend(), "Nick Gertje");
+    auto leon = std::find(names.cbegin(), names.cend(), "Leon Krapf");
+    auto archive = game::PartialsArchive{path};
+    REQUIRE(archive.get_player_names() == names);
+    REQUIRE(archive.get_nb_periods() == 3);
+    for (std::size_t p = 0; p < 3; ++p) {
+      auto const *shares = archive.get_period(p);
+      REQUIRE(std::vector<float>(shares, shares + names.size()) ==
+              std::vector<float>(stats.get_partial(p),
+                                 stats.get_partial(p) + names.size()));
+      auto owner = p % 2 == 0 ? nick : leon;
+      REQUIRE(shares[owner - names.cbegin()] == 1.0f);
+    }
+    REQUIRE(stats.last_partial() ==
+            std::unordered_map<std::string, double>{{"Nick Gertje", 1.0}});
+  }
+  std::filesystem::remove(path);
+}
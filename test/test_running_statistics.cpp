@@ -0,0 +1,125 @@
+#include "catch.hpp"
+
+#include "batch_operator.hpp"
+#include "context.hpp"
+#include "event.hpp"
+#include "event_fetcher.hpp"
+#include "running_statistics.hpp"
+#include "test_dataset.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "fmt/format.h"
+
+namespace {
+/**
+ * Over 3 seconds from game start, a sensor of Nick Gertje sends an event every
+ * 10 ms, at 2 m/s over the first second, 5 m/s over the second one and 8 m/s
+ * over the third one. A sensor of Leon Krapf sends two events 2 seconds apart.
+ */
+std::string accelerating_dataset() {
+  using namespace std::chrono_literals;
+
+  auto event = [](int sid, std::chrono::picoseconds ts, int speed) {
+    return fmt::format("SE,{},{},0,0,0,{},0,0,0,0,0,0,0\n", sid,
+                       (game::game_start + ts).count(), speed);
+  };
+  auto dataset = event(61, 0s, 9000000);
+  for (int i = 0; i < 300; ++i) {
+    auto speed = i < 100 ? 2000000 : i < 200 ? 5000000 : 8000000;
+    dataset += event(13, i * 10ms, speed);
+  }
+  dataset += event(61, 2s, 9000000);
+  return dataset;
+}
+} // namespace
+
+TEST_CASE("Running distance and time in speed bands") {
+  using namespace std::chrono_literals;
+  using namespace std::string_literals;
+  using Stats = game::RunningStatistics;
+
+  SECTION("Speeds are parsed on demand") {
+    auto line = "SE,13,10753295594424116,1,2,3,4500000,0,0,0,0,0,0,0"s;
+    auto event = std::get<game::PositionEvent>(
+        game::parse_event_line(line, game::parser_custom{true}));
+    REQUIRE(event.get_speed() == 4500000);
+    event = std::get<game::PositionEvent>(
+        game::parse_event_line(line, game::parser_custom{}));
+    REQUIRE(event.get_speed() == 0);
+  }
+
+  SECTION("Speeds fall into bands") {
+    REQUIRE(Stats::speed_band(0) == 0);
+    REQUIRE(Stats::speed_band(277777) == 0);
+    REQUIRE(Stats::speed_band(277778) == 1);
+    REQUIRE(Stats::speed_band(4000000) == 3);
+    REQUIRE(Stats::speed_band(6666666) == 4);
+    REQUIRE(Stats::speed_band(6666667) == 5);
+  }
+
+  SECTION("Intervals are counted over the periods of each T") {
+    auto context = game::Context::build_from(metadata);
+    auto fetcher = game::EventFetcher{accelerating_dataset(),
+                                      game::string_stream{}, 1, 16, context};
+    fetcher.set_speed_parsing(true);
+    auto os = std::ostringstream{};
+    auto running = Stats{{1, 3}, 1, context, os};
+    auto pipeline = game::OperatorPipeline{};
+    pipeline.add(running);
+
+    auto const &names = running.get_player_names();
+    auto nick = static_cast<std::size_t>(
+        std::find(names.cbegin(), names.cend(), "Nick Gertje") -
+        names.cbegin());
+    auto leon = static_cast<std::size_t>(
+        std::find(names.cbegin(), names.cend(), "Leon Krapf") -
+        names.cbegin());
+
+    // The interval to the event opening the next period counts in that one
+    auto expected = std::vector<std::pair<double, std::size_t>>{
+        {0.99 * 2, 1}, {0.01 * 2 + 0.99 * 5, 4}, {0.01 * 5 + 0.99 * 8, 5}};
+    std::size_t nb_periods = 0;
+    for (auto const &batch : fetcher) {
+      pipeline.on_batch(batch);
+      if (!batch.is_period_last_batch) {
+        continue;
+      }
+      REQUIRE(running.is_period_over(0));
+      auto const &period = running.last_period(nick, 0);
+      REQUIRE(period.distance ==
+              Approx(expected[nb_periods].first).epsilon(1e-9));
+      auto band = expected[nb_periods].second;
+      REQUIRE(std::chrono::duration<double>(period.band_times[band]).count() ==
+              Approx(0.99).epsilon(1e-9));
+      REQUIRE(running.is_period_over(1) == (nb_periods == 2));
+      ++nb_periods;
+    }
+    pipeline.on_game_end();
+    REQUIRE(nb_periods == 3);
+
+    auto const &game = running.game_stats(nick);
+    REQUIRE(game.distance == Approx(14.92).epsilon(1e-9));
+    REQUIRE(game.band_times[1] == std::chrono::seconds{1});
+    REQUIRE(game.band_times[4] == std::chrono::seconds{1});
+    REQUIRE(game.band_times[5] == std::chrono::milliseconds{990});
+    REQUIRE(running.last_period(nick, 1).distance == Approx(14.92));
+    // Intervals longer than max_interval are not counted
+    REQUIRE(running.game_stats(leon).distance == 0);
+
+    auto output = os.str();
+    REQUIRE(output.find("Running statistics, T = 1 s, period 3") !=
+            std::string::npos);
+    REQUIRE(output.find("Running statistics, T = 3 s, period 1") !=
+            std::string::npos);
+    REQUIRE(output.find("Running statistics, whole game") !=
+            std::string::npos);
+  }
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include "context.hpp"
+#include "event.hpp"
+#include "sharding.hpp"
+#include "soccer_monitoring.hpp"
+#include "test_dataset.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "fmt/format.h"
+
+TEST_CASE("Time shards merge into the statistics of the whole stream") {
+  using namespace std::chrono_literals;
+  namespace fs = std::filesystem;
+
+  auto game_data = fs::temp_directory_path() / "test_sharding_stream";
+  auto metadata_path = fs::temp_directory_path() / "test_sharding_metadata";
+  std::ofstream{game_data} << swapping_sides_dataset();
+  std::ofstream{metadata_path} << metadata;
+  auto context = game::Context::build_from(metadata);
+
+  SECTION("Shards split the periods and lead in through pauses") {
+    auto shards = game::plan_shards(game_data, context, 1, 3, 1s);
+    REQUIRE(shards.size() == 3);
+    REQUIRE(shards[0].begin == game::game_start);
+    REQUIRE(shards[0].offset == 0);
+    REQUIRE(shards[0].end == game::game_start + 2s);
+    REQUIRE(shards[1].begin == game::game_start + 2s);
+    REQUIRE(shards[1].period_start == game::game_start);
+    REQUIRE(shards[1].end == game::game_start + 5s);
+    REQUIRE(shards[2].begin == game::game_start + 5s);
+    REQUIRE(shards[2].end == std::chrono::picoseconds::max());
+    // The pause does not count in the lead-in
+    REQUIRE(shards[2].period_start == game::game_start + 1s);
+    REQUIRE_FALSE(shards[2].is_paused);
+
+    auto is = std::ifstream{game_data};
+    is.seekg(static_cast<std::streamoff>(shards[1].offset));
+    auto line = std::string{};
+    std::getline(is, line);
+    REQUIRE(line.rfind(fmt::format("SE,13,{},", (game::game_start + 1100ms)
+                                                    .count()),
+                       0) == 0);
+
+    auto no_lead_in = game::plan_shards(game_data, context, 1, 3, 0s);
+    REQUIRE(no_lead_in[2].period_start == game::game_start + 4s);
+    REQUIRE(no_lead_in[2].is_paused);
+
+    for (auto const &shard : shards) {
+      auto parsed = game::parse_shard(game::to_string(shard));
+      REQUIRE(parsed);
+      REQUIRE(parsed->begin == shard.begin);
+      REQUIRE(parsed->end == shard.end);
+      REQUIRE(parsed->offset == shard.offset);
+      REQUIRE(parsed->period_start == shard.period_start);
+      REQUIRE(parsed->is_paused == shard.is_paused);
+    }
+    REQUIRE_FALSE(game::parse_shard("1,2,3,4"));
+    REQUIRE_FALSE(game::parse_shard("1,2,3,4,2"));
+  }
+
+  SECTION("Worker processes compute the periods of the whole stream") {
+    auto options = game::MonitoringOptions{};
+    options.time_units = {1, 2};
+    options.maximum_distances = {1, 3};
+    options.game_data = game_data;
+    options.metadata = metadata_path;
+    options.nb_threads = 2;
+    options.batch_size = 4;
+    options.window_lengths = {3};
+    options.worker_command = {SOCCER_MONITORING_EXECUTABLE};
+    options.shard_lead_in = 1s;
+
+    auto monitor = [&options](std::size_t nb_shards) {
+      auto context = game::Context::build_from(options.metadata);
+      auto os = std::ostringstream{};
+      auto sharded_options = options;
+      sharded_options.nb_shards = nb_shards;
+      game::details::run_game_monitoring(sharded_options, context, os);
+      return os.str();
+    };
+    auto whole_stream = monitor(1);
+    REQUIRE(monitor(3) == whole_stream);
+    REQUIRE(monitor(8) == whole_stream);
+
+    // Without lead-in, the last shard misses where the players stand
+    options.shard_lead_in = 0s;
+    REQUIRE(monitor(3) != whole_stream);
+  }
+
+  SECTION("A failing worker fails the monitoring") {
+    auto options = game::MonitoringOptions{};
+    options.time_units = {1};
+    options.maximum_distances = {3};
+    options.game_data = game_data;
+    options.metadata = metadata_path;
+    options.nb_threads = 1;
+    options.nb_shards = 2;
+    options.worker_command = {"false"};
+
+    auto context = game::Context::build_from(options.metadata);
+    auto os = std::ostringstream{};
+    REQUIRE_THROWS_AS(game::details::run_game_monitoring(options, context, os),
+                      std::runtime_error);
+  }
+  fs::remove(game_data);
+  fs::remove(metadata_path);
+}
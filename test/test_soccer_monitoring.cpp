@@ -0,0 +1,91 @@
+#include "catch.hpp"
+
+#include "context.hpp"
+#include "soccer_monitoring.hpp"
+#include "test_dataset.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+TEST_CASE("Periods computed concurrently match batch-parallel monitoring") {
+  namespace fs = std::filesystem;
+
+  auto game_data = fs::temp_directory_path() / "test_period_parallel_stream";
+  std::ofstream{game_data} << swapping_sides_dataset();
+
+  auto options = game::MonitoringOptions{};
+  options.time_units = {1, 2};
+  options.maximum_distances = {1, 3};
+  options.game_data = game_data;
+  options.batch_size = 4;
+  auto monitor = [&options](bool period_parallel, int nb_threads) {
+    auto context = game::Context::build_from(metadata);
+    auto os = std::ostringstream{};
+    auto monitored_options = options;
+    monitored_options.period_parallel = period_parallel;
+    monitored_options.nb_threads = nb_threads;
+    game::details::run_game_monitoring(monitored_options, context, os);
+    return os.str();
+  };
+  auto batch_parallel = monitor(false, 2);
+  REQUIRE(monitor(true, 1) == batch_parallel);
+  REQUIRE(monitor(true, 4) == batch_parallel);
+
+  // More periods than 2 * #threads are pending while the stream is read
+  options.batch_size = 1;
+  options.time_units = {1};
+  REQUIRE(monitor(true, 2) == monitor(false, 2));
+  fs::remove(game_data);
+}
+
+TEST_CASE("Resuming appends to the timeline and archive") {
+  namespace fs = std::filesystem;
+
+  auto directory = fs::temp_directory_path();
+  auto game_data = directory / "test_resume_stream";
+  std::ofstream{game_data} << swapping_sides_dataset();
+
+  auto options = game::MonitoringOptions{};
+  options.time_units = {1};
+  options.maximum_distances = {3};
+  options.game_data = game_data;
+  options.nb_threads = 1;
+  options.batch_size = 4;
+  options.checkpoint_path = directory / "test_resume.checkpoint";
+  options.checkpoint_periods = 3;
+  options.timeline_path = directory / "test_resume_timeline.csv";
+  options.archive_path = directory / "test_resume.archive";
+  auto monitor = [&options] {
+    auto context = game::Context::build_from(metadata);
+    auto os = std::ostringstream{};
+    game::details::run_game_monitoring(options, context, os);
+    return os.str();
+  };
+  auto read = [](fs::path const &path) {
+    auto is = std::ifstream{path, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{is}, {}};
+  };
+
+  // The whole run leaves its last checkpoint behind, as a crash would after
+  // writing the outputs past it
+  fs::remove(options.checkpoint_path);
+  monitor();
+  auto timeline = read(options.timeline_path);
+  auto archive = read(options.archive_path);
+  REQUIRE(fs::exists(options.checkpoint_path));
+  REQUIRE(std::count(timeline.cbegin(), timeline.cend(), '\n') > 3);
+
+  options.resume = true;
+  monitor();
+  REQUIRE(read(options.timeline_path) == timeline);
+  REQUIRE(read(options.archive_path) == archive);
+
+  for (auto const &path : {game_data, options.checkpoint_path,
+                           options.timeline_path, options.archive_path}) {
+    fs::remove(path);
+  }
+}
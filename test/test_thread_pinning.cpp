@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "details/line_reader.hpp"
+#include "details/work_stealing_pool.hpp"
+#include "thread_pinning.hpp"
+
+#include <atomic>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Parse thread pinning", "[thread_pinning]") {
+  REQUIRE(game::parse_thread_pinning("none").policy == game::PinPolicy::none);
+  REQUIRE(game::parse_thread_pinning("compact").policy ==
+          game::PinPolicy::compact);
+  REQUIRE(game::parse_thread_pinning("spread").policy ==
+          game::PinPolicy::spread);
+
+  auto list = game::parse_thread_pinning("0,2,4-6");
+  REQUIRE(list.policy == game::PinPolicy::list);
+  REQUIRE(list.cpus == std::vector<int>{0, 2, 4, 5, 6});
+
+  REQUIRE_THROWS_AS(game::parse_thread_pinning("close"), std::invalid_argument);
+  REQUIRE_THROWS_AS(game::parse_thread_pinning("3-1"), std::invalid_argument);
+  REQUIRE_THROWS_AS(game::parse_thread_pinning("1,,2"), std::invalid_argument);
+}
+
+TEST_CASE("Assign threads to CPUs", "[thread_pinning]") {
+  // Two sockets of two cores with two hyper-threads each. Hyper-threads of a
+  // core are numbered as on most Linux hosts, i.e. apart.
+  auto cpus = std::vector<game::Cpu>{{0, 0, 0}, {1, 0, 1}, {2, 1, 0},
+                                     {3, 1, 1}, {4, 0, 0}, {5, 0, 1},
+                                     {6, 1, 0}, {7, 1, 1}};
+
+  SECTION("Compact") {
+    auto pinning = game::ThreadPinning{game::PinPolicy::compact, {}};
+    REQUIRE(game::assign_cpus(pinning, cpus, 4) ==
+            std::vector<int>{0, 4, 1, 5});
+  }
+
+  SECTION("Spread") {
+    auto pinning = game::ThreadPinning{game::PinPolicy::spread, {}};
+    REQUIRE(game::assign_cpus(pinning, cpus, 6) ==
+            std::vector<int>{0, 2, 1, 3, 4, 6});
+  }
+
+  SECTION("List") {
+    auto pinning = game::ThreadPinning{game::PinPolicy::list, {3, 1}};
+    REQUIRE(game::assign_cpus(pinning, cpus, 3) == std::vector<int>{3, 1, 3});
+  }
+
+  SECTION("None") {
+    REQUIRE(game::assign_cpus({}, cpus, 4).empty());
+  }
+}
+
+TEST_CASE("Bind helper threads as they start", "[thread_pinning]") {
+  auto cpu = game::available_cpus().front().id;
+  auto pin_workers = [cpu](std::thread &thread, std::size_t) {
+    game::pin_thread(thread.native_handle(), {cpu});
+  };
+
+  SECTION("Work-stealing workers") {
+    auto pool = game::details::WorkStealingPool{3, pin_workers};
+    auto nb_bound = std::atomic<int>{0};
+    auto tasks = std::vector<std::size_t>{0, 1, 2, 3, 4, 5};
+    pool.run(tasks, tasks.size(), [&](std::size_t, std::size_t) {
+      auto set = cpu_set_t{};
+      CPU_ZERO(&set);
+      sched_getaffinity(0, sizeof(set), &set);
+      if (CPU_COUNT(&set) == 1 && CPU_ISSET(cpu, &set)) {
+        ++nb_bound;
+      }
+    });
+    REQUIRE(nb_bound == static_cast<int>(tasks.size()));
+  }
+
+  SECTION("Stream readers") {
+    auto nb_started = 0;
+    auto reader = game::details::LineReader{
+        std::make_unique<std::istringstream>("a\nb\n"),
+        [&](std::thread &thread) {
+          game::pin_thread(thread.native_handle(), {cpu});
+          ++nb_started;
+        }};
+    REQUIRE(nb_started == 1);
+  }
+
+  SECTION("Threads are stopped if they cannot be bound") {
+    auto fail = [](std::thread &, std::size_t) {
+      throw std::runtime_error{"Cannot bind"};
+    };
+    REQUIRE_THROWS_AS((game::details::WorkStealingPool{3, fail}),
+                      std::runtime_error);
+    REQUIRE_THROWS_AS(game::pin_thread(pthread_self(), {CPU_SETSIZE}),
+                      std::runtime_error);
+  }
+}